@@ -10,11 +10,20 @@ typedef enum{
     //OBJ_TYPE = 2,
 } PartType;
 
+// Entornos incluidos; otros se registran en physics/env.h y toman ids
+// a continuación
 typedef enum {
     ENV_BOX = 0,
     ENV_SPHERE = 1,
+    ENV_PERIODIC = 2,
 } EnvType;
 
+// Broadphase del solver de colisiones
+typedef enum {
+    BROADPHASE_GRID = 0,   // grilla uniforme (physics/grid.h)
+    BROADPHASE_SWEEP = 1,  // barrido y poda (physics/sweep.h)
+} BroadphaseType;
+
 typedef struct {
     unsigned int RENDER_PARTICLES;
     unsigned int INIT_PARTICLES;
@@ -26,12 +35,35 @@ typedef struct {
     float PARTICLE_RADIUS;
     float ENV_SIZE;
     unsigned int ENV_DIV;
-    EnvType ENV_TYPE;
+    int ENV_TYPE;                    // id de entorno (EnvType o registrado)
     PartType PARTICLE_TYPE;
+    unsigned int SOLVER_ITERATIONS;  // tope de pasadas del solver de colisiones
+    float SOLVER_TOLERANCE;          // penetración máxima aceptada para cortar antes
+    float RESTITUTION;               // coeficiente de restitución entre partículas
+    float WARM_START;                // fracción de la corrección del paso anterior (0 = apagado)
+    unsigned int SOLVER_TILE;        // celdas por lado de las teselas del solver (0 = sin teselas)
+    unsigned int TASK_THREADS;       // hilos extra para integrar y armar la grilla (0 = sin hilos)
+    unsigned int CONSTRAINT_ITERATIONS; // pasadas por paso sobre las restricciones de distancia
+    float GRAVITY_G;                 // gravedad entre partículas, Barnes-Hut (0 = apagada)
+    float GRAVITY_THETA;             // ángulo de apertura del octree (0 = suma directa)
+    float GRAVITY_SOFTENING;         // suavizado de la gravedad, en radios (0 = sin suavizar)
+    unsigned int HISTORY_MB;         // memoria del historial para rebobinar (0 = apagado)
+    unsigned int HISTORY_KEYFRAME;   // frames entre estados completos del historial
+    unsigned int PROXY_FRAMES;       // pasos quieta antes de unirse en un proxy (0 = apagado)
+    float PROXY_DRIFT;               // cuánto (en radios) se mueve una partícula quieta
+    float PROXY_DISTANCE;            // a menos de esto de la cámara no hay proxies
+    unsigned int MULTIRATE_LEVELS;   // niveles de paso por región (1 = paso único)
+    float MULTIRATE_CFL;             // desplazamiento máximo por subpaso, en radios
+    unsigned int COMPACT_STATE;      // archivos de --stream en formato compacto (0 = float)
+    unsigned int DIMENSIONS;         // 3, o 2 para la simulación plana (planar.h)
+    unsigned int EVENT_DRIVEN;       // dinámica por eventos para gases diluidos (events.h)
+    BroadphaseType BROADPHASE;       // GRID o SWEEP: cómo se buscan los pares en contacto
 } Config;
 
 void trim(char* str);
 int load_config(Config* cfg, const char* filename);
+// Asigna una clave; devuelve 0 si la clave no existe
+int config_set(Config* cfg, const char* key, const char* value);
 void print_config(const Config* cfg);
 
 #endif
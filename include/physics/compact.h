@@ -0,0 +1,41 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdint.h>
+#include "core/config.h"
+#include "physics/physics.h"
+
+// Formato compacto del estado para guardarlo o recorrerlo en bloque (20
+// bytes por partícula en vez de 28):
+//   - posición en punto fijo de 32 bits dentro de los límites del entorno
+//   - desplazamiento del último paso (current - previus) en half float
+//   - radio como índice en una tabla de tipos
+// Se decodifica a Particles para integrar y resolver contactos.
+#define COMPACT_MAX_TYPES 16
+
+typedef struct {
+    int32_t  pos[3];
+    uint16_t step[3];
+    uint16_t type;
+} CompactParticle;
+
+typedef struct {
+    float center[3];
+    float quantum;                    // largo de una unidad del punto fijo
+    float radii[COMPACT_MAX_TYPES];
+    int32_t typeCount;
+} CompactFormat;
+
+// Escala para los límites del entorno de cfg (con margen para lo que se
+// sale durante un paso) y tabla de tipos vacía
+int  compact_format_init(CompactFormat* fmt, const Config* cfg);
+// Tipo de un radio; lo agrega a la tabla si no está. -1 si está llena.
+int  compact_type(CompactFormat* fmt, float radius);
+// Devuelve 0 si algún radio no entra en la tabla
+int  compact_encode(CompactFormat* fmt, const Particles* p, int64_t count, CompactParticle* out);
+void compact_decode(const CompactFormat* fmt, const CompactParticle* in, int64_t count, Particles* out);
+
+uint16_t float_to_half(float f);
+float    half_to_float(uint16_t h);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef CONSTRAINTS_H
+#define CONSTRAINTS_H
+
+#include "physics/physics.h"
+#include "physics/tasks.h"
+
+// Restricciones de distancia sobre el integrador Verlet (sogas, telas,
+// cuerpos blandos): cada arista corrige las posiciones de sus dos
+// partículas hacia su largo de reposo, repartiendo por masa (r³) como los
+// contactos. La velocidad sale sola de la diferencia con previus.
+//
+// Las aristas se colorean para que dos del mismo color no compartan
+// partícula: un color se puede resolver en cualquier orden (o en
+// paralelo) y da siempre lo mismo. Se guardan ordenadas por color.
+
+#define CONSTRAINT_MAX_COLORS 64   // las aristas que no entran van al último lote, en serie
+#define CONSTRAINT_CHUNK      8192 // aristas por tarea
+
+typedef struct {
+    int   a, b;
+    float rest;       // largo de reposo
+    float stiffness;  // fracción de la corrección por iteración (0 .. 1)
+} DistanceEdge;
+
+typedef struct {
+    int   index;
+    vec3  position;
+} ConstraintPin;
+
+typedef struct {
+    DistanceEdge* edges;
+    int count;
+    int capacity;
+
+    // lote de cada color: edges[colorStart[c] .. colorStart[c + 1])
+    int colorStart[CONSTRAINT_MAX_COLORS + 2];
+    int colors;       // colores en paralelo; el lote colors (si no está vacío) va en serie
+    int dirty;        // hay aristas sin colorear
+
+    ConstraintPin* pins;
+    int pinCount;
+    int pinCapacity;
+    unsigned char* pinned;  // por partícula, para no mover las fijas
+    int pinnedCapacity;
+} ConstraintSet;
+
+// Agrega una arista entre a y b; con rest < 0 el largo es la distancia
+// actual. Devuelve 0 sin memoria o con índices inválidos.
+int  constraint_add(ConstraintSet* set, const Particles* p, int count,
+                    int a, int b, float rest, float stiffness);
+// Fija la partícula i en su posición actual
+int  constraint_pin(ConstraintSet* set, const Particles* p, int i);
+// Quita aristas y pines de partículas desde count en adelante
+void constraint_truncate(ConstraintSet* set, int count);
+void constraint_free(ConstraintSet* set);
+
+// iterations pasadas sobre todas las aristas, los colores en orden y cada
+// color repartido en tareas de pool (NULL: en este hilo). Al final las
+// fijas vuelven a su lugar sin velocidad. Con la grilla armada en un
+// dominio periódico los largos son de imagen mínima. Devuelve 0 sin
+// memoria.
+int  constraint_solve(ConstraintSet* set, Particles* p, int count, int iterations,
+                      TaskPool* pool);
+// Estiramiento relativo máximo |largo - reposo| / reposo
+float constraint_max_strain(const ConstraintSet* set, const Particles* p);
+
+#endif
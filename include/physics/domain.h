@@ -0,0 +1,37 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+
+#define MAX_DOMAIN_WORKERS 64
+#define DOMAIN_BALANCE_BINS 1024
+
+// Descomposición del dominio en franjas a lo largo de x, una por proceso.
+// Cada paso los procesos publican en memoria compartida las partículas que
+// cambiaron de dueño y las que están a menos de un halo (2 radios) de su
+// borde; los vecinos las usan como fantasmas en el solver.
+typedef struct {
+    int workers;
+    int steps;
+    int balanceInterval;  // pasos entre rebalanceos (0 = cortes fijos)
+    float dt;
+} DomainOptions;
+
+typedef struct {
+    int owned;            // partículas propias al terminar
+    int ghosts;           // fantasmas del último paso
+    long migratedIn;      // partículas recibidas de otros procesos
+    float cutMin, cutMax; // franja final
+    double seconds;
+} DomainWorkerStats;
+
+// Reparte count partículas entre opts->workers procesos hijos, avanza
+// opts->steps pasos y devuelve el estado final en particles (agrupado por
+// dueño). stats debe tener lugar para opts->workers entradas.
+int domain_run(const Config* cfg, const ForceFieldSet* forces,
+               Particles* particles, int count,
+               const DomainOptions* opts, DomainWorkerStats* stats);
+
+#endif
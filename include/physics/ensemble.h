@@ -0,0 +1,52 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+
+#define MAX_ENSEMBLE_WORKERS 64
+
+// Varias simulaciones independientes en un mismo arreglo de partículas.
+// Cada instancia ocupa un rango contiguo y tiene sus propios parámetros
+// (radio, gravedad, restitución, entorno) y su caché de contactos; todas
+// se avanzan con los mismos kernels que la simulación principal.
+typedef struct {
+    Config config;
+    ForceFieldSet forces;
+    ContactCache contacts;
+    int begin;             // primera partícula en el arreglo compartido
+    int count;
+    int solverIterations;  // pasadas del último paso
+} EnsembleInstance;
+
+typedef struct {
+    Particles* particles;
+    int used;
+    int capacity;
+    EnsembleInstance* instances;
+    int instanceCount;
+    int instanceCapacity;
+    double seconds;        // tiempo de pared del último ensemble_run
+} Ensemble;
+
+void ensemble_init(Ensemble* ens);
+void ensemble_free(Ensemble* ens);
+// Agrega una instancia de count partículas con posiciones del entorno de
+// cfg. Devuelve su índice o -1.
+int  ensemble_add(Ensemble* ens, const Config* cfg, int count);
+// Archivo de barrido: cada "INSTANCE = n" abre una instancia de n
+// partículas que parte de base; las claves que siguen la modifican.
+// Devuelve 0 si no pudo abrirlo, si no hay instancias o si alguna no se
+// pudo agregar.
+int  ensemble_load(Ensemble* ens, const Config* base, const char* filename);
+void ensemble_step(Ensemble* ens, float dt);
+// Avanza steps pasos repartiendo las instancias (por cantidad de
+// partículas) entre workers procesos hijos; workers <= 0 usa uno por CPU.
+// Procesos y no hilos: el solver trabaja sobre la grilla global. Cada
+// instancia da lo mismo que con ensemble_step. Devuelve 0 si falló algún
+// proceso; las partículas quedan entonces como estaban.
+int  ensemble_run(Ensemble* ens, float dt, int steps, int workers);
+void ensemble_print_stats(const Ensemble* ens);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PHYSICS_ENV_H
+#define PHYSICS_ENV_H
+
+#include <cglm/cglm.h>
+#include "core/config.h"
+#include "physics/physics.h"
+
+#define MAX_ENVIRONMENTS 16
+
+// Interfaz de un entorno (contenedor). Para agregar una forma nueva alcanza
+// con completar una de estas y llamar a env_register() antes de cargar la
+// configuración; el loop principal no cambia.
+typedef struct {
+    const char* name;  // valor de ENV_TYPE en config.txt
+    int periodic;      // la grilla de colisiones da la vuelta en bounds
+
+    // Colisión contra el contenedor de un rango contiguo de partículas
+    void (*collide)(const Config* cfg, Particles* p, int count);
+    // Caja que contiene al entorno (tamaño de grilla, dominio periódico)
+    void (*bounds)(const Config* cfg, vec3 min, vec3 max);
+    // Posición inicial aleatoria dentro del entorno
+    void (*spawn)(const Config* cfg, vec3 out);
+
+    // Render: los completa el módulo de render, pueden quedar en NULL
+    void (*init)(const Config* cfg);
+    void (*render)(const Config* cfg);
+} EnvInterface;
+
+int env_register(const EnvInterface* env);  // devuelve el id (ENV_TYPE)
+int env_find(const char* name);             // -1 si no existe
+int env_count(void);
+const EnvInterface* env_get(int id);        // NULL si el id no existe
+void env_set_render(int id, void (*init)(const Config*), void (*render)(const Config*));
+
+// Entornos incluidos
+void collide_box(const Config* cfg, Particles* p, int count);
+void collide_sphere(const Config* cfg, Particles* p, int count);
+void collide_periodic(const Config* cfg, Particles* p, int count);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+
+// Dinámica molecular por eventos (esferas duras) para sistemas diluidos.
+// Entre eventos cada partícula sigue su trayectoria exacta (recta, o
+// parábola con aceleración uniforme); los eventos son choques entre pares,
+// contra el entorno y cruces de celda, y se procesan en orden de tiempo
+// con una cola de prioridad. Cada partícula guarda su estado en el tiempo
+// de su último evento y sólo se avanza cuando participa de otro, así que
+// el costo es proporcional a la cantidad de choques y no a pasos por N.
+//
+// Los eventos viejos no se borran de la cola: cada partícula cuenta sus
+// eventos y uno cuyo contador no coincide se descarta al sacarlo.
+//
+// Entornos: caja, esfera y periódico. Sólo campos de fuerza uniformes.
+// En pilas apoyadas los choques se vuelven muy frecuentes: al pasar el
+// tope de eventos la simulación vuelve al paso fijo.
+#define EVENT_MAX_PER_PARTICLE 20   // tope de eventos por partícula y avance
+#define EVENT_TC 1e-5               // choques más seguidos que esto son elásticos
+
+typedef struct EventSim EventSim;
+
+// Toma el estado de p (velocidad (current - previus) / dt). NULL si el
+// entorno o los campos de fuerza no se pueden tratar por eventos.
+EventSim* event_sim_create(const Config* cfg, const ForceFieldSet* forces,
+                           const Particles* p, int count, float dt);
+void      event_sim_destroy(EventSim* sim);
+// Procesa los eventos hasta dt más adelante; devuelve cuántos procesó, o
+// -1 si pasó el tope o se quedó sin memoria para la cola (el estado queda
+// donde llegó)
+long      event_sim_advance(EventSim* sim, double dt);
+// Escribe el estado actual en p; previus queda un paso dt atrás
+void      event_sim_export(EventSim* sim, Particles* p, float dt);
+double    event_sim_time(const EventSim* sim);
+
+#endif
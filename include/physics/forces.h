@@ -0,0 +1,58 @@
+#ifndef FORCES_H
+#define FORCES_H
+
+#include <cglm/cglm.h>
+#include "core/config.h"
+
+#define MAX_FORCE_FIELDS 16
+
+typedef enum {
+    FORCE_UNIFORM   = 0,  // aceleración constante (gravedad)
+    FORCE_ATTRACTOR = 1,  // atracción hacia un punto, 1/r² suavizado
+    FORCE_VORTEX    = 2,  // giro alrededor de un eje
+    FORCE_DRAG      = 3,  // freno proporcional a la velocidad, por eje
+    FORCE_GRID      = 4,  // campo vectorial muestreado en una grilla 3D
+} ForceType;
+
+// Campo vectorial muestreado: data[(z * ny + y) * nx + x]
+typedef struct {
+    int  dims[3];
+    vec3 min;
+    vec3 max;
+    vec3* data;
+} VectorGrid;
+
+typedef struct {
+    ForceType type;
+    vec3  vector;    // UNIFORM: aceleración, ATTRACTOR/VORTEX: centro, DRAG: coeficientes
+    vec3  axis;      // VORTEX: eje de giro (normalizado)
+    float strength;  // ATTRACTOR/VORTEX/GRID: intensidad
+    float radius;    // ATTRACTOR/VORTEX: radio de suavizado
+    const VectorGrid* grid;
+} ForceField;
+
+// Bloque de parámetros que lee el integrador. Es chico y compartido por
+// todas las partículas; la aceleración por partícula sólo existe si algún
+// escenario la pide (particleAcceleration != NULL).
+typedef struct {
+    int count;
+    ForceField fields[MAX_FORCE_FIELDS];
+    vec3* particleAcceleration;
+} ForceFieldSet;
+
+void force_fields_clear(ForceFieldSet* set);
+int  force_fields_add(ForceFieldSet* set, const ForceField* field);
+// Sólo la gravedad de cfg->ACCELERATION
+void force_fields_from_config(ForceFieldSet* set, const Config* cfg);
+// Gravedad desde cfg->ACCELERATION más las claves ATTRACTOR, VORTEX, DRAG y
+// FORCE_GRID del archivo (pueden repetirse)
+int  force_fields_load(ForceFieldSet* set, const Config* cfg, const char* filename);
+// Verdadero si todos los campos son uniformes (no dependen de la partícula)
+int  force_fields_uniform(const ForceFieldSet* set, vec3 out);
+void force_fields_eval(const ForceFieldSet* set, const vec3 pos, const vec3 vel, vec3 out);
+
+int  vector_grid_load(VectorGrid* grid, const char* path);
+void vector_grid_sample(const VectorGrid* grid, const vec3 pos, vec3 out);
+void vector_grid_free(VectorGrid* grid);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef GRAVITY_H
+#define GRAVITY_H
+
+#include <stdint.h>
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/tasks.h"
+
+// Gravedad entre todas las partículas por Barnes-Hut. Las partículas se
+// ordenan por código Morton (radix sort por bloques) y el octree sale de
+// ese orden: cada nodo es un rango contiguo de vecinas. Para cada grupo (el
+// nodo más alto con GRAVITY_GROUP partículas o menos) se recorre el árbol
+// una vez: los nodos lejos del grupo (lado / distancia < GRAVITY_THETA)
+// entran como su centro de masa y los cercanos se abren hasta las
+// partículas. La lista resultante se suma para cada partícula del grupo
+// con gravity_batch (kernels.h).
+//
+// Sólo monopolo y sin imágenes periódicas. El orden de las partículas no
+// cambia: el árbol guarda su propia permutación.
+
+#define GRAVITY_LEAF        16     // partículas por hoja
+#define GRAVITY_GROUP       128    // partículas por grupo que recorre el árbol junto
+#define GRAVITY_CHUNK       16384  // partículas por tarea
+#define GRAVITY_MORTON_BITS 21     // bits por eje del código Morton
+
+typedef struct {
+    float com[3];   // centro de masa
+    float mass;
+    float size;     // lado de la celda
+    float offset;   // distancia del centro de masa al centro de la celda
+    int   lo, hi;   // rango en el orden Morton
+    int   child;    // primer hijo (contiguos), o -1 en una hoja
+    int   children;
+} GravityNode;
+
+typedef struct {
+    // partículas en el orden Morton, con GRAVITY_BATCH de relleno en cero
+    uint64_t* keys;
+    int*      index;     // partícula original de cada posición
+    float*    x;
+    float*    y;
+    float*    z;
+    float*    m;
+    uint64_t* keysTmp;   // para el radix sort
+    int*      indexTmp;
+    int*      groupAt;   // grupo que empieza en cada posición, o -1
+    int       capacity;
+
+    GravityNode* nodes;
+    int nodeCount;
+    int nodeCapacity;
+
+    int* histogram;      // 256 por bloque, para el radix sort
+    int  histogramCapacity;
+
+    float min[3];        // cubo de la raíz
+    float side;
+} GravityTree;
+
+// Escribe en out la aceleración de cada partícula por la de todas:
+// GRAVITY_G Σ m d / (|d|² + ε²)^(3/2), con m = (r / PARTICLE_RADIUS)³ y
+// ε = GRAVITY_SOFTENING radios (puede ser 0: los pares a distancia 0 no
+// aportan). Con GRAVITY_THETA 0 la suma es directa.
+// Repartido en tareas de pool (NULL: en este hilo). Devuelve 0 sin memoria.
+int  gravity_compute(GravityTree* tree, const Config* cfg, const Particles* p, int count,
+                     vec3* out, TaskPool* pool);
+void gravity_free(GravityTree* tree);
+
+#endif
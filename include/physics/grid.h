@@ -0,0 +1,138 @@
+#ifndef PHYSICS_GRID_H
+#define PHYSICS_GRID_H
+
+#include <cglm/cglm.h>
+#include <math.h>
+#include "core/config.h"
+#include "physics/physics.h"
+
+// Grilla uniforme de celdas indexada por hash espacial. Se reconstruye en
+// cada paso dentro de resolve_collisions y queda disponible hasta el
+// siguiente para las consultas espaciales.
+
+#define HASH_TABLE_SIZE 2097152     // primo cercano a 2ⁿ para buen hashing
+#define MAX_BUCKET_SIZE 32          // max partículas por celda
+#define LARGE_RATIO 1.5f            // desde cuántas veces el radio mínimo es "grande"
+#define GRID_MAX_REACH 4            // celdas por lado que mira una partícula grande
+
+// Parámetros de la grilla del paso actual. En el dominio periódico las
+// celdas se cuentan desde el borde del entorno y sus coordenadas dan la
+// vuelta en [0, cells).
+typedef struct {
+    float cellSize;
+    int   periodic;
+    float origin;   // borde inferior del dominio periódico
+    float period;   // largo del dominio periódico
+    int   cells;    // celdas por eje en el dominio periódico
+    float largeRadius;  // radio de las comunes; las de radio mayor son grandes
+    float maxRadius;
+
+    int   cellMin[3], cellMax[3];  // celdas ocupadas (acotan las búsquedas)
+    const Particles* particles;    // partículas indexadas en el último build
+    int   count;
+} GridParams;
+
+// Tabla de hash: por simplicidad, un arreglo fijo de buckets
+extern int hashCount[HASH_TABLE_SIZE];
+extern int hashTable[HASH_TABLE_SIZE][MAX_BUCKET_SIZE];
+
+extern GridParams grid;
+extern int (*cellCoord)[3];         // celda de cada partícula al insertarla
+extern unsigned int* occupiedList;  // buckets con al menos una partícula
+extern int occupiedCount;
+extern int* overflowList;           // partículas que no entraron en su bucket
+extern int overflowCount;
+extern int* largeList;              // partículas grandes (también en sus buckets)
+extern int largeCount;
+
+// Fija celdas de lado 2 * radio máximo de las partículas comunes y el modo
+// periódico del entorno. Las que superan LARGE_RATIO veces la más chica
+// (los proxies de proxy.h) no agrandan las celdas: buscan sus contactos en
+// un vecindario más ancho (grid_reach).
+void grid_setup(const Config* config, const Particles* p, int count);
+// Inserta count partículas con los parámetros de grid_setup. Devuelve 0 si
+// no pudo reservar memoria.
+int grid_insert(const Particles* p, int count);
+// grid_insert por partes, para repartirlo en bloques: begin vacía la
+// grilla anterior y reserva; cells calcula las celdas de lo .. hi (bloques
+// distintos pueden ir en paralelo); insert las mete en los buckets y tiene
+// que ir en orden de bloques, como grid_insert; end la da por armada.
+int  grid_insert_begin(const Particles* p, int count);
+void grid_insert_cells(const Particles* p, int lo, int hi);
+void grid_insert_range(const Particles* p, int lo, int hi);
+void grid_insert_end(int count);
+
+// Constantes de hashing
+#define HASH_P1 73856093u
+#define HASH_P2 19349663u
+#define HASH_P3 83492791u
+
+// Función de hash espacial
+static inline unsigned int spatial_hash(int x, int y, int z) {
+    unsigned int h = (unsigned int)(x * HASH_P1 ^ y * HASH_P2 ^ z * HASH_P3);
+    return h & (HASH_TABLE_SIZE - 1);  // asume HASH_TABLE_SIZE potencia de 2
+}
+
+static inline int wrap_cell(int c) {
+    c %= grid.cells;
+    return c < 0 ? c + grid.cells : c;
+}
+
+// Calcula coords de celda
+static inline void get_cell_coords(const vec3 pos, int *ix, int *iy, int *iz) {
+    if (grid.periodic) {
+        *ix = wrap_cell((int)floorf((pos[0] - grid.origin) / grid.cellSize));
+        *iy = wrap_cell((int)floorf((pos[1] - grid.origin) / grid.cellSize));
+        *iz = wrap_cell((int)floorf((pos[2] - grid.origin) / grid.cellSize));
+        return;
+    }
+    *ix = (int)floorf(pos[0] / grid.cellSize);
+    *iy = (int)floorf(pos[1] / grid.cellSize);
+    *iz = (int)floorf(pos[2] / grid.cellSize);
+}
+
+// Coordenadas vecinas (c-1, c, c+1) sobre un eje. En el dominio periódico
+// dan la vuelta y se descartan repetidas cuando hay menos de 3 celdas.
+static inline int neighbour_coords(int c, int out[3]) {
+    if (!grid.periodic) {
+        out[0] = c - 1; out[1] = c; out[2] = c + 1;
+        return 3;
+    }
+    int n = 0;
+    for (int d = -1; d <= 1; d++) {
+        int w = wrap_cell(c + d);
+        if (n > 0 && (out[0] == w || out[n-1] == w)) continue;
+        out[n++] = w;
+    }
+    return n;
+}
+
+// Celdas a cada lado que tiene que mirar una partícula de este radio para
+// encontrar todo lo que puede tocar
+static inline int grid_reach(float radius) {
+    int reach = (int)ceilf((radius + grid.maxRadius) / grid.cellSize);
+    if (reach < 1) reach = 1;
+    return reach < GRID_MAX_REACH ? reach : GRID_MAX_REACH;
+}
+
+// Como neighbour_coords, de c - reach a c + reach (out de 2 * reach + 1)
+static inline int neighbour_span(int c, int reach, int* out) {
+    int n = 0;
+    if (grid.periodic && 2 * reach + 1 >= grid.cells) {
+        for (int k = 0; k < grid.cells; k++) out[n++] = k;
+        return n;
+    }
+    for (int d = -reach; d <= reach; d++)
+        out[n++] = grid.periodic ? wrap_cell(c + d) : c + d;
+    return n;
+}
+
+// Convención de imagen mínima: lleva una diferencia de posiciones a la
+// copia más cercana del dominio periódico
+static inline void minimum_image(vec3 diff) {
+    if (!grid.periodic) return;
+    for (int a = 0; a < 3; a++)
+        diff[a] -= grid.period * floorf(diff[a] / grid.period + 0.5f);
+}
+
+#endif
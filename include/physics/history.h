@@ -0,0 +1,53 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "physics/physics.h"
+
+// Historial acotado de los últimos pasos para rebobinar. Cada
+// HISTORY_KEYFRAME frames se guarda el estado completo; en el medio sólo
+// la diferencia cuantizada contra el frame anterior reconstruido, en
+// varints, así el error no se acumula. Cuando se llena la memoria se
+// descartan los frames más viejos de a un keyframe con sus deltas.
+typedef struct {
+    size_t offset;   // posición en data
+    size_t bytes;
+    int count;       // partículas activas en ese frame
+    int keyframe;
+} HistoryFrame;
+
+typedef struct {
+    unsigned char* data;
+    size_t capacity;
+    size_t head;           // donde termina el último frame
+
+    HistoryFrame* frames;  // del más viejo al más nuevo, desde first
+    int first;
+    int frameCount;
+    int frameCapacity;
+
+    int keyInterval;
+    int sinceKey;
+    float quantum;         // paso de cuantización de las posiciones
+
+    Particles* recon;      // último frame tal como lo ve el decodificador
+    int reconCount;
+    int reconCapacity;
+    unsigned char* scratch;
+    size_t scratchCapacity;
+} History;
+
+int  history_init(History* h, size_t bytes, int keyInterval, float quantum);
+void history_free(History* h);
+void history_clear(History* h);
+// Agrega el estado actual como frame más nuevo
+int  history_record(History* h, const Particles* p, int count);
+int  history_frames(const History* h);
+// Reconstruye el frame (0 = el más viejo) en p y devuelve su cantidad de
+// partículas, o -1
+int  history_restore(History* h, int frame, Particles* p);
+// Descarta los frames posteriores a frame para seguir grabando desde ahí
+void history_truncate(History* h, int frame);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "physics/physics.h"
+#include "physics/grid.h"
+
+#define CONTACT_BATCH 16  // candidatos por bloque de contact_batch (8 o 16 carriles)
+#define GRAVITY_BATCH 16  // fuentes por bloque de gravity_batch
+
+// Bucles calientes del paso de física. kernels.c se compila una vez por
+// ISA (ver makefile) y physics_kernels_init elige la mejor que soporte la
+// CPU; todas hacen las mismas operaciones en el mismo orden.
+typedef struct {
+    const char* name;
+    // Verlet con aceleración uniforme (misma cuenta que update_physics)
+    void (*integrate_uniform)(const vec3 acc, Particles* p, int count, float dt);
+    void (*collide_box)(float size, Particles* p, int count);
+    void (*collide_sphere)(float envRadius, Particles* p, int count);
+    // Celda de cada partícula con los parámetros de la grilla
+    void (*cell_coords)(const GridParams* g, const Particles* p, int count, int (*out)[3]);
+    // De los candidatos, deja en out los que pueden tocar a i (a menos de
+    // radio + radio + padding, con imagen mínima si period > 0). Es un
+    // filtro: solve_contact vuelve a chequear cada par.
+    int (*contact_filter)(const Particles* p, int i, const int* candidates, int n,
+                          float padding, float period, int* out);
+    // Lo mismo sobre arreglos separados por coordenada (x, y, z, r) y un
+    // rango contiguo lo .. hi: deja en out los índices a menos de reach +
+    // r[k] de at, con imagen mínima si period > 0. Va de a CONTACT_BATCH:
+    // los arreglos tienen que poder leerse hasta hi + CONTACT_BATCH - 1 y
+    // out tener lugar para hi - lo + CONTACT_BATCH.
+    int (*contact_batch)(const float* x, const float* y, const float* z, const float* r,
+                         int lo, int hi, const float at[3], float reach, float period,
+                         int* out);
+    // Suma en acc la atracción sobre at de las fuentes 0 .. count (x, y, z
+    // y masa m): m d / (|d|² + soft2)^(3/2), 0 si el denominador es 0. Va de
+    // a GRAVITY_BATCH: hasta el múltiplo siguiente los arreglos se leen y
+    // las masas tienen que ser 0.
+    void (*gravity_batch)(const float* x, const float* y, const float* z, const float* m,
+                          int count, const float at[3], float soft2, float acc[3]);
+} PhysicsKernels;
+
+extern const PhysicsKernels* physicsKernels;
+
+// Elige la variante por cpuid; la variable de entorno PHYSICS_ISA
+// (generic, avx2, avx512) la fuerza. Devuelve el nombre elegido.
+const char* physics_kernels_init(void);
+// Fuerza una variante por nombre; 0 si no existe o la CPU no la soporta
+int physics_kernels_select(const char* name);
+// Variantes compiladas que esta CPU puede correr
+int physics_kernels_count(void);
+const PhysicsKernels* physics_kernels_get(int index);
+
+#endif
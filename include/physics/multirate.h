@@ -0,0 +1,69 @@
+#ifndef MULTIRATE_H
+#define MULTIRATE_H
+
+#include <stdint.h>
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+
+// Paso múltiple por regiones. El espacio se divide en regiones cúbicas de
+// MULTIRATE_REGION radios y cada una recibe un nivel k según la velocidad
+// máxima de sus partículas: avanza con pasos de dt / 2^k, lo justo para que
+// nada se mueva más de MULTIRATE_CFL radios por paso (hasta
+// MULTIRATE_LEVELS - 1). Los niveles de regiones vecinas difieren en 1
+// como mucho.
+//
+// El paso se parte en 2^L subpasos (L = nivel máximo). En cada uno avanzan
+// las regiones cuyo paso termina ahí; las vecinas que no avanzan entran al
+// solver congeladas, como obstáculos de masa infinita. En el último
+// subpaso avanzan todas, así que al terminar todas están en el mismo
+// tiempo y previus vuelve a medir un paso dt.
+//
+// La caché de contactos del paso (la que se pasa a multirate_step) guarda
+// los pares con índices de p. Cada subpaso toma de ahí los pares que caen
+// en work, los resuelve con índices de work y los devuelve: el warm start
+// pasa de un subpaso al siguiente y de un paso al otro aunque cambie el
+// reparto de regiones.
+#define MULTIRATE_REGION 8.0f
+
+typedef struct {
+    uint64_t key;
+    int first;          // en members
+    int count;
+    int level;
+    int neighbours[26];
+    int neighbourCount;
+} MultiRateRegion;
+
+typedef struct {
+    uint64_t key;
+    int index;
+} MultiRateMember;
+
+typedef struct {
+    MultiRateMember* members;   // partículas ordenadas por región
+    MultiRateRegion* regions;
+    int regionCount;
+    unsigned char* level;       // nivel de cada partícula en este paso
+    unsigned char* regionState; // 0 afuera, 1 congelada, 2 avanza
+
+    Particles* work;            // partículas del subpaso (primero las que avanzan)
+    int* workIndex;
+    unsigned char* frozen;
+    int capacity;
+
+    int* localIndex;            // posición en work de cada partícula, o -1
+    ContactCache contacts;      // la del subpaso, con índices de work
+    int substeps;               // del último paso
+    int updates;                // partículas integradas en el último paso
+} MultiRate;
+
+int  multirate_init(MultiRate* mr, int capacity);
+void multirate_free(MultiRate* mr);
+// Avanza dt con subpasos por región. Si todo es lento es un paso común.
+// contacts es la caché de la simulación (índices de p) en los dos casos. Devuelve las pasadas máximas que usó el solver en
+// un subpaso.
+int  multirate_step(MultiRate* mr, Config* cfg, const ForceFieldSet* forces,
+                    Particles* p, int count, float dt, ContactCache* contacts);
+
+#endif
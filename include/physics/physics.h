@@ -4,19 +4,80 @@
 
 #include <cglm/cglm.h>
 #include <stddef.h>
-#include <glad/gl.h>
+#include <stdint.h>
 #include "core/config.h"
+#include "physics/forces.h"
+#include "physics/tasks.h"
 
 typedef struct {
     vec3 current;  // posición actual
     vec3 previus;  //
-    vec3 acceleration;
     float radius;   // radio de la esfera
 } Particles;
 
-void update_physics(Config *config, Particles* s, float dt);
-void resolve_collisions(Particles* spheres, int count);
+// Integra una partícula con la aceleración total ya evaluada
+void update_physics(const vec3 acceleration, Particles* s, float dt);
+// Integra count partículas evaluando los campos de fuerza y las choca contra
+// el entorno de config->ENV_TYPE
+void integrate_particles(Config *config, const ForceFieldSet* forces,
+                         Particles* p, int count, float dt);
+// Par en contacto y la corrección de posición que recibió en un paso
+typedef struct {
+    uint64_t key;   // (i << 32) | j, con i < j
+    float lambda;
+} Contact;
+
+// Contactos que el solver conserva entre pasos para el warm start: la caché
+// del paso anterior (ordenada por clave) y el registro del paso actual.
+// Cada simulación independiente necesita la suya.
+typedef struct {
+    Contact* items;
+    int count;
+    int capacity;
+    Contact* log;
+    int logCount;
+    int logCapacity;
+} ContactCache;
+
+// Devuelve la cantidad de pasadas que necesitó el solver
+int resolve_collisions(Config *config, Particles* spheres, int count);
+// Igual, pero con una caché de contactos propia
+int resolve_collisions_cached(Config *config, Particles* spheres, int count,
+                              ContactCache* contacts);
+// Igual, pero las partículas con frozen[i] != 0 no se mueven: sólo hacen
+// de obstáculo (masa infinita) para las demás
+int resolve_collisions_masked(Config *config, Particles* spheres, int count,
+                              ContactCache* contacts, const unsigned char* frozen);
+void contact_cache_free(ContactCache* cache);
+
+#define STEP_CHUNK 16384  // partículas por tarea de integrate_and_resolve
+
+// integrate_particles + resolve_collisions_cached con la integración y el
+// armado de la grilla repartidos por bloques de chunk partículas (0 =
+// STEP_CHUNK) en un grafo de tareas de pool. El resultado es bit a bit el
+// mismo. Sin pool, o con un solo bloque, es el paso de siempre.
+int integrate_and_resolve(Config *config, const ForceFieldSet* forces, Particles* spheres,
+                          int count, float dt, ContactCache* contacts, TaskPool* pool,
+                          int chunk);
+// Consultas espaciales sobre la grilla del último resolve_collisions.
+// Devuelven la cantidad encontrada (puede superar maxOut; sólo se escriben
+// maxOut índices).
+int physics_query_radius(const vec3 center, float radius, int* out, int maxOut);
+int physics_query_aabb(const vec3 min, const vec3 max, int* out, int maxOut);
+// Los k más cercanos ordenados por distancia (al cuadrado en dist2)
+int physics_query_knn(const vec3 center, int k, int* out, float* dist2);
+// Primera partícula que toca el rayo (-1 si ninguna) y la distancia en tHit
+int physics_raycast(const vec3 origin, const vec3 direction, float maxDist, float* tHit);
 
-void collision_sphere(Config *config, Particles* p);
-void collision_box(Config *config, Particles* p);
+// Versiones por lotes: la consulta q escribe en out + q * maxPerQuery (o k).
+// Repartidas en tareas de pool (NULL: en este hilo); la grilla no cambia
+// mientras tanto.
+void physics_query_radius_batch(const vec3* centers, const float* radii, int queryCount,
+                                int* out, int maxPerQuery, int* counts, TaskPool* pool);
+void physics_query_aabb_batch(const vec3* mins, const vec3* maxs, int queryCount,
+                              int* out, int maxPerQuery, int* counts, TaskPool* pool);
+void physics_query_knn_batch(const vec3* centers, int queryCount, int k,
+                             int* out, float* dist2, int* counts, TaskPool* pool);
+void physics_raycast_batch(const vec3* origins, const vec3* directions, int queryCount,
+                           float maxDist, int* hits, float* tHit, TaskPool* pool);
 #endif
@@ -0,0 +1,42 @@
+#ifndef PLANAR_H
+#define PLANAR_H
+
+#include <cglm/cglm.h>
+#include "core/config.h"
+#include "physics/forces.h"
+
+// Simulación plana (DIMENSIONS = 2). Es un motor aparte, escrito para dos
+// ejes: posiciones en arreglos SoA (x, y, px, py, radius), grilla densa de
+// celdas sobre los límites del entorno y vecindario de 9 celdas en vez de
+// 27. En cada paso las partículas se reordenan por celda, así cada celda
+// es un rango contiguo de los arreglos y el solver los recorre en orden.
+//
+// Los entornos se cortan por z = 0: la caja es un cuadrado, la esfera un
+// círculo y el periódico un toro. Los campos de fuerza se evalúan en el
+// plano y se descarta la componente z.
+typedef struct PlanarSim PlanarSim;
+
+PlanarSim* planar_create(int capacity);
+void       planar_destroy(PlanarSim* sim);
+
+// Agrega n partículas en posiciones del entorno; devuelve cuántas agregó
+int  planar_spawn(PlanarSim* sim, const Config* cfg, int n);
+void planar_set_count(PlanarSim* sim, int count);
+int  planar_count(const PlanarSim* sim);
+
+// Integra, choca contra el entorno y resuelve contactos. Devuelve las
+// pasadas que usó el solver.
+int  planar_step(PlanarSim* sim, const Config* cfg, const ForceFieldSet* forces, float dt);
+
+// Pares a distancia menor que la suma de radios más margin, tal como los
+// recorre el solver (cada uno una vez). Reordena las partículas por celda:
+// los índices son los del orden nuevo (el de planar_positions). Devuelve
+// cuántos hay (en out hasta maxOut), o -1 sin memoria. Para --verify.
+int  planar_pairs(PlanarSim* sim, const Config* cfg, float margin, int (*out)[2], int maxOut);
+
+// Posiciones para subir tal cual a un buffer de vec2
+void planar_positions(const PlanarSim* sim, vec2* out);
+// Partícula que contiene el punto (x, y), -1 si ninguna
+int  planar_pick(const PlanarSim* sim, float x, float y);
+
+#endif
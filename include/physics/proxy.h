@@ -0,0 +1,63 @@
+#ifndef PROXY_H
+#define PROXY_H
+
+#include <stdint.h>
+#include "core/config.h"
+#include "physics/physics.h"
+
+// Resolución adaptativa. Las partículas que llevan PROXY_FRAMES pasos
+// quietas (a menos de PROXY_DRIFT radios de donde se asentaron) se juntan
+// de a grupos, hasta PROXY_MAX_CHILDREN por celda gruesa, en un proxy con
+// el mismo volumen; como la densidad es uniforme también conserva la masa
+// y el momento. El proxy se vuelve a partir en las partículas originales
+// cuando recibe un golpe o cuando el foco (la cámara) se acerca a menos de
+// PROXY_DISTANCE.
+#define PROXY_MAX_CHILDREN 8
+#define PROXY_MIN_CHILDREN 4
+
+typedef struct {
+    vec3  offset[PROXY_MAX_CHILDREN];  // posición de cada hija respecto del proxy
+    float radius[PROXY_MAX_CHILDREN];
+    int   count;                       // 0 = registro libre
+} ProxyChildren;
+
+// Candidato a unirse: clave de su celda gruesa
+typedef struct {
+    uint64_t key;
+    int index;
+} ProxyCandidate;
+
+typedef struct {
+    unsigned short* quiet;  // pasos seguidos quieta, por partícula
+    int* proxy;             // registro en records si es proxy, si no -1
+    vec3* anchor;           // donde empezó a contar la quietud
+    int tracked;            // partículas con estado (las nuevas arrancan en 0)
+    int capacity;
+
+    ProxyChildren* records;
+    int recordCount;        // registros usados o libres
+    int recordCapacity;
+    int* freeRecords;
+    int freeCount;
+    int active;             // proxies vivos
+
+    vec3 focus;
+    int hasFocus;
+
+    ProxyCandidate* candidates;
+} ProxySet;
+
+int  proxy_init(ProxySet* set, int capacity);
+void proxy_free(ProxySet* set);
+// Olvida los proxies: los que existan quedan como partículas grandes
+void proxy_forget(ProxySet* set);
+void proxy_set_focus(ProxySet* set, const vec3 focus);
+// Copia p en out con cada proxy reemplazado por sus hijas, como las
+// dejaría proxy_update al partirlo. Los que no entran en capacity quedan
+// enteros. Devuelve la cantidad escrita.
+int  proxy_expand(const ProxySet* set, const Particles* p, int count, Particles* out, int capacity);
+// Parte los proxies perturbados y une los grupos quietos. Cambia *count y
+// reordena p (compacta los huecos). Devuelve 1 si los índices cambiaron.
+int  proxy_update(ProxySet* set, const Config* cfg, Particles* p, int* count, int capacity);
+
+#endif
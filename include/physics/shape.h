@@ -0,0 +1,60 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include "physics/physics.h"
+#include "physics/tasks.h"
+
+// Cuerpos rígidos o deformables por shape matching (Müller et al. 2005)
+// sobre las partículas Verlet. Cada cluster recuerda la forma de reposo de
+// sus partículas; en cada paso se busca la rotación que mejor lleva esa
+// forma a las posiciones actuales (la parte rotacional de la
+// descomposición polar de A_pq) y cada partícula se acerca a su lugar en
+// la forma rotada. Con deform > 0 la meta mezcla la rotación con la
+// transformación lineal que mejor ajusta, y el cuerpo se deforma.
+//
+// Una partícula pertenece a lo sumo a un cluster, así que los clusters se
+// resuelven en paralelo sin coloreo. Los miembros de cada cluster y sus
+// offsets de reposo están contiguos (CSR): la pasada recorre la memoria en
+// orden. Los miembros pueden tocarse: los contactos internos son
+// centrales y la proyección rígida los anula.
+
+#define SHAPE_CHUNK 256           // clusters por tarea
+#define SHAPE_POLAR_ITERATIONS 8  // tope de la iteración de la rotación
+
+typedef struct {
+    // miembros del cluster c: members[start[c] .. start[c + 1])
+    int*   start;
+    int*   members;
+    float (*rest)[3];   // offset de reposo de cada miembro al centro de masa
+    float* mass;        // masa de cada miembro (r³)
+    int    memberCount;
+    int    memberCapacity;
+
+    // por cluster
+    float (*rotation)[4];    // última rotación (x, y, z, w): arranca la siguiente
+    float (*restInverse)[9]; // A_qq⁻¹ (por filas); cero si la forma es plana
+    float* stiffness;        // fracción del camino a la meta por paso (0 .. 1)
+    float* deform;           // mezcla de la transformación lineal (0 = rígido)
+    int    count;
+    int    capacity;
+
+    int*   owner;            // cluster de cada partícula, o -1
+    int    ownerCapacity;
+} ShapeSet;
+
+// Agrega un cluster con las partículas indices[0 .. n) y su forma actual
+// como reposo. Devuelve su id, o -1 si alguna ya está en otro cluster, hay
+// menos de dos o no hay memoria.
+int  shape_add(ShapeSet* set, const Particles* p, int count, const int* indices, int n,
+               float stiffness, float deform);
+// Quita los clusters con alguna partícula desde count en adelante
+void shape_truncate(ShapeSet* set, int count);
+void shape_free(ShapeSet* set);
+
+// Lleva cada cluster hacia su forma, repartido en tareas de pool (NULL:
+// en este hilo)
+void shape_solve(ShapeSet* set, Particles* p, TaskPool* pool);
+// Distancia máxima de un miembro a su lugar en la forma rígida
+float shape_max_error(const ShapeSet* set, const Particles* p);
+
+#endif
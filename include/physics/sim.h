@@ -0,0 +1,115 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+
+// API de libparticles: una simulación completa (partículas, campos de
+// fuerza, caché de contactos) detrás de un puntero opaco. No depende de GL
+// ni de GLFW; el visor de main.c es un cliente más.
+typedef struct ParticleSim ParticleSim;
+
+// capacity es el máximo de partículas; NULL si no hay memoria. Los kernels
+// arrancan en generic: physics_kernels_init elige los de esta CPU.
+ParticleSim* particle_sim_create(const Config* cfg, int capacity);
+// Lee la configuración y los campos de fuerza de un archivo config.txt
+ParticleSim* particle_sim_create_from_file(const char* configPath, int capacity);
+void particle_sim_destroy(ParticleSim* sim);
+
+// Reemplaza la configuración (entorno, radio, solver...). Las partículas
+// existentes no cambian.
+void particle_sim_set_config(ParticleSim* sim, const Config* cfg);
+const Config* particle_sim_config(const ParticleSim* sim);
+// Campos de fuerza; arrancan con la gravedad de la configuración
+ForceFieldSet* particle_sim_forces(ParticleSim* sim);
+
+// Agrega hasta n partículas en posiciones del entorno; devuelve cuántas
+int  particle_sim_spawn(ParticleSim* sim, int n);
+// Fija la cantidad activa: achica, o expone las que el llamador escribió
+// directamente en particle_sim_particles (hasta la capacidad). Los proxies
+// que hubiera quedan como partículas grandes. Las restricciones y los
+// clusters de las partículas que quedan afuera se descartan recién al
+// simular o agregar partículas, así volver a exponerlas (historial) los
+// conserva.
+int  particle_sim_set_count(ParticleSim* sim, int count);
+int  particle_sim_count(const ParticleSim* sim);
+int  particle_sim_capacity(const ParticleSim* sim);
+
+// Avanza dt: une o parte proxies (PROXY_FRAMES), integra (por regiones con
+// MULTIRATE_LEVELS > 1), choca con el entorno y resuelve contactos. Devuelve las pasadas que usó el solver.
+// Con TASK_THREADS la integración y el armado de la grilla se reparten
+// en hilos (integrate_and_resolve). Con GRAVITY_G las partículas se atraen
+// entre sí (gravity.h), evaluado una vez por paso antes de integrar.
+// La cantidad y el orden de las partículas pueden cambiar.
+// Con EVENT_DRIVEN avanza por eventos (events.h) y devuelve cuántos
+// procesó; el estado vive en el motor de eventos, así que después de
+// escribir en particle_sim_particles hay que llamar a set_count.
+int  particle_sim_step(ParticleSim* sim, float dt);
+
+// Restricciones de distancia (constraints.h), resueltas después de los
+// contactos con CONSTRAINT_ITERATIONS pasadas. Mientras haya alguna no se
+// arman proxies ni se usa EVENT_DRIVEN: los índices tienen que quedar
+// fijos. Con rest < 0 el largo es la distancia actual; stiffness va de 0
+// a 1. Devuelven 0 con índices inválidos o sin memoria.
+int  particle_sim_add_distance(ParticleSim* sim, int a, int b, float rest, float stiffness);
+// Fija la partícula i donde está
+int  particle_sim_pin(ParticleSim* sim, int i);
+// Agrega una tela de nu x nv partículas desde origin, con filas a lo largo
+// de u y columnas a lo largo de v separadas spacing, con aristas de
+// estiramiento, corte y flexión. Con pinCorners quedan fijas las esquinas
+// de la primera fila. Devuelve el índice de la primera partícula, o -1 si
+// no entra o no hay memoria (y entonces no agrega nada).
+int  particle_sim_add_cloth(ParticleSim* sim, const vec3 origin, const vec3 u, const vec3 v,
+                            int nu, int nv, float spacing, float stiffness, int pinCorners);
+
+// Clusters por shape matching (shape.h), resueltos después de las
+// restricciones; cuentan como restricciones para proxies y eventos. La
+// forma actual de las partículas queda como reposo. stiffness va de 0 a 1;
+// deform 0 es rígido. Cada partícula puede estar en un solo cluster.
+// Devuelve el id del cluster, o -1.
+int  particle_sim_add_cluster(ParticleSim* sim, const int* indices, int n,
+                              float stiffness, float deform);
+// Agrega n partículas en position + offsets[k] (radios radii, o
+// PARTICLE_RADIUS con NULL) como un cluster. Devuelve el índice de la
+// primera, o -1 si no entran o no hay memoria.
+int  particle_sim_add_body(ParticleSim* sim, const vec3* offsets, const float* radii, int n,
+                           const vec3 position, float stiffness, float deform);
+
+// Punto de interés (la cámara): cerca de él no hay proxies
+void particle_sim_set_focus(ParticleSim* sim, const vec3 focus);
+// Proxies vivos; cada uno reemplaza entre 4 y 8 partículas
+int  particle_sim_proxy_count(const ParticleSim* sim);
+
+// Acceso sin copia. Las posiciones son current de cada partícula: stride
+// es la distancia en floats entre una y la siguiente.
+Particles* particle_sim_particles(ParticleSim* sim);
+// Estado completo para guardar (por ejemplo en el historial): las
+// partículas con los proxies partidos en sus hijas, así al volver a
+// cargarlo con set_count no se pierde nada. Sin proxies es el mismo
+// arreglo que particle_sim_particles. Vale hasta el próximo paso.
+const Particles* particle_sim_snapshot(ParticleSim* sim, int* count);
+const float* particle_sim_positions(const ParticleSim* sim, int* stride);
+
+// Consultas espaciales (ver physics_query_*). Si la grilla compartida
+// indexa otra simulación se reconstruye antes.
+int particle_sim_query_radius(ParticleSim* sim, const vec3 center, float radius,
+                              int* out, int maxOut);
+int particle_sim_query_aabb(ParticleSim* sim, const vec3 min, const vec3 max,
+                            int* out, int maxOut);
+int particle_sim_query_knn(ParticleSim* sim, const vec3 center, int k,
+                           int* out, float* dist2);
+int particle_sim_raycast(ParticleSim* sim, const vec3 origin, const vec3 direction,
+                         float maxDist, float* tHit);
+// Por lotes (ver physics_query_*_batch), repartidas en los TASK_THREADS
+// hilos de la simulación
+void particle_sim_query_radius_batch(ParticleSim* sim, const vec3* centers, const float* radii,
+                                     int queryCount, int* out, int maxPerQuery, int* counts);
+void particle_sim_query_aabb_batch(ParticleSim* sim, const vec3* mins, const vec3* maxs,
+                                   int queryCount, int* out, int maxPerQuery, int* counts);
+void particle_sim_query_knn_batch(ParticleSim* sim, const vec3* centers, int queryCount, int k,
+                                  int* out, float* dist2, int* counts);
+void particle_sim_raycast_batch(ParticleSim* sim, const vec3* origins, const vec3* directions,
+                                int queryCount, float maxDist, int* hits, float* tHit);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include "core/config.h"
+#include "physics/physics.h"
+#include "physics/forces.h"
+#include "physics/compact.h"
+
+#define MAX_STREAM_SLABS 4096
+#define STREAM_HEADER_BYTES 65536  // múltiplo de página: las partículas quedan alineadas
+
+// Simulación fuera de memoria: el estado vive en un archivo mapeado, con
+// las partículas ordenadas en franjas a lo largo de x. Un paso lee el
+// archivo franja por franja y escribe el resultado en otro; en memoria
+// sólo hay unas pocas franjas a la vez.
+//
+// Con COMPACT_STATE los registros usan el formato compacto (compact.h):
+// cada paso mueve 20 bytes por partícula en vez de 28, y se decodifican al
+// cargar cada franja.
+typedef struct {
+    char magic[8];                          // "PSTREAM1"
+    int64_t count;
+    int32_t slabs;
+    int32_t envType;
+    float cuts[MAX_STREAM_SLABS + 1];       // límites en x de cada franja
+    int64_t offsets[MAX_STREAM_SLABS + 1];  // primera partícula de cada franja
+    int32_t recordBytes;                    // 0 o sizeof(Particles): registros en float
+    CompactFormat compact;                  // si los registros son CompactParticle
+} StreamHeader;
+
+// Bytes por partícula en los archivos que se crean con cfg
+size_t stream_record_bytes(const Config* cfg);
+// Crea el archivo con count partículas generadas por el entorno de cfg
+int stream_create(const char* path, const Config* cfg, int64_t count, int slabs);
+// Avanza un paso leyendo src y escribiendo dst (pueden intercambiarse luego)
+int stream_step(const char* src, const char* dst, const Config* cfg,
+                const ForceFieldSet* forces, float dt);
+// Recorre el archivo y devuelve la cantidad y la altura media
+int stream_summary(const char* path, int64_t* count, double* meanY);
+
+#endif
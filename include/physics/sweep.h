@@ -0,0 +1,61 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "physics/physics.h"
+
+// Broadphase por barrido y poda (sweep and prune), alternativa a la grilla
+// con BROADPHASE = SWEEP. Las partículas se ordenan por el borde inferior
+// de su intervalo sobre un eje y cada una sólo se compara con las que
+// empiezan antes de que ella termine. No depende de un tamaño de celda:
+// no sufre con dominios enormes y casi vacíos ni con radios muy distintos.
+//
+// El eje es el de mayor dispersión. El orden se conserva entre pasos y,
+// como las partículas se mueven poco, un insertion sort lo arregla en casi
+// O(N); las que dan la vuelta al dominio periódico se sacan y se vuelven a
+// meter aparte. Si cambia la cantidad o el eje, o el orden se desarmó
+// demasiado, se rehace con un radix sort repartido entre los hilos del
+// pool.
+
+#define SWEEP_PARALLEL_MIN 65536  // desde cuántas partículas el radix sort usa el pool
+#define SWEEP_MAX_CHUNKS   8      // tramos del radix sort, a lo sumo uno por hilo
+
+typedef struct {
+    int i, j;
+} SweepPair;
+
+typedef struct {
+    float lo;
+    int   index;
+} SweepKey;
+
+typedef struct {
+    int*   order;        // índices ordenados por borde inferior
+    float* lo;           // borde inferior de order[k]
+    float (*sorted)[4];  // centro y radio de order[k], para barrer en orden
+    SweepKey* wrapped;   // las que dieron la vuelta al dominio periódico
+    int    count;
+    int    capacity;
+    int    axis;         // eje del barrido
+
+    SweepPair* pairs;    // pares del último barrido
+    int    pairCount;
+    int    pairCapacity;
+
+    uint32_t* radixKeys; // claves y valores del radix sort, ida y vuelta
+    int*   radixValues;
+    int    radixCapacity;
+
+    int    resets;       // veces que se rehizo el orden desde cero
+} SweepPrune;
+
+// Pares a distancia menor que la suma de radios más margin. En el dominio
+// periódico (period > 0, desde origin) la distancia es la de la imagen
+// mínima. Con frozen se omiten los pares de dos congeladas. Con pool el
+// radix sort se reparte en sus hilos (puede ser NULL). Devuelve la
+// cantidad de pares (en sp->pairs), o -1 si no pudo reservar memoria.
+int  sweep_find_pairs(SweepPrune* sp, const Particles* p, int count, float margin,
+                      float origin, float period, const unsigned char* frozen,
+                      TaskPool* pool);
+void sweep_free(SweepPrune* sp);
+
+#endif
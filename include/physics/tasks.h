@@ -0,0 +1,33 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+// Grafo de tareas con robo de trabajo. Se agregan tareas y dependencias y
+// task_pool_run las corre todas: cada una arranca apenas terminaron las
+// que la preceden, sin barreras entre fases. Cada hilo tiene su cola: saca
+// del fondo lo último que liberó (sigue con los mismos datos en cache) y,
+// si se queda sin trabajo, roba del frente de la cola de otro. El hilo que
+// llama a task_pool_run trabaja como uno más.
+
+#define TASK_MAX_THREADS 64
+
+typedef struct TaskPool TaskPool;
+
+// index es el que se pasó a task_add (por ejemplo, el número de bloque)
+typedef void (*TaskFn)(void* arg, int index);
+
+// threads hilos además del que llama; NULL si no se pudieron crear
+TaskPool* task_pool_create(int threads);
+void task_pool_destroy(TaskPool* pool);
+int  task_pool_threads(const TaskPool* pool);
+
+// Agrega una tarea al grafo en armado. Devuelve su id, o -1 sin memoria.
+int  task_add(TaskPool* pool, TaskFn fn, void* arg, int index);
+// task corre después de que termine before. 0 sin memoria.
+int  task_depend(TaskPool* pool, int task, int before);
+// Corre el grafo hasta que terminan todas y lo vacía para el próximo.
+// Las dependencias tienen que ir de ids menores a mayores (sin ciclos).
+void task_pool_run(TaskPool* pool);
+// Descarta el grafo en armado sin correrlo
+void task_pool_clear(TaskPool* pool);
+
+#endif
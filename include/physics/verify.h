@@ -0,0 +1,13 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "core/config.h"
+
+// Autoverificación de los kernels optimizados contra la implementación
+// escalar de referencia (update_physics, colisión de entorno y un solver
+// de pares por fuerza bruta) sobre escenas aleatorias. Las variantes de
+// ISA además se comparan bit a bit contra la genérica durante steps
+// pasos. Devuelve la cantidad de chequeos que fallaron.
+int physics_verify(const Config* base, int scenes, int steps, unsigned int seed);
+
+#endif
@@ -44,5 +44,7 @@ void camera_get_view_matrix(Camera* camera, mat4 dest);
 void camera_process_keyboard(Camera* camera, Camera_Movement direction, float deltaTime);
 void camera_process_mouse(Camera* camera, float xoffset, float yoffset, bool constrainPitch);
 void camera_process_scroll(Camera* camera, float yoffset);
+// Rayo desde la cámara por el punto (ndcX, ndcY) de la pantalla, en [-1, 1]
+void camera_screen_ray(Camera* camera, float ndcX, float ndcY, float aspect, vec3 origin, vec3 dir);
 
 #endif
@@ -4,9 +4,12 @@
 #include "glad/gl.h"
 #include "core/config.h"
 #include "render/camera.h"
+#include "physics/env.h"
 #include <GLFW/glfw3.h>
 
 void render_env(GLFWwindow* window, GLuint *shaderProgramEnviroment, Camera* camera, Config* config);
+// Engancha init/render de los entornos incluidos en el registro de physics/env.h
+void init_env_renderers(void);
 void init_box_environment(const Config* cfg);
 void init_sphere_enviroment(const Config* cfg);
 void render_sphere(GLuint shaderEnviroment, Config *config);
@@ -34,4 +34,8 @@ typedef struct {
  */
 Mesh mesh_generate_cube(void);
 Mesh mesh_generate_sphere(int latDiv, int lonDiv);
+// Disco de radio 1 en el plano z = 0 visto desde +z, para la simulación
+// plana. El centro sobresale a z = 1 para que normalize(aPos) dé normales
+// de semiesfera y el sombreado sea el de la esfera.
+Mesh mesh_generate_disc(int segments);
 #endif // MESH_H
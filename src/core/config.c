@@ -1,4 +1,5 @@
 #include "core/config.h"
+#include "physics/env.h"
 
 void trim(char* str) {
     // Trim leading spaces
@@ -10,12 +11,133 @@ void trim(char* str) {
         str[--len] = '\0';
     }
 }
+// Valores por defecto de las claves opcionales
+static void set_defaults(Config* cfg) {
+    cfg->SOLVER_ITERATIONS = 4;
+    cfg->SOLVER_TOLERANCE = 1e-3f;
+    cfg->RESTITUTION = 0.8f;
+    cfg->WARM_START = 0.8f;
+    cfg->SOLVER_TILE = 0;
+    cfg->TASK_THREADS = 0;
+    cfg->CONSTRAINT_ITERATIONS = 8;
+    cfg->GRAVITY_G = 0.0f;
+    cfg->GRAVITY_THETA = 0.5f;
+    cfg->GRAVITY_SOFTENING = 2.0f;
+    cfg->HISTORY_MB = 64;
+    cfg->HISTORY_KEYFRAME = 30;
+    cfg->PROXY_FRAMES = 0;
+    cfg->PROXY_DRIFT = 0.25f;
+    cfg->PROXY_DISTANCE = 1.0f;
+    cfg->MULTIRATE_LEVELS = 1;
+    cfg->MULTIRATE_CFL = 0.25f;
+    cfg->COMPACT_STATE = 0;
+    cfg->DIMENSIONS = 3;
+    cfg->EVENT_DRIVEN = 0;
+    cfg->BROADPHASE = BROADPHASE_GRID;
+}
+
+int config_set(Config* cfg, const char* key, const char* value) {
+    if (strcmp(key, "RENDER_PARTICLES") == 0) {
+        cfg->RENDER_PARTICLES = (unsigned int)atoi(value);
+    } else if (strcmp(key, "INIT_PARTICLES") == 0) {
+        cfg->INIT_PARTICLES = (unsigned int)atoi(value);
+    } else if (strcmp(key, "STEP_PARTICLES") == 0) {
+        cfg->STEP_PARTICLES = (unsigned int)atoi(value);
+    } else if (strcmp(key, "SCR_WIDTH") == 0) {
+        cfg->SCR_WIDTH = (unsigned int)atoi(value);
+    } else if (strcmp(key, "SCR_HEIGHT") == 0) {
+        cfg->SCR_HEIGHT = (unsigned int)atoi(value);
+    } else if (strcmp(key, "ACCELERATION") == 0) {
+        sscanf(value, "%f %f %f", &cfg->ACCELERATION[0], &cfg->ACCELERATION[1], &cfg->ACCELERATION[2]);
+    } else if (strcmp(key, "VISCOSITY") == 0) {
+        sscanf(value, "%f %f %f", &cfg->VISCOSITY[0], &cfg->VISCOSITY[1], &cfg->VISCOSITY[2]);
+    } else if (strcmp(key, "PARTICLE_RADIUS") == 0) {
+        cfg->PARTICLE_RADIUS = strtof(value, NULL);
+    }else if (strcmp(key, "ENV_SIZE") == 0) {
+        cfg->ENV_SIZE = strtof(value, NULL);
+    }else if (strcmp(key, "ENV_DIV") == 0) {
+        cfg->ENV_DIV = (unsigned int)atoi(value);
+    } else if (strcmp(key, "ENV_TYPE") == 0) {
+        int env = env_find(value);
+        if (env >= 0)
+            cfg->ENV_TYPE = env;
+        else {
+            fprintf(stderr, "Unknown ENV_TYPE: %s\n", value);
+            cfg->ENV_TYPE = ENV_BOX; // default
+        }
+    } else if (strcmp(key, "PARTICLE_TYPE") == 0) {
+        if (strcmp(value, "POINT") == 0)
+            cfg->PARTICLE_TYPE= POINT_TYPE;
+        else if (strcmp(value, "MESH") == 0)
+            cfg->PARTICLE_TYPE= MESH_TYPE;
+     //   else if (strcmp(value, "OBJ") == 0)
+     //       cfg->PARTICLE_TYPE= OBJ_TYPE;
+        else {
+            fprintf(stderr, "Unknown ENV_TYPE: %s\n", value);
+            cfg->PARTICLE_TYPE = POINT_TYPE; // default
+        }
+    } else if (strcmp(key, "SOLVER_ITERATIONS") == 0) {
+        cfg->SOLVER_ITERATIONS = (unsigned int)atoi(value);
+    } else if (strcmp(key, "SOLVER_TOLERANCE") == 0) {
+        cfg->SOLVER_TOLERANCE = strtof(value, NULL);
+    } else if (strcmp(key, "RESTITUTION") == 0) {
+        cfg->RESTITUTION = strtof(value, NULL);
+    } else if (strcmp(key, "WARM_START") == 0) {
+        cfg->WARM_START = strtof(value, NULL);
+    } else if (strcmp(key, "SOLVER_TILE") == 0) {
+        cfg->SOLVER_TILE = (unsigned int)atoi(value);
+    } else if (strcmp(key, "TASK_THREADS") == 0) {
+        cfg->TASK_THREADS = (unsigned int)atoi(value);
+    } else if (strcmp(key, "CONSTRAINT_ITERATIONS") == 0) {
+        cfg->CONSTRAINT_ITERATIONS = (unsigned int)atoi(value);
+    } else if (strcmp(key, "GRAVITY_G") == 0) {
+        cfg->GRAVITY_G = strtof(value, NULL);
+    } else if (strcmp(key, "GRAVITY_THETA") == 0) {
+        cfg->GRAVITY_THETA = strtof(value, NULL);
+    } else if (strcmp(key, "GRAVITY_SOFTENING") == 0) {
+        cfg->GRAVITY_SOFTENING = strtof(value, NULL);
+    } else if (strcmp(key, "HISTORY_MB") == 0) {
+        cfg->HISTORY_MB = (unsigned int)atoi(value);
+    } else if (strcmp(key, "HISTORY_KEYFRAME") == 0) {
+        cfg->HISTORY_KEYFRAME = (unsigned int)atoi(value);
+    } else if (strcmp(key, "PROXY_FRAMES") == 0) {
+        cfg->PROXY_FRAMES = (unsigned int)atoi(value);
+    } else if (strcmp(key, "PROXY_DRIFT") == 0) {
+        cfg->PROXY_DRIFT = strtof(value, NULL);
+    } else if (strcmp(key, "PROXY_DISTANCE") == 0) {
+        cfg->PROXY_DISTANCE = strtof(value, NULL);
+    } else if (strcmp(key, "MULTIRATE_LEVELS") == 0) {
+        cfg->MULTIRATE_LEVELS = (unsigned int)atoi(value);
+    } else if (strcmp(key, "MULTIRATE_CFL") == 0) {
+        cfg->MULTIRATE_CFL = strtof(value, NULL);
+    } else if (strcmp(key, "COMPACT_STATE") == 0) {
+        cfg->COMPACT_STATE = (unsigned int)atoi(value);
+    } else if (strcmp(key, "DIMENSIONS") == 0) {
+        cfg->DIMENSIONS = (unsigned int)atoi(value);
+    } else if (strcmp(key, "EVENT_DRIVEN") == 0) {
+        cfg->EVENT_DRIVEN = (unsigned int)atoi(value);
+    } else if (strcmp(key, "BROADPHASE") == 0) {
+        if (strcmp(value, "GRID") == 0)
+            cfg->BROADPHASE = BROADPHASE_GRID;
+        else if (strcmp(value, "SWEEP") == 0)
+            cfg->BROADPHASE = BROADPHASE_SWEEP;
+        else {
+            fprintf(stderr, "Unknown BROADPHASE: %s\n", value);
+            cfg->BROADPHASE = BROADPHASE_GRID; // default
+        }
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
 int load_config(Config* cfg, const char* filename) {
     FILE* f = fopen(filename, "r");
     if (!f) {
         perror("Error opening config file");
         return 0;
     }
+    set_defaults(cfg);
 
     char line[256];
     while (fgets(line, sizeof(line), f)) {
@@ -26,49 +148,8 @@ int load_config(Config* cfg, const char* filename) {
 
         trim(key);
         trim(value);
-
-        if (strcmp(key, "RENDER_PARTICLES") == 0) {
-            cfg->RENDER_PARTICLES = (unsigned int)atoi(value);
-        } else if (strcmp(key, "INIT_PARTICLES") == 0) {
-            cfg->INIT_PARTICLES = (unsigned int)atoi(value);
-        } else if (strcmp(key, "STEP_PARTICLES") == 0) {
-            cfg->STEP_PARTICLES = (unsigned int)atoi(value);
-        } else if (strcmp(key, "SCR_WIDTH") == 0) {
-            cfg->SCR_WIDTH = (unsigned int)atoi(value);
-        } else if (strcmp(key, "SCR_HEIGHT") == 0) {
-            cfg->SCR_HEIGHT = (unsigned int)atoi(value);
-        } else if (strcmp(key, "ACCELERATION") == 0) {
-            sscanf(value, "%f %f %f", &cfg->ACCELERATION[0], &cfg->ACCELERATION[1], &cfg->ACCELERATION[2]);
-        } else if (strcmp(key, "VISCOSITY") == 0) {
-            sscanf(value, "%f %f %f", &cfg->VISCOSITY[0], &cfg->VISCOSITY[1], &cfg->VISCOSITY[2]);
-        } else if (strcmp(key, "PARTICLE_RADIUS") == 0) {
-            cfg->PARTICLE_RADIUS = strtof(value, NULL);
-        }else if (strcmp(key, "ENV_SIZE") == 0) {
-            cfg->ENV_SIZE = strtof(value, NULL);
-        }else if (strcmp(key, "ENV_DIV") == 0) {
-            cfg->ENV_DIV = (unsigned int)atoi(value);
-        } else if (strcmp(key, "ENV_TYPE") == 0) {
-            if (strcmp(value, "BOX") == 0)
-                cfg->ENV_TYPE = ENV_BOX;
-            else if (strcmp(value, "SPHERE") == 0)
-                cfg->ENV_TYPE = ENV_SPHERE;
-            else {
-                fprintf(stderr, "Unknown ENV_TYPE: %s\n", value);
-                cfg->ENV_TYPE = ENV_BOX; // default
-            }
-        } else if (strcmp(key, "PARTICLE_TYPE") == 0) {
-            if (strcmp(value, "POINT") == 0)
-                cfg->PARTICLE_TYPE= POINT_TYPE;
-            else if (strcmp(value, "MESH") == 0)
-                cfg->PARTICLE_TYPE= MESH_TYPE;
-         //   else if (strcmp(value, "OBJ") == 0)
-         //       cfg->PARTICLE_TYPE= OBJ_TYPE;
-            else {
-                fprintf(stderr, "Unknown ENV_TYPE: %s\n", value);
-                cfg->PARTICLE_TYPE = POINT_TYPE; // default
-            }
-        }
-
+        // las claves desconocidas pueden ser de otros módulos (campos de fuerza)
+        config_set(cfg, key, value);
     }
 
     fclose(f);
@@ -86,7 +167,28 @@ void print_config(const Config* cfg) {
     printf("PARTICLE_RADIUS: %f\n", cfg->PARTICLE_RADIUS);
     printf("ENV_RADIUS: %f\n", cfg->ENV_SIZE);
     printf("ENV_DIV: %u\n", cfg->ENV_DIV);
-    printf("ENV_TYPE: %u\n", cfg->ENV_TYPE);
+    printf("ENV_TYPE: %d\n", cfg->ENV_TYPE);
     printf("PARTICLE_TYPE: %u\n", cfg->PARTICLE_TYPE);
+    printf("SOLVER_ITERATIONS: %u\n", cfg->SOLVER_ITERATIONS);
+    printf("SOLVER_TOLERANCE: %f\n", cfg->SOLVER_TOLERANCE);
+    printf("RESTITUTION: %f\n", cfg->RESTITUTION);
+    printf("WARM_START: %f\n", cfg->WARM_START);
+    printf("SOLVER_TILE: %u\n", cfg->SOLVER_TILE);
+    printf("TASK_THREADS: %u\n", cfg->TASK_THREADS);
+    printf("CONSTRAINT_ITERATIONS: %u\n", cfg->CONSTRAINT_ITERATIONS);
+    printf("GRAVITY_G: %f\n", cfg->GRAVITY_G);
+    printf("GRAVITY_THETA: %f\n", cfg->GRAVITY_THETA);
+    printf("GRAVITY_SOFTENING: %f\n", cfg->GRAVITY_SOFTENING);
+    printf("HISTORY_MB: %u\n", cfg->HISTORY_MB);
+    printf("HISTORY_KEYFRAME: %u\n", cfg->HISTORY_KEYFRAME);
+    printf("PROXY_FRAMES: %u\n", cfg->PROXY_FRAMES);
+    printf("PROXY_DRIFT: %f\n", cfg->PROXY_DRIFT);
+    printf("PROXY_DISTANCE: %f\n", cfg->PROXY_DISTANCE);
+    printf("MULTIRATE_LEVELS: %u\n", cfg->MULTIRATE_LEVELS);
+    printf("MULTIRATE_CFL: %f\n", cfg->MULTIRATE_CFL);
+    printf("COMPACT_STATE: %u\n", cfg->COMPACT_STATE);
+    printf("DIMENSIONS: %u\n", cfg->DIMENSIONS);
+    printf("EVENT_DRIVEN: %u\n", cfg->EVENT_DRIVEN);
+    printf("BROADPHASE: %u\n", cfg->BROADPHASE);
 }
 
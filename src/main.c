@@ -5,6 +5,15 @@
 #include "render/mesh.h"
 #include "render/camera.h"
 #include "physics/physics.h"
+#include "physics/sim.h"
+#include "physics/planar.h"
+#include "physics/env.h"
+#include "physics/ensemble.h"
+#include "physics/domain.h"
+#include "physics/stream.h"
+#include "physics/history.h"
+#include "physics/kernels.h"
+#include "physics/verify.h"
 #include "core/config.h"
 #include <GLFW/glfw3.h>
 #include <cglm/affine.h> // para funciones como glm_rotate, glm_scale
@@ -12,55 +21,31 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #define MAX_PARTICLES  1000000
 
 
-static Particles particles[MAX_PARTICLES];
+// Estado de la simulación (partículas, campos, contactos); el resto de
+// este archivo es el visor
+static ParticleSim* sim = NULL;
 static vec3 positions_buff[MAX_PARTICLES];
+// Con DIMENSIONS = 2 (fijo al arrancar) la simulación es la plana y las
+// posiciones se suben como vec2; sim queda en NULL
+static PlanarSim* planar = NULL;
+static ForceFieldSet planarForces;
+static vec2 planar_buff[MAX_PARTICLES];
 
 static char debugTitle[256];
 
 static float deltaTime = 0.f;
+static int solverIterations = 0;
+// Historial para rebobinar; historyCursor >= 0 mientras se recorre
+static History history;
+static int historyCursor = -1;
 static float lastFrame = 0.0f;
 
-static inline void random_position_for_env(vec3 out, const Config* cfg) {
-    float padding = cfg->ENV_SIZE * 0.4f;
-    float max_r = cfg->ENV_SIZE - padding;
-
-    if (cfg->ENV_TYPE == ENV_BOX) {
-        for (int i = 0; i < 3; i++) {
-            out[i] = ((float)rand() / RAND_MAX) * (2.0f * max_r) - max_r;
-        }
-        return;
-    }
-
-    else if (cfg->ENV_TYPE == ENV_SPHERE) {
-        while (1) {
-            // Coordenadas x, y, z aleatorias en [-1,1] pero solo Y ≥ 0
-            float x = 2.0f * ((float)rand() / RAND_MAX) - 1.0f;
-            float y =       ((float)rand() / RAND_MAX);  // solo positivo
-            float z = 2.0f * ((float)rand() / RAND_MAX) - 1.0f;
-
-            float r2 = x*x + y*y + z*z;
-            if (r2 <= 1.0f) {
-                // Distribución uniforme en el volumen usando raíz cúbica
-                float scale = cbrtf((float)rand() / RAND_MAX);
-                out[0] = x * max_r * scale;
-                out[1] = y * max_r * scale;  // ya está en la parte superior
-                out[2] = z * max_r * scale;
-                return;
-            }
-        }
-    }
-
-    else {
-        fprintf(stderr, "Tipo de entorno no soportado\n");
-        out[0] = out[1] = out[2] = 0.0f;
-    }
-}
-
 static float lastX = 800.0f / 2.0f;
 static float lastY = 600.0f / 2.0f;
 static bool firstMouse = true;
@@ -69,11 +54,13 @@ static bool constrainPitch = true;
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void pick_particle(GLFWwindow* window, Camera* camera);
 bool init_glad();
 void init_texture(GLuint shaderProgram, GLuint *tex, const char *path, const char *uniformName, int textureUnit);
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
-void do_physics(Config* config, Particles* particles, double deltaTime, int activeParticles);
+void do_physics(double deltaTime);
 void init_vertex_buffers(Config* config, GLuint* vaoPoint, GLuint* vaoMesh,
                          GLuint* meshVBO, GLuint* meshEBO, GLuint* instanceVBO,
                          GLuint* pointVBO, GLuint* shaderPoint, GLuint* shaderMesh);
@@ -88,28 +75,78 @@ void set_up_callbacks(GLFWwindow* window, Camera* camera);
 GLFWwindow* setup_window(int width, int height, const char* title);
 
 void processInputMovement(GLFWwindow* window, float deltaTime);
-void init_particles(Particles* p, Config* config);
 void init_particle_buffers(GLuint* vao, GLuint* vbo, GLuint* ebo, Config* config,  int N);
 void update_particle_buffers(Config* config, Particles* particles, int N);
+void init_env(Config* config);
 void change_env(Config* config);
 void reinit_simulation(Config *config, bool resetAll);
+int  particle_count(void);
+void spawn_particles(int n);
+ForceFieldSet* simulation_forces(void);
+int run_ensemble(Config* config, const char* path, int steps, int workers);
+int run_domain(Config* config, int workers, int count, int steps);
+int run_stream(Config* config, const char* dir, int64_t count, int slabs, int steps);
+int run_gravity(Config* config, int count, int steps);
 Config config;
-unsigned int activeCount = 0;
 float spawnTimer = 0.0f;
 GLuint shaderPoint, shaderMesh;
 GLuint vaoPoint, vaoMesh, meshVBO, meshEBO, instanceVBO, pointVBO;
 static GLuint indexCount = 0;  // para mesh
 bool isPause = false;
-int main() {
+int main(int argc, char** argv) {
     if (!load_config(&config, "data/config.txt")) {
         fprintf(stderr, "No se pudo cargar configuración\n");
         return 1;
     }
+    printf("Physics kernels: %s\n", physics_kernels_init());
+    // Modos sin ventana, todos con --steps N:
+    //   --ensemble archivo [--workers N]: N procesos (0 = uno por CPU)
+    //   --domain procesos [--particles N]
+    //   --stream carpeta [--particles N] [--slabs N]
+    //   --verify [--scenes N]: kernels optimizados contra la referencia
+    //   --gravity [--particles N]: colapso de una nube fría por Barnes-Hut
+    const char* ensemblePath = NULL;
+    const char* streamDir = NULL;
+    int headlessSteps = 600;
+    int domainWorkers = 0;
+    int ensembleWorkers = 0;
+    int streamSlabs = 16;
+    long long headlessParticles = 100000;
+    bool verify = false;
+    bool gravity = false;
+    int verifyScenes = 12;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--ensemble") == 0 && a + 1 < argc) ensemblePath = argv[++a];
+        else if (strcmp(argv[a], "--domain") == 0 && a + 1 < argc) domainWorkers = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--workers") == 0 && a + 1 < argc) ensembleWorkers = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--stream") == 0 && a + 1 < argc) streamDir = argv[++a];
+        else if (strcmp(argv[a], "--slabs") == 0 && a + 1 < argc) streamSlabs = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--particles") == 0 && a + 1 < argc) headlessParticles = atoll(argv[++a]);
+        else if (strcmp(argv[a], "--steps") == 0 && a + 1 < argc) headlessSteps = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--verify") == 0) verify = true;
+        else if (strcmp(argv[a], "--scenes") == 0 && a + 1 < argc) verifyScenes = atoi(argv[++a]);
+        else if (strcmp(argv[a], "--gravity") == 0) gravity = true;
+    }
+    if (verify)
+        return physics_verify(&config, verifyScenes, headlessSteps < 120 ? headlessSteps : 120, 1234) ? 1 : 0;
+    if (ensemblePath) return run_ensemble(&config, ensemblePath, headlessSteps, ensembleWorkers);
+    if (domainWorkers > 0) return run_domain(&config, domainWorkers, (int)headlessParticles, headlessSteps);
+    if (streamDir) return run_stream(&config, streamDir, headlessParticles, streamSlabs, headlessSteps);
+    if (gravity) return run_gravity(&config, (int)headlessParticles, headlessSteps);
     if(config.INIT_PARTICLES > config.RENDER_PARTICLES && config.RENDER_PARTICLES > MAX_PARTICLES){
         fprintf(stderr, "No se puede iniciar con mas particulas que las maximas a renderizar ni superar el maximo de 1 000 000 particulas\n");
         return 1;
     }
     print_config(&config);
+    if (config.DIMENSIONS == 2) {
+        planar = planar_create(MAX_PARTICLES);
+        if (!planar) return 1;
+        planar_spawn(planar, &config, config.INIT_PARTICLES);
+    } else {
+        sim = particle_sim_create(&config, MAX_PARTICLES);
+        if (!sim) return 1;
+    }
+    force_fields_load(simulation_forces(), &config, "data/config.txt");
     GLFWwindow* window = setup_window(config.SCR_WIDTH, config.SCR_HEIGHT, "Simulator");
     if (!window) {
         printf("No windows created\n");
@@ -135,17 +172,12 @@ int main() {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     init_vertex_buffers(&config,& vaoPoint, &vaoMesh, &meshVBO, &meshEBO, &instanceVBO,
                          &pointVBO, &shaderPoint,  &shaderMesh);
-    init_particles(particles, &config);
-    switch (config.ENV_TYPE) {
-        case ENV_BOX:
-            init_box_environment(&config);
-            break;
-        case ENV_SPHERE:
-            init_sphere_enviroment(&config);
-            break;
-        default:
-            fprintf(stderr, "ENV_TYPE desconocido\n");
-    }
+    srand((unsigned)time(NULL));
+    init_env_renderers();
+    init_env(&config);
+    // el historial guarda partículas 3D: en el plano no hay rebobinado
+    history_init(&history, planar ? 0 : (size_t)config.HISTORY_MB << 20, config.HISTORY_KEYFRAME,
+                 config.PARTICLE_RADIUS / 4096.0f);
 
 
     while (!glfwWindowShouldClose(window)) {
@@ -154,22 +186,48 @@ int main() {
         lastFrame = currentFrame;
         spawnTimer += deltaTime;
 
-        if (!isPause && spawnTimer > 0.5f && activeCount <= config.RENDER_PARTICLES) {
+        if (!isPause && historyCursor < 0 && spawnTimer > 0.5f &&
+            particle_count() <= (int)config.RENDER_PARTICLES) {
             spawnTimer = 0.0f;
-            activeCount = fmin(activeCount + config.STEP_PARTICLES, MAX_PARTICLES);
+            spawn_particles(config.STEP_PARTICLES);
         }
 
         processInputMovement(window, deltaTime);
-        do_physics(&config, particles, deltaTime, activeCount);
+        if (planar) {
+            do_physics(deltaTime);
+        } else if (historyCursor < 0) {
+            // cerca de la cámara la simulación va a resolución completa; la
+            // cámara se lleva al espacio de la simulación (ver update_buffers)
+            mat4 inverse;
+            vec3 focus;
+            glm_mat4_identity(inverse);
+            glm_rotate(inverse, -glfwGetTime() * 0.1f, (vec3){0.0f, 1.0f, 0.0f});
+            glm_mat4_mulv3(inverse, camera.Position, 1.0f, focus);
+            particle_sim_set_focus(sim, focus);
+            do_physics(deltaTime);
+            // con los proxies partidos: restaurar no los puede rearmar
+            int recorded;
+            const Particles* state = particle_sim_snapshot(sim, &recorded);
+            history_record(&history, state, recorded);
+        }
+        int activeCount = particle_count();
         update_buffers(&config, &pointVBO, &instanceVBO, activeCount);
         render(window, &config, shaderPoint,shaderMesh,
             vaoPoint, vaoMesh, &camera, activeCount);
         render_env(window, &shaderProgramEnviroment, &camera, &config);
 
-        snprintf(debugTitle, sizeof(debugTitle),
-                             "Mi Simulación — Partículas: %d  FPS: %.1f",
-                             activeCount,
-                             1.0 / deltaTime);
+        if (historyCursor >= 0)
+            snprintf(debugTitle, sizeof(debugTitle),
+                                 "Mi Simulación — Rebobinando: frame %d/%d  (Enter sigue desde acá)",
+                                 historyCursor + 1,
+                                 history_frames(&history));
+        else
+            snprintf(debugTitle, sizeof(debugTitle),
+                                 "Mi Simulación — Partículas: %d (%d proxies)  FPS: %.1f  Iter: %d",
+                                 activeCount,
+                                 sim ? particle_sim_proxy_count(sim) : 0,
+                                 1.0 / deltaTime,
+                                 solverIterations);
         glfwSetWindowTitle(window, debugTitle);
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -177,35 +235,184 @@ int main() {
     glDeleteProgram(shaderPoint);
     glDeleteProgram(shaderMesh);
     glDeleteProgram(shaderProgramEnviroment);
+    history_free(&history);
+    particle_sim_destroy(sim);
+    planar_destroy(planar);
     glfwTerminate();
     return 0;
 }
 
-void change_env(Config* config){
-    switch (config->ENV_TYPE) {
-        case ENV_BOX:
-            init_sphere_enviroment(config);
-            config->ENV_TYPE = ENV_SPHERE;
-            break;
-        case ENV_SPHERE:
-            init_box_environment(config);
-            config->ENV_TYPE = ENV_BOX;
-            break;
-        default:
-            fprintf(stderr, "ENV_TYPE desconocido\n");
+// Simulación fuera de memoria: el estado alterna entre dos archivos de la
+// carpeta y cada paso los recorre una vez
+int run_stream(Config* config, const char* dir, int64_t count, int slabs, int steps) {
+    char paths[2][512];
+    snprintf(paths[0], sizeof(paths[0]), "%s/state0.bin", dir);
+    snprintf(paths[1], sizeof(paths[1]), "%s/state1.bin", dir);
+    if (!stream_create(paths[0], config, count, slabs)) {
+        fprintf(stderr, "No se pudo crear %s\n", paths[0]);
+        return 1;
     }
-    reinit_simulation(config, false);
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_load(&forces, config, "data/config.txt");
+
+    int current = 0;
+    const float dt = 1.0f / 60.0f;
+    time_t start = time(NULL);
+    for (int s = 0; s < steps; s++) {
+        if (!stream_step(paths[current], paths[1 - current], config, &forces, dt)) {
+            fprintf(stderr, "Fallo el paso %d\n", s);
+            return 1;
+        }
+        current = 1 - current;
+    }
+    double elapsed = difftime(time(NULL), start);
+
+    int64_t total;
+    double meanY;
+    if (!stream_summary(paths[current], &total, &meanY)) return 1;
+    double megabytes = 2.0 * (double)total * stream_record_bytes(config) * steps / (1024.0 * 1024.0);
+    printf("%lld particulas, %d franjas, %d pasos en %.0f s (%.1f MB/s), mean_y %.4f -> %s\n",
+           (long long)total, slabs, steps, elapsed, elapsed > 0.0 ? megabytes / elapsed : 0.0,
+           meanY, paths[current]);
+    return 0;
 }
-void init_particles(Particles* p, Config* config){
-    srand((unsigned)time(NULL));
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        random_position_for_env(particles[i].current, config);
-        glm_vec3_copy(particles[i].current, particles[i].previus);
-        particles[i].radius = config->PARTICLE_RADIUS;
-        glm_vec3_copy(config->ACCELERATION, p[i].acceleration);
+
+// Avanza count partículas repartidas en franjas entre varios procesos
+int run_domain(Config* config, int workers, int count, int steps) {
+    const EnvInterface* env = env_get(config->ENV_TYPE);
+    Particles* p = malloc((size_t)count * sizeof(Particles));
+    DomainWorkerStats* stats = malloc(MAX_DOMAIN_WORKERS * sizeof(DomainWorkerStats));
+    if (!env || !p || !stats) {
+        fprintf(stderr, "No se pudo preparar el dominio\n");
+        free(p);
+        free(stats);
+        return 1;
+    }
+    srand(1234);
+    for (int i = 0; i < count; i++) {
+        env->spawn(config, p[i].current);
+        glm_vec3_copy(p[i].current, p[i].previus);
+        p[i].radius = config->PARTICLE_RADIUS;
+    }
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_load(&forces, config, "data/config.txt");
+
+    DomainOptions opts = { .workers = workers, .steps = steps,
+                           .balanceInterval = 50, .dt = 1.0f / 60.0f };
+    int ok = domain_run(config, &forces, p, count, &opts, stats);
+    if (ok) {
+        double elapsed = 0.0;
+        printf("%4s %10s %10s %10s %9s %9s\n", "proc", "owned", "ghosts", "migrated", "cut_min", "cut_max");
+        for (int w = 0; w < workers; w++) {
+            printf("%4d %10d %10d %10ld %9.3f %9.3f\n", w, stats[w].owned, stats[w].ghosts,
+                   stats[w].migratedIn, stats[w].cutMin, stats[w].cutMax);
+            if (stats[w].seconds > elapsed) elapsed = stats[w].seconds;
+        }
+        double meanY = 0.0;
+        for (int i = 0; i < count; i++) meanY += p[i].current[1];
+        printf("%d particulas, %d procesos, %d pasos en %.3f s, mean_y %.4f\n",
+               count, workers, steps, elapsed, meanY / count);
+    }
+    free(p);
+    free(stats);
+    return ok ? 0 : 1;
+}
+
+// Avanza todas las instancias del archivo con paso fijo, repartidas entre
+// procesos, y muestra un resumen por instancia
+int run_ensemble(Config* config, const char* path, int steps, int workers) {
+    Ensemble ensemble;
+    ensemble_init(&ensemble);
+    srand(1234);
+    if (!ensemble_load(&ensemble, config, path)) {
+        fprintf(stderr, "No se pudo cargar el ensamble %s\n", path);
+        ensemble_free(&ensemble);
+        return 1;
+    }
+    printf("Ensemble: %d instancias, %d particulas\n", ensemble.instanceCount, ensemble.used);
+
+    if (!ensemble_run(&ensemble, 1.0f / 60.0f, steps, workers)) {
+        ensemble_free(&ensemble);
+        return 1;
     }
+    double elapsed = ensemble.seconds;
+
+    ensemble_print_stats(&ensemble);
+    printf("%d pasos en %.3f s (%.3f ms/paso)\n", steps, elapsed, 1000.0 * elapsed / (steps > 0 ? steps : 1));
+    ensemble_free(&ensemble);
+    return 0;
 }
 
+// Nube fría y uniforme que colapsa por su propia gravedad, dentro de la
+// esfera. Con GRAVITY_G = 0 en la configuración se elige para que caiga en
+// unos dos segundos; el radio se achica si las partículas no entran.
+int run_gravity(Config* config, int count, int steps) {
+    if (count < 1 || count > MAX_PARTICLES) {
+        fprintf(stderr, "Entre 1 y %d particulas\n", MAX_PARTICLES);
+        return 1;
+    }
+    Config cfg = *config;
+    cfg.ENV_TYPE = ENV_SPHERE;
+    glm_vec3_zero(cfg.ACCELERATION);
+    cfg.PROXY_FRAMES = 0;        // los proxies juntarían las partículas
+    const float radius = cfg.ENV_SIZE;
+    float spacing = cbrtf(4.0f / 3.0f * GLM_PI * radius * radius * radius / count);
+    if (cfg.PARTICLE_RADIUS > 0.25f * spacing) cfg.PARTICLE_RADIUS = 0.25f * spacing;
+    if (cfg.GRAVITY_G == 0.0f) {
+        // caída libre en t = √(3π / (16 G ρ)) con el ½ a dt² del integrador
+        float density = count / (4.0f / 3.0f * GLM_PI * radius * radius * radius);
+        cfg.GRAVITY_G = 3.0f * GLM_PI / (16.0f * density * 4.0f);
+    }
+    ParticleSim* gsim = particle_sim_create(&cfg, count);
+    if (!gsim) return 1;
+    srand(1234);
+    Particles* p = particle_sim_particles(gsim);
+    for (int i = 0; i < count; i++) {
+        float d2;
+        do {
+            for (int a = 0; a < 3; a++) p[i].current[a] = radius * (2.0f * rand() / RAND_MAX - 1.0f);
+            d2 = glm_vec3_norm2(p[i].current);
+        } while (d2 > radius * radius);
+        glm_vec3_copy(p[i].current, p[i].previus);
+        p[i].radius = cfg.PARTICLE_RADIUS;
+    }
+    particle_sim_set_count(gsim, count);
+    printf("Gravedad: %d particulas, G %g, theta %g, radio %g\n",
+           count, cfg.GRAVITY_G, cfg.GRAVITY_THETA, cfg.PARTICLE_RADIUS);
+
+    const float dt = 1.0f / 60.0f;
+    time_t start = time(NULL);
+    for (int s = 0; s <= steps; s++) {
+        if (s % 60 == 0 || s == steps) {
+            double rms = 0.0;
+            for (int i = 0; i < count; i++) rms += glm_vec3_norm2(p[i].current);
+            printf("paso %5d: radio rms %.4f\n", s, sqrt(rms / count));
+        }
+        if (s < steps) particle_sim_step(gsim, dt);
+    }
+    double elapsed = difftime(time(NULL), start);
+    printf("%d pasos en %.0f s (%.1f ms/paso)\n", steps, elapsed, 1000.0 * elapsed / (steps > 0 ? steps : 1));
+    particle_sim_destroy(gsim);
+    return 0;
+}
+
+void init_env(Config* config){
+    const EnvInterface* env = env_get(config->ENV_TYPE);
+    if (!env) {
+        fprintf(stderr, "ENV_TYPE desconocido\n");
+        return;
+    }
+    if (env->init) env->init(config);
+}
+
+// Pasa al siguiente entorno registrado
+void change_env(Config* config){
+    config->ENV_TYPE = (config->ENV_TYPE + 1) % env_count();
+    init_env(config);
+    reinit_simulation(config, false);
+}
 void init_point_vao(GLuint* vaoPoint, GLuint* pointVBO, GLuint* shaderPoint) {
     // 1) Generar VAO + VBO
     glGenVertexArrays(1, vaoPoint);
@@ -215,9 +422,13 @@ void init_point_vao(GLuint* vaoPoint, GLuint* pointVBO, GLuint* shaderPoint) {
     glBindVertexArray(*vaoPoint);
       glBindBuffer(GL_ARRAY_BUFFER, *pointVBO);
       glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES * sizeof(vec3), NULL, GL_DYNAMIC_DRAW);
-      // atributo 0 = posición
+      // atributo 0 = posición; en el plano llega como vec2 y el shader
+      // completa z = 0
       glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+      if (planar)
+          glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2), (void*)0);
+      else
+          glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
     glBindVertexArray(0);
 
     // 3) Compilar shader
@@ -233,8 +444,8 @@ void init_mesh_vao(GLuint* vaoMesh, GLuint* meshVBO, GLuint* meshEBO,
     glGenBuffers(1, meshEBO);
     glGenBuffers(1, instanceVBO);
 
-    // 2) Generar geometría de la esfera
-    Mesh particle_shape = mesh_generate_sphere(20, 20);
+    // 2) Generar geometría de la esfera (un disco en el plano)
+    Mesh particle_shape = planar ? mesh_generate_disc(24) : mesh_generate_sphere(20, 20);
     indexCount = particle_shape.indexCount;
 
     // 3) Configurar VAO
@@ -262,7 +473,10 @@ void init_mesh_vao(GLuint* vaoMesh, GLuint* meshVBO, GLuint* meshEBO,
       glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES * sizeof(vec3), NULL, GL_DYNAMIC_DRAW);
       // posición‑instancia (location = 2)
       glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+      if (planar)
+          glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vec2), (void*)0);
+      else
+          glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
       glVertexAttribDivisor(2, 1);  // cambia por instancia
 
     glBindVertexArray(0);
@@ -288,7 +502,17 @@ void update_buffers(Config* config, GLuint* pointVBO, GLuint* instanceVBO, int N
     glm_mat4_identity(model);
     glm_rotate(model, angle, (vec3){0.0f, 1.0f, 0.0f});
 
+    if (planar) {
+        // el plano se ve de frente: sin rotación, vec2 tal cual
+        planar_positions(planar, planar_buff);
+        glBindBuffer(GL_ARRAY_BUFFER, config->PARTICLE_TYPE == MESH_TYPE ? *instanceVBO : *pointVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, N * sizeof(vec2), planar_buff);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
     // —– Prepara tu array de posiciones —–
+    const Particles* particles = particle_sim_particles(sim);
     for (int i = 0; i < N; i++) {
         vec4 pos4 = { particles[i].current[0], particles[i].current[1], particles[i].current[2], 1.0f };
         vec4 rotated;
@@ -373,12 +597,12 @@ void render(GLFWwindow* window, Config *config, GLuint shaderPoint, GLuint shade
 void reset_buffer_pos(bool resetAll){
     vec4 pos4 = { 0.0f, 0.0f, 0.0f, 1.0f };
     if(resetAll){
-        for (size_t i = 0; i < activeCount; i++) {
+        for (int i = 0; i < particle_count(); i++) {
             glm_vec3_copy(pos4, positions_buff[i]);
         }
     }
     else{
-        for (size_t i = 0; i < activeCount; i++) {
+        for (int i = 0; i < particle_count(); i++) {
             glm_vec3_copy(pos4, positions_buff[i]);
         }
     }
@@ -387,26 +611,96 @@ void reset_buffer_pos(bool resetAll){
 void reinit_simulation(Config *config, bool resetAll){
     spawnTimer = 0.0f;
     reset_buffer_pos(resetAll);
+    if (planar) {
+        if (resetAll) {
+            planar_set_count(planar, 0);
+            planar_spawn(planar, config, config->INIT_PARTICLES);
+        }
+        return;
+    }
+    particle_sim_set_config(sim, config);
     if(resetAll){
-        activeCount = config->INIT_PARTICLES;
-        init_particles(particles, config);
+        particle_sim_set_count(sim, 0);
+        particle_sim_spawn(sim, config->INIT_PARTICLES);
     }
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     Camera* camera = (Camera*)glfwGetWindowUserPointer(window);
     if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
-        isPause = !isPause;
+        if (historyCursor >= 0) {
+            // Seguir simulando desde el frame que se está mirando
+            history_truncate(&history, historyCursor);
+            historyCursor = -1;
+        } else {
+            isPause = !isPause;
+        }
+    }
+    // Flechas: un frame hacia atrás/adelante, diez con shift
+    if ((key == GLFW_KEY_LEFT || key == GLFW_KEY_RIGHT) &&
+        (action == GLFW_PRESS || action == GLFW_REPEAT) && history_frames(&history) > 0) {
+        int frames = history_frames(&history);
+        int stride = (mods & GLFW_MOD_SHIFT) ? 10 : 1;
+        if (historyCursor < 0) historyCursor = frames - 1;
+        historyCursor += key == GLFW_KEY_LEFT ? -stride : stride;
+        if (historyCursor < 0) historyCursor = 0;
+        if (historyCursor >= frames) historyCursor = frames - 1;
+        int count = history_restore(&history, historyCursor, particle_sim_particles(sim));
+        if (count >= 0) particle_sim_set_count(sim, count);
     }
     if ((key == GLFW_KEY_ESCAPE || key == GLFW_KEY_Q) && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
     }
     if (key == GLFW_KEY_R && action == GLFW_PRESS) {
         load_config(&config, "data/config.txt");
+        if ((config.DIMENSIONS == 2) != (planar != NULL))
+            printf("DIMENSIONS cambia al reiniciar el programa\n");
+        force_fields_load(simulation_forces(), &config, "data/config.txt");
+        history_free(&history);
+        history_init(&history, planar ? 0 : (size_t)config.HISTORY_MB << 20, config.HISTORY_KEYFRAME,
+                     config.PARTICLE_RADIUS / 4096.0f);
+        historyCursor = -1;
         reinit_simulation(&config, true);
     }
 
+    // B: alterna la broadphase para comparar las dos en la misma escena
+    if (key == GLFW_KEY_B && action == GLFW_PRESS && sim) {
+        config.BROADPHASE = config.BROADPHASE == BROADPHASE_GRID ? BROADPHASE_SWEEP : BROADPHASE_GRID;
+        particle_sim_set_config(sim, &config);
+        printf("Broadphase: %s\n", config.BROADPHASE == BROADPHASE_GRID ? "grilla" : "barrido y poda");
+    }
+
+    // T: tela colgada de dos esquinas arriba del entorno
+    if (key == GLFW_KEY_T && action == GLFW_PRESS && sim && historyCursor < 0) {
+        const int side = 40;
+        float spacing = 2.2f * config.PARTICLE_RADIUS;
+        float half = 0.5f * spacing * (side - 1);
+        vec3 origin = { -half, 0.8f * config.ENV_SIZE, -half };
+        if (particle_sim_add_cloth(sim, origin, (vec3){1.0f, 0.0f, 0.0f}, (vec3){0.0f, 0.0f, 1.0f},
+                                   side, side, spacing, 1.0f, 1) < 0)
+            printf("No entra otra tela\n");
+    }
+
+    // G: granos rígidos de cuatro esferas en tetraedro
+    if (key == GLFW_KEY_G && action == GLFW_PRESS && sim && historyCursor < 0) {
+        const EnvInterface* env = env_get(config.ENV_TYPE);
+        float r = config.PARTICLE_RADIUS;
+        vec3 grain[4] = {
+            { r, r, r }, { r, -r, -r }, { -r, r, -r }, { -r, -r, r },
+        };
+        int added = 0;
+        for (int k = 0; k < 200 && env; k++) {
+            vec3 position;
+            env->spawn(&config, position);
+            if (particle_sim_add_body(sim, grain, NULL, 4, position, 1.0f, 0.0f) < 0) break;
+            added++;
+        }
+        if (added == 0) printf("No entran más granos\n");
+    }
+
     if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        history_clear(&history);
+        historyCursor = -1;
         change_env(&config);
     }
 }
@@ -460,6 +754,50 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera_process_scroll(camera, yoffset);
 }
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    (void)mods;
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
+        pick_particle(window, (Camera*)glfwGetWindowUserPointer(window));
+    }
+}
+
+// El cursor está oculto (cámara FPS): se elige la partícula del centro de
+// la pantalla
+void pick_particle(GLFWwindow* window, Camera* camera) {
+    int fbW, fbH;
+    glfwGetFramebufferSize(window, &fbW, &fbH);
+    vec3 origin, dir;
+    camera_screen_ray(camera, 0.0f, 0.0f, (float)fbW / (float)fbH, origin, dir);
+
+    if (planar) {
+        // el plano no rota: el rayo se corta con z = 0
+        if (fabsf(dir[2]) < 1e-6f) return;
+        float t = -origin[2] / dir[2];
+        float x = origin[0] + t * dir[0], y = origin[1] + t * dir[1];
+        int hit = planar_pick(planar, x, y);
+        if (hit >= 0) printf("Partícula %d en (%.3f, %.3f), distancia %.3f\n", hit, x, y, t);
+        return;
+    }
+
+    // Las partículas se dibujan rotadas (ver update_buffers): llevar el rayo
+    // al espacio de la simulación
+    mat4 inverse;
+    glm_mat4_identity(inverse);
+    glm_rotate(inverse, -glfwGetTime() * 0.1f, (vec3){0.0f, 1.0f, 0.0f});
+    glm_mat4_mulv3(inverse, origin, 1.0f, origin);
+    glm_mat4_mulv3(inverse, dir, 0.0f, dir);
+
+    float t;
+    int hit = particle_sim_raycast(sim, origin, dir, 100.0f, &t);
+    if (hit >= 0) {
+        const Particles* particles = particle_sim_particles(sim);
+        printf("Partícula %d en (%.3f, %.3f, %.3f), distancia %.3f\n", hit,
+               particles[hit].current[0], particles[hit].current[1],
+               particles[hit].current[2], t);
+    }
+}
+
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
   glViewport(0, 0, width, height);
 }
@@ -479,11 +817,24 @@ GLuint init_shader_program(const char *vertexPath, const char *fragmentPath) {
     return link_shader(vertexShader, fragmentShader);
 }
 
-void do_physics(Config* config, Particles* particles, double deltaTime, int activeParticles){
-    for (int i = 0; i < activeParticles; i++) {
-        update_physics(config, &particles[i], deltaTime);
-    }
-    resolve_collisions(particles, activeParticles);
+void do_physics(double deltaTime){
+    if (planar)
+        solverIterations = planar_step(planar, &config, &planarForces, deltaTime);
+    else
+        solverIterations = particle_sim_step(sim, deltaTime);
+}
+
+int particle_count(void) {
+    return planar ? planar_count(planar) : particle_sim_count(sim);
+}
+
+void spawn_particles(int n) {
+    if (planar) planar_spawn(planar, &config, n);
+    else particle_sim_spawn(sim, n);
+}
+
+ForceFieldSet* simulation_forces(void) {
+    return planar ? &planarForces : particle_sim_forces(sim);
 }
 
 void init_texture(GLuint shaderProgram, GLuint *tex, const char *path, const char *uniformName, int textureUnit) {
@@ -515,6 +866,7 @@ void set_up_callbacks(GLFWwindow* window, Camera* camera) {
     glfwSetWindowUserPointer(window, camera);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetKeyCallback(window, key_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
@@ -0,0 +1,127 @@
+#include "physics/compact.h"
+#include "physics/env.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Los límites del entorno se duplican: durante un paso las partículas
+// pueden salirse un poco antes de que el entorno las corrija
+#define COMPACT_MARGIN 2.0f
+
+int compact_format_init(CompactFormat* fmt, const Config* cfg) {
+    memset(fmt, 0, sizeof(*fmt));
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env) return 0;
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    float extent = 0.0f;
+    for (int a = 0; a < 3; a++) {
+        fmt->center[a] = 0.5f * (min[a] + max[a]);
+        if (max[a] - min[a] > extent) extent = max[a] - min[a];
+    }
+    // 2^32 unidades cubren el lado más largo con margen
+    fmt->quantum = extent * COMPACT_MARGIN / 4294967296.0f;
+    return fmt->quantum > 0.0f;
+}
+
+int compact_type(CompactFormat* fmt, float radius) {
+    for (int t = 0; t < fmt->typeCount; t++)
+        if (fmt->radii[t] == radius) return t;
+    if (fmt->typeCount >= COMPACT_MAX_TYPES) return -1;
+    fmt->radii[fmt->typeCount] = radius;
+    return fmt->typeCount++;
+}
+
+// IEEE 754 binary16 con redondeo al par más cercano
+uint16_t float_to_half(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000u);
+    uint32_t absx = x & 0x7fffffffu;
+
+    if (absx >= 0x7f800000u)  // inf o nan
+        return sign | 0x7c00u | (absx > 0x7f800000u ? 0x200u : 0u);
+    if (absx >= 0x477ff000u)  // redondea a más del máximo (65504)
+        return sign | 0x7c00u;
+    if (absx < 0x38800000u) {  // subnormal en half
+        if (absx < 0x33000000u) return sign;  // menos de la mitad del mínimo
+        uint32_t mant = (absx & 0x7fffffu) | 0x800000u;
+        int shift = 126 - (int)(absx >> 23);  // 14..24
+        uint32_t half = mant >> shift;
+        uint32_t rest = mant & ((1u << shift) - 1);
+        uint32_t mid = 1u << (shift - 1);
+        if (rest > mid || (rest == mid && (half & 1u))) half++;
+        return sign | (uint16_t)half;
+    }
+    uint32_t half = ((absx >> 13) - (112u << 10));
+    uint32_t rest = absx & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) half++;
+    return sign | (uint16_t)half;
+}
+
+float half_to_float(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1fu;
+    uint32_t mant = h & 0x3ffu;
+    uint32_t x;
+    if (exp == 0) {
+        if (mant == 0) {
+            x = sign;
+        } else {
+            // subnormal: normalizar
+            int e = -1;
+            do { mant <<= 1; e++; } while (!(mant & 0x400u));
+            x = sign | ((uint32_t)(112 - e) << 23) | ((mant & 0x3ffu) << 13);
+        }
+    } else if (exp == 31) {
+        x = sign | 0x7f800000u | (mant << 13);
+    } else {
+        x = sign | ((exp + 112u) << 23) | (mant << 13);
+    }
+    float f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+static inline int32_t to_fixed(float v, float center, float invQuantum) {
+    double q = floor((double)(v - center) * invQuantum + 0.5);
+    if (q > 2147483647.0) q = 2147483647.0;
+    if (q < -2147483648.0) q = -2147483648.0;
+    return (int32_t)q;
+}
+
+int compact_encode(CompactFormat* fmt, const Particles* p, int64_t count, CompactParticle* out) {
+    const double invQuantum = 1.0 / fmt->quantum;
+    int lastType = -1;
+    float lastRadius = 0.0f;
+    for (int64_t i = 0; i < count; i++) {
+        // los radios suelen repetirse: evitar buscar en la tabla cada vez
+        if (lastType < 0 || p[i].radius != lastRadius) {
+            lastType = compact_type(fmt, p[i].radius);
+            lastRadius = p[i].radius;
+            if (lastType < 0) {
+                fprintf(stderr, "Too many particle radii for the compact format (max %d)\n",
+                        COMPACT_MAX_TYPES);
+                return 0;
+            }
+        }
+        CompactParticle* c = &out[i];
+        for (int a = 0; a < 3; a++) {
+            c->pos[a] = to_fixed(p[i].current[a], fmt->center[a], (float)invQuantum);
+            c->step[a] = float_to_half(p[i].current[a] - p[i].previus[a]);
+        }
+        c->type = (uint16_t)lastType;
+    }
+    return 1;
+}
+
+void compact_decode(const CompactFormat* fmt, const CompactParticle* in, int64_t count, Particles* out) {
+    for (int64_t i = 0; i < count; i++) {
+        const CompactParticle* c = &in[i];
+        for (int a = 0; a < 3; a++) {
+            out[i].current[a] = fmt->center[a] + (float)c->pos[a] * fmt->quantum;
+            out[i].previus[a] = out[i].current[a] - half_to_float(c->step[a]);
+        }
+        out[i].radius = fmt->radii[c->type < COMPACT_MAX_TYPES ? c->type : 0];
+    }
+}
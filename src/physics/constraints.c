@@ -0,0 +1,257 @@
+#include "physics/constraints.h"
+#include "physics/grid.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int constraint_add(ConstraintSet* set, const Particles* p, int count,
+                   int a, int b, float rest, float stiffness) {
+    if (a < 0 || b < 0 || a >= count || b >= count || a == b) {
+        fprintf(stderr, "Invalid distance constraint %d-%d\n", a, b);
+        return 0;
+    }
+    if (set->count == set->capacity) {
+        int capacity = set->capacity > 0 ? set->capacity * 2 : 1024;
+        DistanceEdge* grown = realloc(set->edges, capacity * sizeof(DistanceEdge));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc constraints\n");
+            return 0;
+        }
+        set->edges = grown;
+        set->capacity = capacity;
+    }
+    if (rest < 0.0f) rest = glm_vec3_distance((float*)p[a].current, (float*)p[b].current);
+    DistanceEdge* e = &set->edges[set->count++];
+    e->a = a;
+    e->b = b;
+    e->rest = rest;
+    e->stiffness = fminf(fmaxf(stiffness, 0.0f), 1.0f);
+    set->dirty = 1;
+    return 1;
+}
+
+static int reserve_pinned(ConstraintSet* set, int count) {
+    if (count <= set->pinnedCapacity) return 1;
+    int capacity = set->pinnedCapacity > 0 ? set->pinnedCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+    unsigned char* grown = realloc(set->pinned, capacity);
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc constraint pins\n");
+        return 0;
+    }
+    memset(grown + set->pinnedCapacity, 0, capacity - set->pinnedCapacity);
+    set->pinned = grown;
+    set->pinnedCapacity = capacity;
+    return 1;
+}
+
+int constraint_pin(ConstraintSet* set, const Particles* p, int i) {
+    if (i < 0 || !reserve_pinned(set, i + 1)) return 0;
+    if (set->pinned[i]) return 1;
+    if (set->pinCount == set->pinCapacity) {
+        int capacity = set->pinCapacity > 0 ? set->pinCapacity * 2 : 64;
+        ConstraintPin* grown = realloc(set->pins, capacity * sizeof(ConstraintPin));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc constraint pins\n");
+            return 0;
+        }
+        set->pins = grown;
+        set->pinCapacity = capacity;
+    }
+    set->pins[set->pinCount].index = i;
+    glm_vec3_copy((float*)p[i].current, set->pins[set->pinCount].position);
+    set->pinCount++;
+    set->pinned[i] = 1;
+    return 1;
+}
+
+void constraint_truncate(ConstraintSet* set, int count) {
+    int kept = 0;
+    for (int e = 0; e < set->count; e++)
+        if (set->edges[e].a < count && set->edges[e].b < count)
+            set->edges[kept++] = set->edges[e];
+    if (kept != set->count) set->dirty = 1;
+    set->count = kept;
+
+    kept = 0;
+    for (int k = 0; k < set->pinCount; k++) {
+        if (set->pins[k].index < count) set->pins[kept++] = set->pins[k];
+        else set->pinned[set->pins[k].index] = 0;
+    }
+    set->pinCount = kept;
+}
+
+void constraint_free(ConstraintSet* set) {
+    free(set->edges);
+    free(set->pins);
+    free(set->pinned);
+    memset(set, 0, sizeof(*set));
+}
+
+// Coloreo goloso: cada arista toma el primer color que no usa ninguna de
+// sus dos partículas. Después un counting sort estable por color.
+static int color_edges(ConstraintSet* set, int count) {
+    uint64_t* used = calloc(count > 0 ? count : 1, sizeof(uint64_t));
+    unsigned char* color = malloc(set->count > 0 ? set->count : 1);
+    DistanceEdge* sorted = malloc((set->count > 0 ? set->count : 1) * sizeof(DistanceEdge));
+    if (!used || !color || !sorted) {
+        fprintf(stderr, "Failed to alloc constraint colors\n");
+        free(used);
+        free(color);
+        free(sorted);
+        return 0;
+    }
+
+    // sizes[CONSTRAINT_MAX_COLORS] es el lote en serie
+    int colors = 0;
+    int sizes[CONSTRAINT_MAX_COLORS + 1] = { 0 };
+    for (int e = 0; e < set->count; e++) {
+        uint64_t taken = used[set->edges[e].a] | used[set->edges[e].b];
+        int c = CONSTRAINT_MAX_COLORS;
+        if (~taken) {
+            c = __builtin_ctzll(~taken);
+            uint64_t bit = (uint64_t)1 << c;
+            used[set->edges[e].a] |= bit;
+            used[set->edges[e].b] |= bit;
+            if (c + 1 > colors) colors = c + 1;
+        }
+        color[e] = (unsigned char)c;
+        sizes[c]++;
+    }
+    // el lote en serie va justo después del último color
+    int cursor[CONSTRAINT_MAX_COLORS + 1];
+    set->colorStart[0] = 0;
+    for (int c = 0; c <= colors; c++) {
+        int size = c < colors ? sizes[c] : sizes[CONSTRAINT_MAX_COLORS];
+        cursor[c] = set->colorStart[c];
+        set->colorStart[c + 1] = set->colorStart[c] + size;
+    }
+    for (int e = 0; e < set->count; e++) {
+        int c = color[e] == CONSTRAINT_MAX_COLORS ? colors : color[e];
+        sorted[cursor[c]++] = set->edges[e];
+    }
+    memcpy(set->edges, sorted, set->count * sizeof(DistanceEdge));
+    set->colors = colors;
+    set->dirty = 0;
+    free(used);
+    free(color);
+    free(sorted);
+    return 1;
+}
+
+static void solve_edges(const ConstraintSet* set, Particles* p, int lo, int hi) {
+    const unsigned char* pinned = set->pinned;
+    int pinnedCount = set->pinnedCapacity;
+    for (int k = lo; k < hi; k++) {
+        const DistanceEdge* e = &set->edges[k];
+        Particles* pa = &p[e->a];
+        Particles* pb = &p[e->b];
+        // peso inverso a la masa; las fijas no se mueven
+        float ra = pa->radius, rb = pb->radius;
+        float wa = e->a < pinnedCount && pinned[e->a] ? 0.0f : 1.0f / (ra * ra * ra);
+        float wb = e->b < pinnedCount && pinned[e->b] ? 0.0f : 1.0f / (rb * rb * rb);
+        if (wa + wb <= 0.0f) continue;
+
+        // en el dominio periódico la arista une las imágenes más cercanas
+        vec3 delta;
+        glm_vec3_sub(pb->current, pa->current, delta);
+        minimum_image(delta);
+        float len = glm_vec3_norm(delta);
+        if (len <= 0.0f) continue;
+        float scale = e->stiffness * (len - e->rest) / (len * (wa + wb));
+        glm_vec3_muladds(delta, scale * wa, pa->current);
+        glm_vec3_muladds(delta, -scale * wb, pb->current);
+    }
+}
+
+typedef struct {
+    ConstraintSet* set;
+    Particles* p;
+} ConstraintJob;
+
+// index es la primera arista del bloque; termina en el bloque o en el
+// final del lote que lo contiene
+static void task_edges(void* arg, int lo) {
+    ConstraintJob* job = arg;
+    const int* start = job->set->colorStart;
+    int c = 0;
+    while (start[c + 1] <= lo) c++;
+    int hi = lo + CONSTRAINT_CHUNK < start[c + 1] ? lo + CONSTRAINT_CHUNK : start[c + 1];
+    solve_edges(job->set, job->p, lo, hi);
+}
+
+static void task_join(void* arg, int index) {
+    (void)arg;
+    (void)index;
+}
+
+// Arma el grafo: los bloques de un color esperan a la unión del color
+// anterior; los del lote en serie, además, uno al otro.
+static int schedule(ConstraintJob* job, int iterations, TaskPool* pool) {
+    const ConstraintSet* set = job->set;
+    int previous = -1;
+    for (int it = 0; it < iterations; it++) {
+        for (int c = 0; c <= set->colors; c++) {
+            int lo = set->colorStart[c], hi = set->colorStart[c + 1];
+            if (lo == hi) continue;
+            int serial = c == set->colors;
+            int first = -1, last = -1;
+            for (int k = lo; k < hi; k += CONSTRAINT_CHUNK) {
+                int t = task_add(pool, task_edges, job, k);
+                if (t < 0) return 0;
+                if (previous >= 0 && !task_depend(pool, t, previous)) return 0;
+                if (serial && last >= 0 && !task_depend(pool, t, last)) return 0;
+                if (first < 0) first = t;
+                last = t;
+            }
+            int join = task_add(pool, task_join, NULL, 0);
+            if (join < 0) return 0;
+            for (int t = first; t <= last; t++)
+                if (!task_depend(pool, join, t)) return 0;
+            previous = join;
+        }
+    }
+    return 1;
+}
+
+int constraint_solve(ConstraintSet* set, Particles* p, int count, int iterations,
+                     TaskPool* pool) {
+    if (set->count == 0 && set->pinCount == 0) return 1;
+    if (set->dirty && !color_edges(set, count)) return 0;
+
+    ConstraintJob job = { set, p };
+    int parallel = pool && task_pool_threads(pool) > 0 && set->count > CONSTRAINT_CHUNK;
+    if (parallel && !schedule(&job, iterations, pool)) {
+        task_pool_clear(pool);
+        parallel = 0;
+    }
+    if (parallel) {
+        task_pool_run(pool);
+    } else {
+        for (int it = 0; it < iterations; it++)
+            solve_edges(set, p, 0, set->count);
+    }
+
+    for (int k = 0; k < set->pinCount; k++) {
+        Particles* q = &p[set->pins[k].index];
+        glm_vec3_copy(set->pins[k].position, q->current);
+        glm_vec3_copy(set->pins[k].position, q->previus);
+    }
+    return 1;
+}
+
+float constraint_max_strain(const ConstraintSet* set, const Particles* p) {
+    float worst = 0.0f;
+    for (int k = 0; k < set->count; k++) {
+        const DistanceEdge* e = &set->edges[k];
+        if (e->rest <= 0.0f) continue;
+        vec3 delta;
+        glm_vec3_sub((float*)p[e->b].current, (float*)p[e->a].current, delta);
+        minimum_image(delta);
+        float len = glm_vec3_norm(delta);
+        worst = fmaxf(worst, fabsf(len - e->rest) / e->rest);
+    }
+    return worst;
+}
@@ -0,0 +1,90 @@
+#include "physics/kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Variantes que armó el makefile (PHYSICS_KERNEL_<isa>)
+extern const PhysicsKernels physics_kernels_generic;
+#ifdef PHYSICS_KERNEL_avx2
+extern const PhysicsKernels physics_kernels_avx2;
+#endif
+#ifdef PHYSICS_KERNEL_avx512
+extern const PhysicsKernels physics_kernels_avx512;
+#endif
+
+const PhysicsKernels* physicsKernels = &physics_kernels_generic;
+
+typedef struct {
+    const PhysicsKernels* kernels;
+    int (*supported)(void);
+} KernelVariant;
+
+static int always(void) { return 1; }
+#ifdef PHYSICS_KERNEL_avx2
+static int has_avx2(void) {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#endif
+#ifdef PHYSICS_KERNEL_avx512
+static int has_avx512(void) {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+           __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+#endif
+
+// De la mejor a la más portable
+static const KernelVariant variants[] = {
+#ifdef PHYSICS_KERNEL_avx512
+    { &physics_kernels_avx512, has_avx512 },
+#endif
+#ifdef PHYSICS_KERNEL_avx2
+    { &physics_kernels_avx2, has_avx2 },
+#endif
+    { &physics_kernels_generic, always },
+};
+#define VARIANT_COUNT ((int)(sizeof(variants) / sizeof(variants[0])))
+
+int physics_kernels_count(void) {
+    int n = 0;
+    for (int v = 0; v < VARIANT_COUNT; v++) n += variants[v].supported();
+    return n;
+}
+
+const PhysicsKernels* physics_kernels_get(int index) {
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (!variants[v].supported()) continue;
+        if (index-- == 0) return variants[v].kernels;
+    }
+    return NULL;
+}
+
+int physics_kernels_select(const char* name) {
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (strcmp(variants[v].kernels->name, name) != 0) continue;
+        if (!variants[v].supported()) {
+            fprintf(stderr, "CPU does not support %s kernels\n", name);
+            return 0;
+        }
+        physicsKernels = variants[v].kernels;
+        return 1;
+    }
+    fprintf(stderr, "Unknown kernel variant: %s\n", name);
+    return 0;
+}
+
+const char* physics_kernels_init(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+#endif
+    const char* forced = getenv("PHYSICS_ISA");
+    if (forced && physics_kernels_select(forced))
+        return physicsKernels->name;
+
+    for (int v = 0; v < VARIANT_COUNT; v++) {
+        if (variants[v].supported()) {
+            physicsKernels = variants[v].kernels;
+            break;
+        }
+    }
+    return physicsKernels->name;
+}
@@ -0,0 +1,297 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS, MAP_NORESERVE
+#define _POSIX_C_SOURCE 200809L
+#include "physics/domain.h"
+#include "physics/env.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Cabecera de la región compartida; detrás van las partículas: el estado
+// global (count), y por proceso una bandeja de migrantes y otra de halo
+// (count cada una, reservadas sin respaldo hasta que se tocan).
+typedef struct {
+    pthread_barrier_t barrier;
+    int workers;
+    int count;
+    int periodic;
+    float cuts[MAX_DOMAIN_WORKERS + 1];
+    int migrantCount[MAX_DOMAIN_WORKERS];
+    int haloCount[MAX_DOMAIN_WORKERS];
+    int histogram[MAX_DOMAIN_WORKERS][DOMAIN_BALANCE_BINS];
+    DomainWorkerStats stats[MAX_DOMAIN_WORKERS];
+} DomainShared;
+
+static DomainShared* shared;
+static Particles* globalParticles;
+static Particles* migrantBox;  // workers * count
+static Particles* haloBox;     // workers * count
+
+static inline Particles* migrants_of(int w) { return migrantBox + (size_t)w * shared->count; }
+static inline Particles* halo_of(int w)     { return haloBox    + (size_t)w * shared->count; }
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Dueño de una coordenada x: búsqueda binaria sobre los cortes; lo que
+// queda fuera de los extremos pertenece a la primera o última franja
+static int owner_of(float x) {
+    int lo = 0, hi = shared->workers - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (x >= shared->cuts[mid]) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+// Distancia de x a la franja w (0 si está dentro); en un dominio periódico
+// se toma la imagen más cercana
+static float slab_distance(float x, int w) {
+    float a = shared->cuts[w], b = shared->cuts[w + 1];
+    if (x >= a && x < b) return 0.0f;
+    if (!shared->periodic) return x < a ? a - x : x - b;
+    float period = shared->cuts[shared->workers] - shared->cuts[0];
+    float below = fmodf(a - x + period, period);
+    float above = fmodf(x - b + period, period);
+    return fminf(below, above);
+}
+
+// Reparte los cortes para que cada franja tenga la misma cantidad de
+// partículas según el histograma conjunto. Ninguna franja queda más
+// angosta que el halo.
+static void balance_cuts(float minWidth) {
+    int W = shared->workers;
+    float lo = shared->cuts[0], hi = shared->cuts[W];
+    float binWidth = (hi - lo) / DOMAIN_BALANCE_BINS;
+
+    long total = 0;
+    for (int r = 0; r < W; r++)
+        for (int b = 0; b < DOMAIN_BALANCE_BINS; b++)
+            total += shared->histogram[r][b];
+    if (total == 0) return;
+
+    long acc = 0;
+    int k = 1;
+    for (int b = 0; b < DOMAIN_BALANCE_BINS && k < W; b++) {
+        for (int r = 0; r < W; r++) acc += shared->histogram[r][b];
+        while (k < W && acc * W >= total * k) {
+            shared->cuts[k++] = lo + (b + 1) * binWidth;
+        }
+    }
+    for (; k < W; k++) shared->cuts[k] = hi;
+
+    for (int c = 1; c < W; c++)
+        shared->cuts[c] = fmaxf(shared->cuts[c], shared->cuts[c - 1] + minWidth);
+    for (int c = W - 1; c >= 1; c--)
+        shared->cuts[c] = fminf(shared->cuts[c], shared->cuts[c + 1] - minWidth);
+}
+
+static void worker_main(int rank, const Config* cfg, const ForceFieldSet* forces,
+                        const DomainOptions* opts) {
+    const int W = shared->workers;
+    const float halo = 2.0f * cfg->PARTICLE_RADIUS;
+    // Los índices locales cambian en cada paso (migrantes y fantasmas): el
+    // warm start no aplica
+    Config config = *cfg;
+    config.WARM_START = 0.0f;
+    ContactCache contacts;
+    memset(&contacts, 0, sizeof(contacts));
+
+    // Propias en [0, owned), fantasmas detrás. Entre las dos nunca superan
+    // el total de partículas.
+    Particles* local = malloc((size_t)shared->count * sizeof(Particles));
+    if (!local) {
+        fprintf(stderr, "Worker %d: failed to alloc particles\n", rank);
+        _exit(1);
+    }
+    int owned = 0;
+    for (int i = 0; i < shared->count; i++)
+        if (owner_of(globalParticles[i].current[0]) == rank)
+            local[owned++] = globalParticles[i];
+
+    DomainWorkerStats* stats = &shared->stats[rank];
+    memset(stats, 0, sizeof(*stats));
+    double start = now_seconds();
+
+    for (int step = 0; step < opts->steps; step++) {
+        if (opts->balanceInterval > 0 && step % opts->balanceInterval == 0) {
+            int* hist = shared->histogram[rank];
+            float lo = shared->cuts[0], hi = shared->cuts[W];
+            memset(hist, 0, DOMAIN_BALANCE_BINS * sizeof(int));
+            for (int i = 0; i < owned; i++) {
+                int b = (int)((local[i].current[0] - lo) / (hi - lo) * DOMAIN_BALANCE_BINS);
+                if (b < 0) b = 0;
+                if (b >= DOMAIN_BALANCE_BINS) b = DOMAIN_BALANCE_BINS - 1;
+                hist[b]++;
+            }
+            pthread_barrier_wait(&shared->barrier);
+            if (rank == 0) balance_cuts(halo);
+            pthread_barrier_wait(&shared->barrier);
+        }
+
+        integrate_particles(&config, forces, local, owned, opts->dt);
+
+        // Migrantes: salen de la lista propia (swap con la última)
+        Particles* outMigrants = migrants_of(rank);
+        int migrants = 0;
+        for (int i = 0; i < owned; ) {
+            if (owner_of(local[i].current[0]) != rank) {
+                outMigrants[migrants++] = local[i];
+                local[i] = local[--owned];
+            } else {
+                i++;
+            }
+        }
+        shared->migrantCount[rank] = migrants;
+
+        // Halo: propias a menos de un halo de algún borde de la franja
+        Particles* outHalo = halo_of(rank);
+        float a = shared->cuts[rank], b = shared->cuts[rank + 1];
+        int haloCount = 0;
+        for (int i = 0; i < owned; i++) {
+            float x = local[i].current[0];
+            if (x - a < halo || b - x <= halo)
+                outHalo[haloCount++] = local[i];
+        }
+        shared->haloCount[rank] = haloCount;
+
+        pthread_barrier_wait(&shared->barrier);
+
+        for (int w = 0; w < W; w++) {
+            if (w == rank) continue;
+            const Particles* in = migrants_of(w);
+            for (int i = 0; i < shared->migrantCount[w]; i++) {
+                if (owner_of(in[i].current[0]) == rank) {
+                    local[owned++] = in[i];
+                    stats->migratedIn++;
+                }
+            }
+        }
+        int ghosts = 0;
+        for (int w = 0; w < W; w++) {
+            if (w == rank) continue;
+            const Particles* in = halo_of(w);
+            for (int i = 0; i < shared->haloCount[w]; i++) {
+                if (slab_distance(in[i].current[0], rank) <= halo)
+                    local[owned + ghosts++] = in[i];
+            }
+        }
+        // Todos terminaron de leer las bandejas antes de que se reescriban
+        pthread_barrier_wait(&shared->barrier);
+
+        // Los fantasmas sólo aportan contactos: su dueño aplica su mitad de
+        // la misma corrección y lo que reciben acá se descarta
+        resolve_collisions_cached(&config, local, owned + ghosts, &contacts);
+        stats->ghosts = ghosts;
+    }
+
+    stats->owned = owned;
+    stats->cutMin = shared->cuts[rank];
+    stats->cutMax = shared->cuts[rank + 1];
+    stats->seconds = now_seconds() - start;
+
+    // Juntar el estado final en el arreglo global, por orden de proceso
+    pthread_barrier_wait(&shared->barrier);
+    int offset = 0;
+    for (int w = 0; w < rank; w++) offset += shared->stats[w].owned;
+    memcpy(globalParticles + offset, local, (size_t)owned * sizeof(Particles));
+
+    free(local);
+    contact_cache_free(&contacts);
+    // _exit: exit volvería a escribir los buffers de stdio heredados
+    _exit(0);
+}
+
+int domain_run(const Config* cfg, const ForceFieldSet* forces,
+               Particles* particles, int count,
+               const DomainOptions* opts, DomainWorkerStats* stats) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    int W = opts->workers;
+    if (!env || count <= 0) return 0;
+    if (W < 1 || W > MAX_DOMAIN_WORKERS) {
+        fprintf(stderr, "Domain workers must be in [1, %d]\n", MAX_DOMAIN_WORKERS);
+        return 0;
+    }
+
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    float halo = 2.0f * cfg->PARTICLE_RADIUS;
+    if ((max[0] - min[0]) < W * halo) {
+        fprintf(stderr, "Domain too narrow for %d slabs of width %.3f\n", W, halo);
+        return 0;
+    }
+
+    size_t particleBytes = (size_t)count * sizeof(Particles);
+    size_t headerBytes = (sizeof(DomainShared) + 63) & ~(size_t)63;
+    size_t bytes = headerBytes + particleBytes * (1 + 2 * (size_t)W);
+    void* region = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        perror("Error mapping domain memory");
+        return 0;
+    }
+    shared = region;
+    globalParticles = (Particles*)((char*)region + headerBytes);
+    migrantBox = globalParticles + count;
+    haloBox = migrantBox + (size_t)W * count;
+
+    shared->workers = W;
+    shared->count = count;
+    shared->periodic = env->periodic;
+    for (int c = 0; c <= W; c++)
+        shared->cuts[c] = min[0] + (max[0] - min[0]) * c / W;
+    memcpy(globalParticles, particles, particleBytes);
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&shared->barrier, &attr, W);
+    pthread_barrierattr_destroy(&attr);
+
+    pid_t pids[MAX_DOMAIN_WORKERS];
+    int started = 0;
+    // lo pendiente en stdio se copiaría en cada hijo
+    fflush(NULL);
+    for (; started < W; started++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Error forking domain worker");
+            break;
+        }
+        if (pid == 0) worker_main(started, cfg, forces, opts);
+        pids[started] = pid;
+    }
+    // Si un proceso no arrancó o murió, los demás quedarían esperando en
+    // la barrera: se terminan todos
+    int ok = started == W;
+    if (!ok)
+        for (int w = 0; w < started; w++) kill(pids[w], SIGKILL);
+    for (int alive = started; alive > 0; alive--) {
+        int status;
+        if (wait(&status) < 0) break;
+        if (ok && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+            ok = 0;
+            for (int w = 0; w < started; w++) kill(pids[w], SIGKILL);
+        }
+    }
+
+    if (ok) {
+        memcpy(particles, globalParticles, particleBytes);
+        memcpy(stats, shared->stats, W * sizeof(DomainWorkerStats));
+    } else {
+        fprintf(stderr, "Domain worker failed\n");
+    }
+    pthread_barrier_destroy(&shared->barrier);
+    munmap(region, bytes);
+    shared = NULL;
+    return ok;
+}
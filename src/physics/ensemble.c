@@ -0,0 +1,230 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS
+#define _POSIX_C_SOURCE 200809L
+#include "physics/ensemble.h"
+#include "physics/env.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+void ensemble_init(Ensemble* ens) {
+    memset(ens, 0, sizeof(*ens));
+}
+
+void ensemble_free(Ensemble* ens) {
+    for (int k = 0; k < ens->instanceCount; k++)
+        contact_cache_free(&ens->instances[k].contacts);
+    free(ens->particles);
+    free(ens->instances);
+    memset(ens, 0, sizeof(*ens));
+}
+
+static int reserve_particles(Ensemble* ens, int need) {
+    if (need <= ens->capacity) return 1;
+    int capacity = ens->capacity > 0 ? ens->capacity : 4096;
+    while (capacity < need) capacity *= 2;
+    Particles* grown = realloc(ens->particles, capacity * sizeof(Particles));
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc ensemble particles\n");
+        return 0;
+    }
+    ens->particles = grown;
+    ens->capacity = capacity;
+    return 1;
+}
+
+int ensemble_add(Ensemble* ens, const Config* cfg, int count) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env || count <= 0) return -1;
+    if (!reserve_particles(ens, ens->used + count)) return -1;
+    if (ens->instanceCount == ens->instanceCapacity) {
+        int capacity = ens->instanceCapacity > 0 ? ens->instanceCapacity * 2 : 16;
+        EnsembleInstance* grown = realloc(ens->instances, capacity * sizeof(EnsembleInstance));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc ensemble instances\n");
+            return -1;
+        }
+        ens->instances = grown;
+        ens->instanceCapacity = capacity;
+    }
+
+    EnsembleInstance* inst = &ens->instances[ens->instanceCount];
+    memset(inst, 0, sizeof(*inst));
+    inst->config = *cfg;
+    inst->begin = ens->used;
+    inst->count = count;
+    force_fields_from_config(&inst->forces, cfg);
+
+    Particles* p = ens->particles + inst->begin;
+    for (int i = 0; i < count; i++) {
+        env->spawn(cfg, p[i].current);
+        glm_vec3_copy(p[i].current, p[i].previus);
+        p[i].radius = cfg->PARTICLE_RADIUS;
+    }
+    ens->used += count;
+    return ens->instanceCount++;
+}
+
+int ensemble_load(Ensemble* ens, const Config* base, const char* filename) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening ensemble file");
+        return 0;
+    }
+
+    Config cfg = *base;
+    int pending = 0;  // partículas de la instancia abierta
+    int ok = 1;
+    char line[256];
+    while (ok && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || strlen(line) < 2) continue;
+
+        char key[64], value[128];
+        if (sscanf(line, "%63[^=]=%127[^\n]", key, value) != 2) continue;
+
+        trim(key);
+        trim(value);
+
+        if (strcmp(key, "INSTANCE") == 0) {
+            if (pending > 0) ok = ensemble_add(ens, &cfg, pending) >= 0;
+            cfg = *base;
+            pending = atoi(value);
+        } else if (!config_set(&cfg, key, value)) {
+            fprintf(stderr, "Unknown ensemble key: %s\n", key);
+        }
+    }
+    if (ok && pending > 0) ok = ensemble_add(ens, &cfg, pending) >= 0;
+
+    fclose(f);
+    return ok && ens->instanceCount > 0;
+}
+
+static void step_instance(Ensemble* ens, int k, float dt) {
+    EnsembleInstance* inst = &ens->instances[k];
+    Particles* p = ens->particles + inst->begin;
+    integrate_particles(&inst->config, &inst->forces, p, inst->count, dt);
+    inst->solverIterations =
+        resolve_collisions_cached(&inst->config, p, inst->count, &inst->contacts);
+}
+
+void ensemble_step(Ensemble* ens, float dt) {
+    for (int k = 0; k < ens->instanceCount; k++) step_instance(ens, k, dt);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// La instancia más grande que falta va al proceso con menos partículas
+static void assign_workers(const Ensemble* ens, int workers, int* owner) {
+    long load[MAX_ENSEMBLE_WORKERS] = { 0 };
+    for (int k = 0; k < ens->instanceCount; k++) owner[k] = -1;
+    for (int n = 0; n < ens->instanceCount; n++) {
+        int big = -1, light = 0;
+        for (int k = 0; k < ens->instanceCount; k++)
+            if (owner[k] < 0 && (big < 0 || ens->instances[k].count > ens->instances[big].count))
+                big = k;
+        for (int w = 1; w < workers; w++)
+            if (load[w] < load[light]) light = w;
+        owner[big] = light;
+        load[light] += ens->instances[big].count;
+    }
+}
+
+int ensemble_run(Ensemble* ens, float dt, int steps, int workers) {
+    double start = now_seconds();
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers > MAX_ENSEMBLE_WORKERS) workers = MAX_ENSEMBLE_WORKERS;
+    if (workers > ens->instanceCount) workers = ens->instanceCount;
+    if (workers <= 1) {
+        for (int s = 0; s < steps; s++) ensemble_step(ens, dt);
+        ens->seconds = now_seconds() - start;
+        return 1;
+    }
+
+    // Región compartida: el estado final de las partículas y las pasadas
+    // del último paso de cada instancia
+    size_t particleBytes = (size_t)ens->used * sizeof(Particles);
+    size_t bytes = particleBytes + ens->instanceCount * sizeof(int);
+    int* owner = malloc(ens->instanceCount * sizeof(int));
+    void* region = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (!owner || region == MAP_FAILED) {
+        fprintf(stderr, "Failed to alloc ensemble workers\n");
+        free(owner);
+        if (region != MAP_FAILED) munmap(region, bytes);
+        return 0;
+    }
+    Particles* result = region;
+    int* iterations = (int*)((char*)region + particleBytes);
+    assign_workers(ens, workers, owner);
+
+    // los hijos heredan los buffers de stdio: vaciarlos antes para que no
+    // se escriban dos veces
+    fflush(NULL);
+    int started = 0;
+    for (; started < workers; started++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Error forking ensemble worker");
+            break;
+        }
+        if (pid == 0) {
+            // cada instancia entera de una vez: no dependen entre sí
+            for (int k = 0; k < ens->instanceCount; k++) {
+                if (owner[k] != started) continue;
+                const EnsembleInstance* inst = &ens->instances[k];
+                for (int s = 0; s < steps; s++) step_instance(ens, k, dt);
+                memcpy(result + inst->begin, ens->particles + inst->begin,
+                       inst->count * sizeof(Particles));
+                iterations[k] = inst->solverIterations;
+            }
+            _exit(0);
+        }
+    }
+    int ok = started == workers;
+    for (int alive = started; alive > 0; alive--) {
+        int status;
+        if (wait(&status) < 0) break;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = 0;
+    }
+
+    if (ok) {
+        memcpy(ens->particles, result, particleBytes);
+        for (int k = 0; k < ens->instanceCount; k++) {
+            ens->instances[k].solverIterations = iterations[k];
+            // la caché quedó en el hijo: la de acá es de antes
+            ens->instances[k].contacts.count = 0;
+        }
+    } else {
+        fprintf(stderr, "Ensemble worker failed\n");
+    }
+    munmap(region, bytes);
+    free(owner);
+    ens->seconds = now_seconds() - start;
+    return ok;
+}
+
+void ensemble_print_stats(const Ensemble* ens) {
+    printf("%4s %8s %6s %7s %9s %6s %10s %12s\n",
+           "inst", "count", "radius", "restit", "gravity_y", "iter", "mean_y", "disp2");
+    for (int k = 0; k < ens->instanceCount; k++) {
+        const EnsembleInstance* inst = &ens->instances[k];
+        const Particles* p = ens->particles + inst->begin;
+        double meanY = 0.0, disp2 = 0.0;
+        for (int i = 0; i < inst->count; i++) {
+            vec3 d;
+            glm_vec3_sub((float*)p[i].current, (float*)p[i].previus, d);
+            meanY += p[i].current[1];
+            disp2 += glm_vec3_norm2(d);
+        }
+        printf("%4d %8d %6.3f %7.3f %9.3f %6d %10.4f %12.4e\n", k, inst->count,
+               inst->config.PARTICLE_RADIUS, inst->config.RESTITUTION,
+               inst->config.ACCELERATION[1], inst->solverIterations,
+               meanY / inst->count, disp2 / inst->count);
+    }
+}
@@ -0,0 +1,134 @@
+#include "physics/env.h"
+#include "physics/kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline float random_unit(void) {
+    return (float)rand() / RAND_MAX;
+}
+
+// ---------------------------------------------------------------- caja
+
+void collide_box(const Config* cfg, Particles* p, int count) {
+    physicsKernels->collide_box(cfg->ENV_SIZE, p, count);
+}
+
+static void box_bounds(const Config* cfg, vec3 min, vec3 max) {
+    glm_vec3_fill(min, -cfg->ENV_SIZE);
+    glm_vec3_fill(max,  cfg->ENV_SIZE);
+}
+
+static void box_spawn(const Config* cfg, vec3 out) {
+    float padding = cfg->ENV_SIZE * 0.4f;
+    float max_r = cfg->ENV_SIZE - padding;
+    for (int i = 0; i < 3; i++) {
+        out[i] = random_unit() * (2.0f * max_r) - max_r;
+    }
+}
+
+// -------------------------------------------------------------- esfera
+
+// Rebote contra la esfera de radio 2 * ENV_SIZE con pérdida de energía
+void collide_sphere(const Config* cfg, Particles* p, int count) {
+    physicsKernels->collide_sphere(2.0f * cfg->ENV_SIZE, p, count);
+}
+
+static void sphere_bounds(const Config* cfg, vec3 min, vec3 max) {
+    glm_vec3_fill(min, -2.0f * cfg->ENV_SIZE);
+    glm_vec3_fill(max,  2.0f * cfg->ENV_SIZE);
+}
+
+static void sphere_spawn(const Config* cfg, vec3 out) {
+    float padding = cfg->ENV_SIZE * 0.4f;
+    float max_r = cfg->ENV_SIZE - padding;
+    while (1) {
+        // Coordenadas x, y, z aleatorias en [-1,1] pero solo Y ≥ 0
+        float x = 2.0f * random_unit() - 1.0f;
+        float y =        random_unit();  // solo positivo
+        float z = 2.0f * random_unit() - 1.0f;
+
+        float r2 = x*x + y*y + z*z;
+        if (r2 <= 1.0f) {
+            // Distribución uniforme en el volumen usando raíz cúbica
+            float scale = cbrtf(random_unit());
+            out[0] = x * max_r * scale;
+            out[1] = y * max_r * scale;  // ya está en la parte superior
+            out[2] = z * max_r * scale;
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------- periódico
+
+// La partícula que sale por una cara entra por la opuesta. previus se
+// traslada igual para conservar la velocidad.
+void collide_periodic(const Config* cfg, Particles* p, int count) {
+    const float L = cfg->ENV_SIZE;
+    for (int k = 0; k < count; k++) {
+        for (int i = 0; i < 3; ++i) {
+            float shift = 0.0f;
+            if (p[k].current[i] < -L)      shift =  2.0f * L;
+            else if (p[k].current[i] >= L) shift = -2.0f * L;
+            p[k].current[i] += shift;
+            p[k].previus[i] += shift;
+        }
+    }
+}
+
+static void periodic_spawn(const Config* cfg, vec3 out) {
+    for (int i = 0; i < 3; i++) {
+        out[i] = (2.0f * random_unit() - 1.0f) * cfg->ENV_SIZE;
+    }
+}
+
+// ------------------------------------------------------------ registro
+
+// Los entornos incluidos ocupan los ids de EnvType
+static EnvInterface environments[MAX_ENVIRONMENTS] = {
+    [ENV_BOX]      = { "BOX",      0, collide_box,      box_bounds,    box_spawn,      NULL, NULL },
+    [ENV_SPHERE]   = { "SPHERE",   0, collide_sphere,   sphere_bounds, sphere_spawn,   NULL, NULL },
+    [ENV_PERIODIC] = { "PERIODIC", 1, collide_periodic, box_bounds,    periodic_spawn, NULL, NULL },
+};
+static int environmentCount = ENV_PERIODIC + 1;
+
+int env_register(const EnvInterface* env) {
+    if (!env->name || !env->collide || !env->bounds || !env->spawn) {
+        fprintf(stderr, "Environment needs name, collide, bounds and spawn\n");
+        return -1;
+    }
+    int existing = env_find(env->name);
+    if (existing >= 0) {
+        environments[existing] = *env;
+        return existing;
+    }
+    if (environmentCount >= MAX_ENVIRONMENTS) {
+        fprintf(stderr, "Too many environments (max %d)\n", MAX_ENVIRONMENTS);
+        return -1;
+    }
+    environments[environmentCount] = *env;
+    return environmentCount++;
+}
+
+int env_find(const char* name) {
+    for (int i = 0; i < environmentCount; i++)
+        if (strcmp(environments[i].name, name) == 0) return i;
+    return -1;
+}
+
+int env_count(void) {
+    return environmentCount;
+}
+
+const EnvInterface* env_get(int id) {
+    if (id < 0 || id >= environmentCount) return NULL;
+    return &environments[id];
+}
+
+void env_set_render(int id, void (*init)(const Config*), void (*render)(const Config*)) {
+    if (id < 0 || id >= environmentCount) return;
+    environments[id].init = init;
+    environments[id].render = render;
+}
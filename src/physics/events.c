@@ -0,0 +1,562 @@
+#include "physics/events.h"
+#include "physics/env.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EVENT_MAX_CELLS 128  // celdas por eje como máximo
+
+enum { EVENT_PAIR, EVENT_WALL, EVENT_CELL };
+enum { SHAPE_BOX, SHAPE_SPHERE, SHAPE_PERIODIC };
+
+typedef struct {
+    double r[3];
+    double v[3];
+    double t;             // tiempo de r y v
+    double lastHit;       // último choque (choques muy seguidos son elásticos)
+    double mass;
+    float radius;
+    unsigned int hits;    // eventos procesados: invalida los agendados antes
+    int cell;
+    int next, prev;       // lista de la celda
+} EventParticle;
+
+typedef struct {
+    double time;
+    int type;
+    int i;
+    int j;                // par: la otra partícula; celda: eje * 2 + lado
+    unsigned int hitsI, hitsJ;
+} Event;
+
+struct EventSim {
+    EventParticle* p;
+    int count;
+
+    Event* heap;
+    int heapCount;
+    int heapCapacity;
+
+    int* cellHead;
+    int cells[3];
+    double cellSize;
+    double origin[3];
+
+    int shape;
+    double bmin[3], bmax[3];
+    double sphereRadius;
+    double period;
+    double acc[3];
+    int accelerated;
+    double restitution;
+
+    double now;
+};
+
+// ---------------------------------------------------------------- cola
+
+static int heap_push(EventSim* sim, const Event* e) {
+    if (sim->heapCount == sim->heapCapacity) {
+        int capacity = sim->heapCapacity > 0 ? sim->heapCapacity * 2 : 4096;
+        Event* grown = realloc(sim->heap, (size_t)capacity * sizeof(Event));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc event queue\n");
+            return 0;
+        }
+        sim->heap = grown;
+        sim->heapCapacity = capacity;
+    }
+    int k = sim->heapCount++;
+    while (k > 0) {
+        int parent = (k - 1) / 2;
+        if (sim->heap[parent].time <= e->time) break;
+        sim->heap[k] = sim->heap[parent];
+        k = parent;
+    }
+    sim->heap[k] = *e;
+    return 1;
+}
+
+static Event heap_pop(EventSim* sim) {
+    Event top = sim->heap[0];
+    Event last = sim->heap[--sim->heapCount];
+    int n = sim->heapCount;
+    int k = 0;
+    while (1) {
+        int child = 2 * k + 1;
+        if (child >= n) break;
+        if (child + 1 < n && sim->heap[child + 1].time < sim->heap[child].time) child++;
+        if (last.time <= sim->heap[child].time) break;
+        sim->heap[k] = sim->heap[child];
+        k = child;
+    }
+    if (n > 0) sim->heap[k] = last;
+    return top;
+}
+
+// ------------------------------------------------------- trayectorias
+
+// Estado de i en el tiempo t (sin modificarlo)
+static inline void state_at(const EventSim* sim, const EventParticle* q, double t,
+                            double r[3], double v[3]) {
+    double dt = t - q->t;
+    for (int a = 0; a < 3; a++) {
+        r[a] = q->r[a] + q->v[a] * dt + 0.5 * sim->acc[a] * dt * dt;
+        v[a] = q->v[a] + sim->acc[a] * dt;
+    }
+}
+
+static inline void sync(EventSim* sim, EventParticle* q, double t) {
+    state_at(sim, q, t, q->r, q->v);
+    q->t = t;
+}
+
+static inline void min_image(const EventSim* sim, double d[3]) {
+    if (sim->shape != SHAPE_PERIODIC) return;
+    for (int a = 0; a < 3; a++)
+        d[a] -= sim->period * floor(d[a] / sim->period + 0.5);
+}
+
+// Menor t >= 0 con A t² + B t + C = 0 en el que la derivada tiene el signo
+// sign (+1 cruza hacia arriba, -1 hacia abajo); INFINITY si no hay
+static double first_crossing(double A, double B, double C, int sign) {
+    double roots[2];
+    int n = 0;
+    if (A == 0.0) {
+        if (B != 0.0) roots[n++] = -C / B;
+    } else {
+        double disc = B * B - 4.0 * A * C;
+        if (disc < 0.0) return INFINITY;
+        double sq = sqrt(disc);
+        double q = -0.5 * (B + (B >= 0.0 ? sq : -sq));
+        if (q != 0.0) {
+            roots[n++] = q / A;
+            roots[n++] = C / q;
+        } else {
+            roots[n++] = 0.0;
+        }
+    }
+    double best = INFINITY;
+    for (int k = 0; k < n; k++) {
+        double t = roots[k];
+        if (t >= 0.0 && t < best && sign * (2.0 * A * t + B) > 0.0) best = t;
+    }
+    return best;
+}
+
+// --------------------------------------------------------------- celdas
+
+static inline int cell_index(const EventSim* sim, const int c[3]) {
+    return c[0] + sim->cells[0] * (c[1] + sim->cells[1] * c[2]);
+}
+
+static inline void cell_coords(const EventSim* sim, int cell, int c[3]) {
+    c[0] = cell % sim->cells[0];
+    c[1] = (cell / sim->cells[0]) % sim->cells[1];
+    c[2] = cell / (sim->cells[0] * sim->cells[1]);
+}
+
+static void cell_insert(EventSim* sim, int i, int cell) {
+    EventParticle* q = &sim->p[i];
+    q->cell = cell;
+    q->prev = -1;
+    q->next = sim->cellHead[cell];
+    if (q->next >= 0) sim->p[q->next].prev = i;
+    sim->cellHead[cell] = i;
+}
+
+static void cell_remove(EventSim* sim, int i) {
+    EventParticle* q = &sim->p[i];
+    if (q->prev >= 0) sim->p[q->prev].next = q->next;
+    else sim->cellHead[q->cell] = q->next;
+    if (q->next >= 0) sim->p[q->next].prev = q->prev;
+}
+
+static int locate(const EventSim* sim, const double r[3]) {
+    int c[3];
+    for (int a = 0; a < 3; a++) {
+        c[a] = (int)floor((r[a] - sim->origin[a]) / sim->cellSize);
+        if (c[a] < 0) c[a] = 0;
+        if (c[a] >= sim->cells[a]) c[a] = sim->cells[a] - 1;
+    }
+    return cell_index(sim, c);
+}
+
+// ----------------------------------------------------------- predicción
+
+static int predict_pair(EventSim* sim, int i, int j) {
+    EventParticle* a = &sim->p[i];
+    EventParticle* b = &sim->p[j];
+    double ra[3], va[3], rb[3], vb[3], dr[3], dv[3];
+    state_at(sim, a, sim->now, ra, va);
+    state_at(sim, b, sim->now, rb, vb);
+    for (int k = 0; k < 3; k++) {
+        dr[k] = rb[k] - ra[k];
+        dv[k] = vb[k] - va[k];  // la aceleración uniforme se cancela
+    }
+    min_image(sim, dr);
+    double bdot = dr[0] * dv[0] + dr[1] * dv[1] + dr[2] * dv[2];
+    if (bdot >= 0.0) return 1;  // se alejan
+    double sigma = (double)a->radius + b->radius;
+    double c = dr[0] * dr[0] + dr[1] * dr[1] + dr[2] * dr[2] - sigma * sigma;
+    double t;
+    if (c <= 0.0) {
+        t = 0.0;  // solapadas y acercándose: chocan ya
+    } else {
+        double vv = dv[0] * dv[0] + dv[1] * dv[1] + dv[2] * dv[2];
+        double disc = bdot * bdot - vv * c;
+        if (disc < 0.0) return 1;
+        t = c / (-bdot + sqrt(disc));
+    }
+    Event e = { sim->now + t, EVENT_PAIR, i, j, a->hits, b->hits };
+    return heap_push(sim, &e);
+}
+
+static int predict_wall(EventSim* sim, int i) {
+    EventParticle* q = &sim->p[i];
+    double r[3], v[3];
+    state_at(sim, q, sim->now, r, v);
+    double t = INFINITY;
+
+    if (sim->shape == SHAPE_BOX) {
+        for (int a = 0; a < 3; a++) {
+            double lo = sim->bmin[a] + q->radius, hi = sim->bmax[a] - q->radius;
+            double A = 0.5 * sim->acc[a];
+            double up = first_crossing(A, v[a], r[a] - hi, 1);
+            double down = first_crossing(A, v[a], r[a] - lo, -1);
+            if (up < t) t = up;
+            if (down < t) t = down;
+        }
+    } else if (sim->shape == SHAPE_SPHERE) {
+        double limit = sim->sphereRadius - q->radius;
+        double rr = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        double rv = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+        double vv = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+        if (!sim->accelerated) {
+            // |r + v t| = limit, la raíz de salida
+            if (vv > 0.0) {
+                double c = rr - limit * limit;
+                double disc = rv * rv - vv * c;
+                if (disc >= 0.0) t = fmax(0.0, (-rv + sqrt(disc)) / vv);
+            }
+        } else {
+            // Con aceleración la condición es de cuarto grado: se avanza de
+            // forma conservadora (lo más rápido que puede cerrar la
+            // distancia) y al llegar se vuelve a mirar
+            double gap = limit - sqrt(rr);
+            double eps = 1e-9 * sim->sphereRadius;
+            if (gap <= eps) {
+                t = rv > 0.0 ? 0.0 : eps / (sqrt(vv) + 1e-12);
+            } else {
+                double speed = sqrt(vv);
+                double accel = sqrt(sim->acc[0] * sim->acc[0] + sim->acc[1] * sim->acc[1] +
+                                    sim->acc[2] * sim->acc[2]);
+                t = (-speed + sqrt(speed * speed + 2.0 * accel * gap)) / accel;
+            }
+        }
+    }
+    if (t == INFINITY) return 1;
+    Event e = { sim->now + t, EVENT_WALL, i, -1, q->hits, 0 };
+    return heap_push(sim, &e);
+}
+
+static int predict_cell(EventSim* sim, int i) {
+    EventParticle* q = &sim->p[i];
+    double r[3], v[3];
+    state_at(sim, q, sim->now, r, v);
+    int c[3];
+    cell_coords(sim, q->cell, c);
+    double best = INFINITY;
+    int face = -1;
+    for (int a = 0; a < 3; a++) {
+        double lo = sim->origin[a] + c[a] * sim->cellSize;
+        double hi = lo + sim->cellSize;
+        double A = 0.5 * sim->acc[a];
+        // en los bordes de una grilla sin período no hay a dónde cruzar
+        int periodic = sim->shape == SHAPE_PERIODIC;
+        if (periodic || c[a] + 1 < sim->cells[a]) {
+            double t = first_crossing(A, v[a], r[a] - hi, 1);
+            if (t < best) { best = t; face = 2 * a + 1; }
+        }
+        if (periodic || c[a] > 0) {
+            double t = first_crossing(A, v[a], r[a] - lo, -1);
+            if (t < best) { best = t; face = 2 * a; }
+        }
+    }
+    if (face < 0) return 1;
+    Event e = { sim->now + best, EVENT_CELL, i, face, q->hits, 0 };
+    return heap_push(sim, &e);
+}
+
+// Todos los eventos de i. Con pairsAfter sólo los pares con j > i (para
+// no repetirlos al reconstruir la cola).
+static int predict(EventSim* sim, int i, int pairsAfter) {
+    if (!predict_wall(sim, i) || !predict_cell(sim, i)) return 0;
+    int c[3];
+    cell_coords(sim, sim->p[i].cell, c);
+    int periodic = sim->shape == SHAPE_PERIODIC;
+    for (int dz = -1; dz <= 1; dz++)
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++) {
+        int n[3] = { c[0] + dx, c[1] + dy, c[2] + dz };
+        int inside = 1;
+        for (int a = 0; a < 3; a++) {
+            if (periodic) n[a] = (n[a] + sim->cells[a]) % sim->cells[a];
+            else if (n[a] < 0 || n[a] >= sim->cells[a]) inside = 0;
+        }
+        if (!inside) continue;
+        for (int j = sim->cellHead[cell_index(sim, n)]; j >= 0; j = sim->p[j].next) {
+            if (j == i || (pairsAfter && j < i)) continue;
+            if (!predict_pair(sim, i, j)) return 0;
+        }
+    }
+    return 1;
+}
+
+// Vacía la cola y vuelve a predecir todo desde now
+static int rebuild_queue(EventSim* sim) {
+    sim->heapCount = 0;
+    for (int i = 0; i < sim->count; i++) {
+        sync(sim, &sim->p[i], sim->now);
+        sim->p[i].hits++;
+    }
+    for (int i = 0; i < sim->count; i++)
+        if (!predict(sim, i, 1)) return 0;
+    return 1;
+}
+
+// ------------------------------------------------------------- eventos
+
+static void collide_pair(EventSim* sim, int i, int j) {
+    EventParticle* a = &sim->p[i];
+    EventParticle* b = &sim->p[j];
+    double n[3], dv[3], dist2 = 0.0, vn = 0.0;
+    for (int k = 0; k < 3; k++) n[k] = b->r[k] - a->r[k];
+    min_image(sim, n);
+    for (int k = 0; k < 3; k++) dist2 += n[k] * n[k];
+    if (dist2 <= 0.0) return;
+    double inv = 1.0 / sqrt(dist2);
+    for (int k = 0; k < 3; k++) {
+        n[k] *= inv;
+        dv[k] = b->v[k] - a->v[k];
+        vn += dv[k] * n[k];
+    }
+    if (vn >= 0.0) return;
+    // choques muy seguidos (colapso inelástico) pasan a ser elásticos
+    double e = (sim->now - a->lastHit < EVENT_TC || sim->now - b->lastHit < EVENT_TC)
+             ? 1.0 : sim->restitution;
+    double impulse = -(1.0 + e) * vn * a->mass * b->mass / (a->mass + b->mass);
+    for (int k = 0; k < 3; k++) {
+        a->v[k] -= impulse / a->mass * n[k];
+        b->v[k] += impulse / b->mass * n[k];
+    }
+    a->lastHit = b->lastHit = sim->now;
+}
+
+// Devuelve 0 si el evento era sólo para volver a mirar (esfera con
+// aceleración todavía lejos de la pared)
+static int collide_wall(EventSim* sim, int i) {
+    EventParticle* q = &sim->p[i];
+    if (sim->shape == SHAPE_BOX) {
+        // rebote simple como collide_box: se invierte la componente
+        for (int a = 0; a < 3; a++) {
+            double lo = sim->bmin[a] + q->radius, hi = sim->bmax[a] - q->radius;
+            double eps = 1e-9 * (hi - lo);
+            if (q->r[a] >= hi - eps && q->v[a] > 0.0) { q->r[a] = hi; q->v[a] = -q->v[a]; }
+            if (q->r[a] <= lo + eps && q->v[a] < 0.0) { q->r[a] = lo; q->v[a] = -q->v[a]; }
+        }
+        return 1;
+    }
+    double limit = sim->sphereRadius - q->radius;
+    double dist = sqrt(q->r[0] * q->r[0] + q->r[1] * q->r[1] + q->r[2] * q->r[2]);
+    double vr = (q->r[0] * q->v[0] + q->r[1] * q->v[1] + q->r[2] * q->v[2]) / dist;
+    if (dist < limit - 1e-9 * sim->sphereRadius || vr <= 0.0) return 0;
+    // reflejar con pérdida de energía como collide_sphere
+    double damping = sim->now - q->lastHit < EVENT_TC ? 1.0 : 0.9;
+    for (int a = 0; a < 3; a++) {
+        double n = q->r[a] / dist;
+        q->r[a] = n * limit;
+        q->v[a] = damping * (q->v[a] - 2.0 * vr * n);
+    }
+    q->lastHit = sim->now;
+    return 1;
+}
+
+static void cross_cell(EventSim* sim, int i, int face) {
+    EventParticle* q = &sim->p[i];
+    int axis = face / 2, dir = (face & 1) ? 1 : -1;
+    int c[3];
+    cell_coords(sim, q->cell, c);
+    c[axis] += dir;
+    if (c[axis] < 0 || c[axis] >= sim->cells[axis]) {
+        // sólo en el período: la partícula reaparece del otro lado
+        c[axis] = (c[axis] + sim->cells[axis]) % sim->cells[axis];
+        q->r[axis] -= dir * sim->period;
+    }
+    cell_remove(sim, i);
+    cell_insert(sim, i, cell_index(sim, c));
+}
+
+// ------------------------------------------------------------------ API
+
+EventSim* event_sim_create(const Config* cfg, const ForceFieldSet* forces,
+                           const Particles* p, int count, float dt) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    vec3 acc;
+    if (!env || count <= 0 || dt <= 0.0f) return NULL;
+    if (!force_fields_uniform(forces, acc) || forces->particleAcceleration) {
+        fprintf(stderr, "Event-driven mode needs uniform force fields\n");
+        return NULL;
+    }
+    int shape = env->periodic ? SHAPE_PERIODIC
+              : cfg->ENV_TYPE == ENV_BOX ? SHAPE_BOX
+              : cfg->ENV_TYPE == ENV_SPHERE ? SHAPE_SPHERE : -1;
+    if (shape < 0) {
+        fprintf(stderr, "Event-driven mode supports BOX, SPHERE and PERIODIC only\n");
+        return NULL;
+    }
+
+    EventSim* sim = calloc(1, sizeof(EventSim));
+    if (!sim) return NULL;
+    sim->shape = shape;
+    sim->restitution = cfg->RESTITUTION;
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    float maxRadius = 0.0f;
+    for (int i = 0; i < count; i++)
+        if (p[i].radius > maxRadius) maxRadius = p[i].radius;
+    for (int a = 0; a < 3; a++) {
+        sim->bmin[a] = min[a];
+        sim->bmax[a] = max[a];
+        sim->acc[a] = acc[a];
+        if (acc[a] != 0.0f) sim->accelerated = 1;
+    }
+    sim->sphereRadius = max[0];
+    sim->period = max[0] - min[0];
+
+    // Celdas de al menos un diámetro: los pares posibles están en las 27
+    // vecinas. Más chicas sólo agregan cruces de celda; se apunta a una
+    // partícula cada pocas celdas. En el período entra un número entero
+    // (y al menos 3).
+    double extent = max[0] - min[0];
+    for (int a = 1; a < 3; a++) extent = fmax(extent, max[a] - min[a]);
+    double perAxis = fmin(fmax(2.0 * cbrt((double)count), 1.0), EVENT_MAX_CELLS);
+    double cellSize = fmax(2.0 * maxRadius, extent / perAxis);
+    for (int a = 0; a < 3; a++) {
+        sim->origin[a] = min[a];
+        sim->cells[a] = shape == SHAPE_PERIODIC
+                      ? (int)floor((max[a] - min[a]) / cellSize)
+                      : (int)ceil((max[a] - min[a]) / cellSize);
+        if (sim->cells[a] < 1) sim->cells[a] = 1;
+    }
+    if (shape == SHAPE_PERIODIC) {
+        if (sim->cells[0] < 3) {
+            fprintf(stderr, "Periodic domain too small for the event-driven cells\n");
+            free(sim);
+            return NULL;
+        }
+        cellSize = sim->period / sim->cells[0];
+        sim->cells[1] = sim->cells[2] = sim->cells[0];
+    }
+    sim->cellSize = cellSize;
+
+    int cells = sim->cells[0] * sim->cells[1] * sim->cells[2];
+    sim->cellHead = malloc((size_t)cells * sizeof(int));
+    sim->p = calloc((size_t)count, sizeof(EventParticle));
+    if (!sim->cellHead || !sim->p) {
+        fprintf(stderr, "Failed to alloc event-driven simulation\n");
+        event_sim_destroy(sim);
+        return NULL;
+    }
+    for (int c = 0; c < cells; c++) sim->cellHead[c] = -1;
+
+    sim->count = count;
+    for (int i = 0; i < count; i++) {
+        EventParticle* q = &sim->p[i];
+        for (int a = 0; a < 3; a++) {
+            q->r[a] = p[i].current[a];
+            q->v[a] = (p[i].current[a] - p[i].previus[a]) / dt;
+        }
+        q->radius = p[i].radius;
+        q->mass = (double)q->radius * q->radius * q->radius;
+        q->lastHit = -INFINITY;
+        cell_insert(sim, i, locate(sim, q->r));
+    }
+    if (!rebuild_queue(sim)) {
+        event_sim_destroy(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+void event_sim_destroy(EventSim* sim) {
+    if (!sim) return;
+    free(sim->p);
+    free(sim->heap);
+    free(sim->cellHead);
+    free(sim);
+}
+
+long event_sim_advance(EventSim* sim, double dt) {
+    const double end = sim->now + dt;
+    const long budget = (long)EVENT_MAX_PER_PARTICLE * sim->count + 1024;
+    long events = 0;
+
+    while (sim->heapCount > 0 && sim->heap[0].time <= end) {
+        Event e = heap_pop(sim);
+        EventParticle* a = &sim->p[e.i];
+        if (e.hitsI != a->hits) continue;
+        if (e.type == EVENT_PAIR && e.hitsJ != sim->p[e.j].hits) continue;
+
+        sim->now = e.time;
+        sync(sim, a, sim->now);
+        int ok = 1;
+        if (e.type == EVENT_PAIR) {
+            EventParticle* b = &sim->p[e.j];
+            sync(sim, b, sim->now);
+            collide_pair(sim, e.i, e.j);
+            a->hits++;
+            b->hits++;
+            ok = predict(sim, e.i, 0) && predict(sim, e.j, 0);
+        } else if (e.type == EVENT_WALL) {
+            if (collide_wall(sim, e.i)) {
+                a->hits++;
+                ok = predict(sim, e.i, 0);
+            } else {
+                ok = predict_wall(sim, e.i);
+            }
+        } else {
+            cross_cell(sim, e.i, e.j);
+            a->hits++;
+            ok = predict(sim, e.i, 0);
+        }
+        events++;
+
+        // La cola acumula eventos invalidados: se rehace si crece demasiado
+        if (ok && sim->heapCount > 32 * sim->count + 4096) ok = rebuild_queue(sim);
+        // Sin memoria para la cola faltan choques por predecir, y con
+        // demasiados choques ya no es un sistema diluido: el estado queda
+        // en sim->now para exportarlo y seguir con paso fijo
+        if (!ok || events > budget) return -1;
+    }
+    sim->now = end;
+    if (sim->heapCount > 0 && sim->heap[0].time < end && !rebuild_queue(sim)) return -1;
+    return events;
+}
+
+void event_sim_export(EventSim* sim, Particles* p, float dt) {
+    for (int i = 0; i < sim->count; i++) {
+        double r[3], v[3];
+        state_at(sim, &sim->p[i], sim->now, r, v);
+        for (int a = 0; a < 3; a++) {
+            p[i].current[a] = (float)r[a];
+            p[i].previus[a] = (float)(r[a] - v[a] * dt);
+        }
+        p[i].radius = sim->p[i].radius;
+    }
+}
+
+double event_sim_time(const EventSim* sim) {
+    return sim->now;
+}
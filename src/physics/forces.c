@@ -0,0 +1,220 @@
+#include "physics/forces.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Grillas cargadas desde el archivo de configuración (son dueñas de data)
+static VectorGrid loadedGrids[MAX_FORCE_FIELDS];
+static int loadedGridCount = 0;
+
+void force_fields_clear(ForceFieldSet* set) {
+    set->count = 0;
+}
+
+int force_fields_add(ForceFieldSet* set, const ForceField* field) {
+    if (set->count >= MAX_FORCE_FIELDS) {
+        fprintf(stderr, "Too many force fields (max %d)\n", MAX_FORCE_FIELDS);
+        return 0;
+    }
+    set->fields[set->count++] = *field;
+    return 1;
+}
+
+void force_fields_from_config(ForceFieldSet* set, const Config* cfg) {
+    force_fields_clear(set);
+    ForceField gravity = { .type = FORCE_UNIFORM };
+    glm_vec3_copy((float*)cfg->ACCELERATION, gravity.vector);
+    force_fields_add(set, &gravity);
+}
+
+int force_fields_load(ForceFieldSet* set, const Config* cfg, const char* filename) {
+    for (int g = 0; g < loadedGridCount; g++)
+        vector_grid_free(&loadedGrids[g]);
+    loadedGridCount = 0;
+    force_fields_from_config(set, cfg);
+
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("Error opening config file");
+        return 0;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || strlen(line) < 2) continue;
+
+        char key[64], value[128];
+        if (sscanf(line, "%63[^=]=%127[^\n]", key, value) != 2) continue;
+
+        trim(key);
+        trim(value);
+
+        ForceField field;
+        memset(&field, 0, sizeof(field));
+        if (strcmp(key, "ATTRACTOR") == 0) {
+            // x y z intensidad suavizado
+            field.type = FORCE_ATTRACTOR;
+            if (sscanf(value, "%f %f %f %f %f", &field.vector[0], &field.vector[1],
+                       &field.vector[2], &field.strength, &field.radius) < 4) {
+                fprintf(stderr, "Bad ATTRACTOR: %s\n", value);
+                continue;
+            }
+            force_fields_add(set, &field);
+        } else if (strcmp(key, "VORTEX") == 0) {
+            // cx cy cz ax ay az intensidad radio
+            field.type = FORCE_VORTEX;
+            if (sscanf(value, "%f %f %f %f %f %f %f %f",
+                       &field.vector[0], &field.vector[1], &field.vector[2],
+                       &field.axis[0], &field.axis[1], &field.axis[2],
+                       &field.strength, &field.radius) != 8) {
+                fprintf(stderr, "Bad VORTEX: %s\n", value);
+                continue;
+            }
+            glm_vec3_normalize(field.axis);
+            force_fields_add(set, &field);
+        } else if (strcmp(key, "DRAG") == 0) {
+            field.type = FORCE_DRAG;
+            if (sscanf(value, "%f %f %f", &field.vector[0], &field.vector[1], &field.vector[2]) != 3) {
+                fprintf(stderr, "Bad DRAG: %s\n", value);
+                continue;
+            }
+            force_fields_add(set, &field);
+        } else if (strcmp(key, "FORCE_GRID") == 0) {
+            // ruta intensidad
+            char path[128];
+            field.type = FORCE_GRID;
+            field.strength = 1.0f;
+            if (sscanf(value, "%127s %f", path, &field.strength) < 1 ||
+                loadedGridCount >= MAX_FORCE_FIELDS ||
+                !vector_grid_load(&loadedGrids[loadedGridCount], path)) {
+                fprintf(stderr, "Bad FORCE_GRID: %s\n", value);
+                continue;
+            }
+            field.grid = &loadedGrids[loadedGridCount++];
+            force_fields_add(set, &field);
+        }
+    }
+
+    fclose(f);
+    return 1;
+}
+
+int force_fields_uniform(const ForceFieldSet* set, vec3 out) {
+    glm_vec3_zero(out);
+    for (int k = 0; k < set->count; k++) {
+        if (set->fields[k].type != FORCE_UNIFORM) return 0;
+        glm_vec3_add(out, (float*)set->fields[k].vector, out);
+    }
+    return 1;
+}
+
+void force_fields_eval(const ForceFieldSet* set, const vec3 pos, const vec3 vel, vec3 out) {
+    glm_vec3_zero(out);
+    for (int k = 0; k < set->count; k++) {
+        const ForceField* field = &set->fields[k];
+        switch (field->type) {
+            case FORCE_UNIFORM:
+                glm_vec3_add(out, (float*)field->vector, out);
+                break;
+            case FORCE_ATTRACTOR: {
+                vec3 d;
+                glm_vec3_sub((float*)field->vector, (float*)pos, d);
+                float r2 = glm_vec3_norm2(d) + field->radius * field->radius;
+                if (r2 <= 0.0f) break;
+                float inv = field->strength / (r2 * sqrtf(r2));
+                glm_vec3_muladds(d, inv, out);
+                break;
+            }
+            case FORCE_VORTEX: {
+                // aceleración tangente al círculo alrededor del eje
+                vec3 d, tangent;
+                glm_vec3_sub((float*)pos, (float*)field->vector, d);
+                glm_vec3_cross((float*)field->axis, d, tangent);
+                float r2 = glm_vec3_norm2(tangent);
+                float falloff = 1.0f / (1.0f + r2 / (field->radius * field->radius + 1e-6f));
+                glm_vec3_muladds(tangent, field->strength * falloff, out);
+                break;
+            }
+            case FORCE_DRAG:
+                out[0] -= field->vector[0] * vel[0];
+                out[1] -= field->vector[1] * vel[1];
+                out[2] -= field->vector[2] * vel[2];
+                break;
+            case FORCE_GRID: {
+                vec3 sample;
+                vector_grid_sample(field->grid, pos, sample);
+                glm_vec3_muladds(sample, field->strength, out);
+                break;
+            }
+        }
+    }
+}
+
+// Formato: "nx ny nz", "minx miny minz maxx maxy maxz" y luego nx*ny*nz
+// vectores "vx vy vz" con x variando más rápido
+int vector_grid_load(VectorGrid* grid, const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror("Error opening force grid");
+        return 0;
+    }
+    memset(grid, 0, sizeof(*grid));
+    if (fscanf(f, "%d %d %d", &grid->dims[0], &grid->dims[1], &grid->dims[2]) != 3 ||
+        fscanf(f, "%f %f %f %f %f %f", &grid->min[0], &grid->min[1], &grid->min[2],
+               &grid->max[0], &grid->max[1], &grid->max[2]) != 6 ||
+        grid->dims[0] < 2 || grid->dims[1] < 2 || grid->dims[2] < 2) {
+        fprintf(stderr, "Bad force grid header: %s\n", path);
+        fclose(f);
+        return 0;
+    }
+
+    size_t n = (size_t)grid->dims[0] * grid->dims[1] * grid->dims[2];
+    grid->data = malloc(n * sizeof(vec3));
+    if (!grid->data) {
+        fprintf(stderr, "Failed to alloc force grid\n");
+        fclose(f);
+        return 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (fscanf(f, "%f %f %f", &grid->data[i][0], &grid->data[i][1], &grid->data[i][2]) != 3) {
+            fprintf(stderr, "Force grid %s: expected %zu vectors\n", path, n);
+            vector_grid_free(grid);
+            fclose(f);
+            return 0;
+        }
+    }
+    fclose(f);
+    return 1;
+}
+
+// Interpolación trilineal; fuera de la grilla el campo vale cero
+void vector_grid_sample(const VectorGrid* grid, const vec3 pos, vec3 out) {
+    glm_vec3_zero(out);
+    int   idx[3];
+    float t[3];
+    for (int a = 0; a < 3; a++) {
+        float extent = grid->max[a] - grid->min[a];
+        if (extent <= 0.0f) return;
+        float u = (pos[a] - grid->min[a]) / extent * (grid->dims[a] - 1);
+        if (u < 0.0f || u > (float)(grid->dims[a] - 1)) return;
+        idx[a] = (int)u;
+        if (idx[a] >= grid->dims[a] - 1) idx[a] = grid->dims[a] - 2;
+        t[a] = u - (float)idx[a];
+    }
+
+    int nx = grid->dims[0], ny = grid->dims[1];
+    for (int corner = 0; corner < 8; corner++) {
+        int ox = corner & 1, oy = (corner >> 1) & 1, oz = (corner >> 2) & 1;
+        float w = (ox ? t[0] : 1.0f - t[0]) *
+                  (oy ? t[1] : 1.0f - t[1]) *
+                  (oz ? t[2] : 1.0f - t[2]);
+        size_t i = ((size_t)(idx[2] + oz) * ny + (idx[1] + oy)) * nx + (idx[0] + ox);
+        glm_vec3_muladds(grid->data[i], w, out);
+    }
+}
+
+void vector_grid_free(VectorGrid* grid) {
+    free(grid->data);
+    grid->data = NULL;
+}
@@ -0,0 +1,567 @@
+#include "physics/gravity.h"
+#include "physics/kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GRAVITY_RADIX 256
+
+struct GravityJob;
+typedef void (*GravityChunkFn)(struct GravityJob* job, int lo, int hi);
+
+typedef struct GravityJob {
+    GravityTree* tree;
+    const Particles* p;
+    int count;
+    float unitInv;        // 1 / PARTICLE_RADIUS, para las masas
+    float scale;          // unidades Morton por unidad de largo
+    int shift;            // dígito del radix sort en esta pasada
+    float (*bounds)[6];   // mínimo y máximo de cada bloque
+    int* subtrees;        // raíces de los subárboles que arma cada tarea
+    int* segments;        // primer nodo libre de cada subárbol
+    float G, theta, soft2;
+    vec3* out;
+    GravityChunkFn fn;
+    int items;
+} GravityJob;
+
+// ------------------------------------------------------------------ tareas
+
+static void task_chunk(void* arg, int lo) {
+    GravityJob* job = arg;
+    int hi = lo + GRAVITY_CHUNK < job->items ? lo + GRAVITY_CHUNK : job->items;
+    job->fn(job, lo, hi);
+}
+
+// fn sobre items en bloques de GRAVITY_CHUNK: en tareas de pool o, si no
+// hay hilos o no alcanza la memoria para el grafo, en este hilo
+static void run_chunks(GravityJob* job, TaskPool* pool, int items, GravityChunkFn fn) {
+    job->fn = fn;
+    job->items = items;
+    int ok = pool && task_pool_threads(pool) > 0 && items > GRAVITY_CHUNK;
+    for (int lo = 0; lo < items && ok; lo += GRAVITY_CHUNK)
+        ok = task_add(pool, task_chunk, job, lo) >= 0;
+    if (ok) {
+        task_pool_run(pool);
+        return;
+    }
+    if (pool) task_pool_clear(pool);
+    for (int lo = 0; lo < items; lo += GRAVITY_CHUNK)
+        fn(job, lo, lo + GRAVITY_CHUNK < items ? lo + GRAVITY_CHUNK : items);
+}
+
+// ------------------------------------------------------------------ Morton
+
+static uint64_t spread_bits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+static uint32_t compact_bits(uint64_t v) {
+    v &= 0x1249249249249249ULL;
+    v = (v | v >> 2) & 0x10c30c30c30c30c3ULL;
+    v = (v | v >> 4) & 0x100f00f00f00f00fULL;
+    v = (v | v >> 8) & 0x1f0000ff0000ffULL;
+    v = (v | v >> 16) & 0x1f00000000ffffULL;
+    v = (v | v >> 32) & 0x1fffff;
+    return (uint32_t)v;
+}
+
+static void chunk_bounds(GravityJob* job, int lo, int hi) {
+    float* b = job->bounds[lo / GRAVITY_CHUNK];
+    for (int a = 0; a < 3; a++) {
+        b[a] = INFINITY;
+        b[3 + a] = -INFINITY;
+    }
+    for (int i = lo; i < hi; i++)
+        for (int a = 0; a < 3; a++) {
+            b[a] = fminf(b[a], job->p[i].current[a]);
+            b[3 + a] = fmaxf(b[3 + a], job->p[i].current[a]);
+        }
+}
+
+static void chunk_keys(GravityJob* job, int lo, int hi) {
+    GravityTree* t = job->tree;
+    const float top = (float)((1 << GRAVITY_MORTON_BITS) - 1);
+    for (int i = lo; i < hi; i++) {
+        uint64_t key = 0;
+        for (int a = 0; a < 3; a++) {
+            float q = fminf(fmaxf((job->p[i].current[a] - t->min[a]) * job->scale, 0.0f), top);
+            key |= spread_bits((uint64_t)q) << (2 - a);
+        }
+        t->keys[i] = key;
+        t->index[i] = i;
+    }
+}
+
+// Radix sort LSD de a 8 bits: histograma por bloque, prefijos en serie y
+// reparto por bloque. Es estable, así que el orden no depende de los hilos.
+static void chunk_histogram(GravityJob* job, int lo, int hi) {
+    int* h = job->tree->histogram + (lo / GRAVITY_CHUNK) * GRAVITY_RADIX;
+    memset(h, 0, GRAVITY_RADIX * sizeof(int));
+    for (int i = lo; i < hi; i++) h[job->tree->keys[i] >> job->shift & 0xff]++;
+}
+
+static void chunk_scatter(GravityJob* job, int lo, int hi) {
+    GravityTree* t = job->tree;
+    int* h = t->histogram + (lo / GRAVITY_CHUNK) * GRAVITY_RADIX;
+    for (int i = lo; i < hi; i++) {
+        int to = h[t->keys[i] >> job->shift & 0xff]++;
+        t->keysTmp[to] = t->keys[i];
+        t->indexTmp[to] = t->index[i];
+    }
+}
+
+static void sort_keys(GravityJob* job, TaskPool* pool) {
+    GravityTree* t = job->tree;
+    const int chunks = (job->count + GRAVITY_CHUNK - 1) / GRAVITY_CHUNK;
+    for (int shift = 0; shift < 3 * GRAVITY_MORTON_BITS; shift += 8) {
+        job->shift = shift;
+        run_chunks(job, pool, job->count, chunk_histogram);
+        // un dígito igual en todas las claves no reordena nada
+        int skip = 0;
+        for (int d = 0; d < GRAVITY_RADIX && !skip; d++) {
+            int total = 0;
+            for (int c = 0; c < chunks; c++) total += t->histogram[c * GRAVITY_RADIX + d];
+            skip = total == job->count;
+        }
+        if (skip) continue;
+        int running = 0;
+        for (int d = 0; d < GRAVITY_RADIX; d++)
+            for (int c = 0; c < chunks; c++) {
+                int n = t->histogram[c * GRAVITY_RADIX + d];
+                t->histogram[c * GRAVITY_RADIX + d] = running;
+                running += n;
+            }
+        run_chunks(job, pool, job->count, chunk_scatter);
+        uint64_t* keys = t->keys;
+        t->keys = t->keysTmp;
+        t->keysTmp = keys;
+        int* index = t->index;
+        t->index = t->indexTmp;
+        t->indexTmp = index;
+    }
+}
+
+static void chunk_gather(GravityJob* job, int lo, int hi) {
+    GravityTree* t = job->tree;
+    for (int i = lo; i < hi; i++) {
+        const Particles* q = &job->p[t->index[i]];
+        float r = q->radius * job->unitInv;
+        t->x[i] = q->current[0];
+        t->y[i] = q->current[1];
+        t->z[i] = q->current[2];
+        t->m[i] = r * r * r;
+        t->groupAt[i] = -1;
+    }
+}
+
+// ------------------------------------------------------------------ octree
+
+// Nivel del primer triplete en que difieren las claves de lo .. hi (el
+// nivel de la celda del nodo), o -1 si son todas iguales
+static int split_level(const uint64_t* keys, int lo, int hi) {
+    uint64_t diff = keys[lo] ^ keys[hi - 1];
+    if (!diff) return -1;
+    int bit = 63 - __builtin_clzll(diff);
+    return GRAVITY_MORTON_BITS - 1 - bit / 3;
+}
+
+// Parte lo .. hi por el octante del nivel level: como las claves están
+// ordenadas y comparten lo de arriba, cada octante es un tramo contiguo
+static int split_children(const uint64_t* keys, int lo, int hi, int level, int starts[9]) {
+    const int shift = 3 * (GRAVITY_MORTON_BITS - 1 - level);
+    int k = 0;
+    for (int at = lo; at < hi;) {
+        int octant = (int)(keys[at] >> shift & 7);
+        int a = at + 1, b = hi;
+        while (a < b) {
+            int mid = a + (b - a) / 2;
+            if ((int)(keys[mid] >> shift & 7) > octant) b = mid;
+            else a = mid + 1;
+        }
+        starts[k++] = at;
+        at = a;
+    }
+    starts[k] = hi;
+    return k;
+}
+
+static void init_node(GravityNode* node, int lo, int hi) {
+    memset(node, 0, sizeof(*node));
+    node->lo = lo;
+    node->hi = hi;
+    node->child = -1;
+}
+
+// Lado, centro de masa y distancia al centro de la celda; de las
+// partículas en una hoja, de los hijos si no
+static void aggregate(GravityTree* t, GravityNode* node) {
+    float com[3] = { 0.0f, 0.0f, 0.0f }, mass = 0.0f;
+    if (node->child < 0) {
+        for (int i = node->lo; i < node->hi; i++) {
+            com[0] += t->m[i] * t->x[i];
+            com[1] += t->m[i] * t->y[i];
+            com[2] += t->m[i] * t->z[i];
+            mass += t->m[i];
+        }
+    } else {
+        for (int c = node->child; c < node->child + node->children; c++) {
+            const GravityNode* k = &t->nodes[c];
+            for (int a = 0; a < 3; a++) com[a] += k->mass * k->com[a];
+            mass += k->mass;
+        }
+    }
+
+    int level = split_level(t->keys, node->lo, node->hi);
+    int depth = level < 0 ? GRAVITY_MORTON_BITS : level;
+    node->size = ldexpf(t->side, -depth);
+    float center[3];
+    uint64_t key = t->keys[node->lo];
+    for (int a = 0; a < 3; a++) {
+        uint32_t cell = compact_bits(key >> (2 - a)) >> (GRAVITY_MORTON_BITS - depth);
+        center[a] = t->min[a] + ((float)cell + 0.5f) * node->size;
+    }
+    for (int a = 0; a < 3; a++) node->com[a] = mass > 0.0f ? com[a] / mass : center[a];
+    node->mass = mass;
+    node->offset = sqrtf((node->com[0] - center[0]) * (node->com[0] - center[0]) +
+                         (node->com[1] - center[1]) * (node->com[1] - center[1]) +
+                         (node->com[2] - center[2]) * (node->com[2] - center[2]));
+}
+
+// Arma el subárbol de n en profundidad; los hijos de cada nodo van
+// contiguos desde *cursor. El primer nodo con GRAVITY_GROUP partículas o
+// menos de cada rama es un grupo.
+static void build_node(GravityTree* t, int n, int* cursor, int grouped) {
+    GravityNode* node = &t->nodes[n];
+    if (!grouped && node->hi - node->lo <= GRAVITY_GROUP) {
+        t->groupAt[node->lo] = n;
+        grouped = 1;
+    }
+    int level = split_level(t->keys, node->lo, node->hi);
+    if (node->hi - node->lo > GRAVITY_LEAF && level >= 0) {
+        int starts[9];
+        int k = split_children(t->keys, node->lo, node->hi, level, starts);
+        node->child = *cursor;
+        node->children = k;
+        *cursor += k;
+        for (int c = 0; c < k; c++) init_node(&t->nodes[node->child + c], starts[c], starts[c + 1]);
+        for (int c = 0; c < k; c++) build_node(t, node->child + c, cursor, grouped);
+    } else if (!grouped) {
+        // todas las claves iguales: una hoja grande es su propio grupo
+        t->groupAt[node->lo] = n;
+    }
+    aggregate(t, node);
+}
+
+static void task_subtree(void* arg, int s) {
+    GravityJob* job = arg;
+    int cursor = job->segments[s];
+    build_node(job->tree, job->subtrees[s], &cursor, 0);
+}
+
+static int reserve_nodes(GravityTree* t, int count) {
+    if (count <= t->nodeCapacity) return 1;
+    int capacity = t->nodeCapacity > 0 ? t->nodeCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+    GravityNode* grown = realloc(t->nodes, capacity * sizeof(GravityNode));
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc gravity tree\n");
+        return 0;
+    }
+    t->nodes = grown;
+    t->nodeCapacity = capacity;
+    return 1;
+}
+
+// Los niveles de arriba se abren en serie hasta rangos de GRAVITY_CHUNK;
+// cada uno de esos es un subárbol en su tarea. Un nodo interno tiene al
+// menos dos hijos, así que un subárbol de n partículas usa menos de 2n
+// nodos: se le reserva ese tramo y las tareas no se pisan.
+static int build_tree(GravityJob* job, TaskPool* pool) {
+    GravityTree* t = job->tree;
+    if (!reserve_nodes(t, 1)) return 0;
+    init_node(&t->nodes[0], 0, job->count);
+    int top = 1, subtrees = 0, capacity = 0;
+    for (int n = 0; n < top; n++) {
+        int lo = t->nodes[n].lo, hi = t->nodes[n].hi;
+        int level = split_level(t->keys, lo, hi);
+        if (hi - lo <= GRAVITY_CHUNK || level < 0) {
+            if (subtrees == capacity) {
+                capacity = capacity > 0 ? capacity * 2 : 64;
+                int* grown = realloc(job->subtrees, capacity * sizeof(int));
+                if (!grown) {
+                    fprintf(stderr, "Failed to alloc gravity tree\n");
+                    return 0;
+                }
+                job->subtrees = grown;
+            }
+            job->subtrees[subtrees++] = n;
+            continue;
+        }
+        int starts[9];
+        int k = split_children(t->keys, lo, hi, level, starts);
+        if (!reserve_nodes(t, top + k)) return 0;
+        t->nodes[n].child = top;
+        t->nodes[n].children = k;
+        for (int c = 0; c < k; c++) init_node(&t->nodes[top + c], starts[c], starts[c + 1]);
+        top += k;
+    }
+
+    job->segments = malloc((subtrees > 0 ? subtrees : 1) * sizeof(int));
+    if (!job->segments) {
+        fprintf(stderr, "Failed to alloc gravity tree\n");
+        return 0;
+    }
+    int total = top;
+    for (int s = 0; s < subtrees; s++) {
+        const GravityNode* root = &t->nodes[job->subtrees[s]];
+        job->segments[s] = total;
+        total += 2 * (root->hi - root->lo);
+    }
+    if (!reserve_nodes(t, total)) return 0;
+    t->nodeCount = total;
+
+    int ok = pool && task_pool_threads(pool) > 0 && subtrees > 1;
+    for (int s = 0; s < subtrees && ok; s++) ok = task_add(pool, task_subtree, job, s) >= 0;
+    if (ok) {
+        task_pool_run(pool);
+    } else {
+        if (pool) task_pool_clear(pool);
+        for (int s = 0; s < subtrees; s++) task_subtree(job, s);
+    }
+    // los de arriba, hijos antes que padres
+    for (int n = top - 1; n >= 0; n--)
+        if (t->nodes[n].child >= 0 && t->nodes[n].child < top) aggregate(t, &t->nodes[n]);
+    return 1;
+}
+
+// ------------------------------------------------------------------ fuerzas
+
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    float* m;
+    int count;
+    int capacity;
+} SourceList;
+
+static int list_reserve(SourceList* list, int count) {
+    // gravity_batch lee hasta el múltiplo siguiente de GRAVITY_BATCH
+    count += GRAVITY_BATCH;
+    if (count <= list->capacity) return 1;
+    int capacity = list->capacity > 0 ? list->capacity : 4096;
+    while (capacity < count) capacity *= 2;
+    float* arrays[4] = { list->x, list->y, list->z, list->m };
+    int ok = 1;
+    for (int a = 0; a < 4; a++) {
+        float* grown = realloc(arrays[a], capacity * sizeof(float));
+        if (grown) arrays[a] = grown;
+        ok = ok && grown;
+    }
+    list->x = arrays[0];
+    list->y = arrays[1];
+    list->z = arrays[2];
+    list->m = arrays[3];
+    if (!ok) {
+        fprintf(stderr, "Failed to alloc gravity interaction list\n");
+        return 0;
+    }
+    list->capacity = capacity;
+    return 1;
+}
+
+// Un recorrido por grupo: el criterio se mide contra su caja, así
+// que la lista vale para todas sus partículas. Un nodo entra entero si está
+// a más de size / theta + offset (offset cubre que el centro de masa no esté
+// en el centro de la celda); si no, se abre.
+static int group_forces(GravityJob* job, const GravityNode* group, SourceList* list) {
+    const GravityTree* t = job->tree;
+    float lo[3] = { INFINITY, INFINITY, INFINITY }, hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int i = group->lo; i < group->hi; i++) {
+        float at[3] = { t->x[i], t->y[i], t->z[i] };
+        for (int a = 0; a < 3; a++) {
+            lo[a] = fminf(lo[a], at[a]);
+            hi[a] = fmaxf(hi[a], at[a]);
+        }
+    }
+
+    int stack[8 * (GRAVITY_MORTON_BITS + 2)];
+    int top = 0;
+    stack[top++] = 0;
+    list->count = 0;
+    while (top > 0) {
+        const GravityNode* node = &t->nodes[stack[--top]];
+        if (node->mass <= 0.0f) continue;
+        float d2 = 0.0f;
+        for (int a = 0; a < 3; a++) {
+            float d = fmaxf(fmaxf(lo[a] - node->com[a], node->com[a] - hi[a]), 0.0f);
+            d2 += d * d;
+        }
+        float reach = job->theta > 0.0f ? node->size / job->theta + node->offset : INFINITY;
+        if (d2 > reach * reach) {
+            if (!list_reserve(list, list->count + 1)) return 0;
+            list->x[list->count] = node->com[0];
+            list->y[list->count] = node->com[1];
+            list->z[list->count] = node->com[2];
+            list->m[list->count] = node->mass;
+            list->count++;
+        } else if (node->child < 0) {
+            int n = node->hi - node->lo;
+            if (!list_reserve(list, list->count + n)) return 0;
+            memcpy(list->x + list->count, t->x + node->lo, n * sizeof(float));
+            memcpy(list->y + list->count, t->y + node->lo, n * sizeof(float));
+            memcpy(list->z + list->count, t->z + node->lo, n * sizeof(float));
+            memcpy(list->m + list->count, t->m + node->lo, n * sizeof(float));
+            list->count += n;
+        } else {
+            for (int c = node->children - 1; c >= 0; c--) stack[top++] = node->child + c;
+        }
+    }
+    for (int k = list->count; k < list->count + GRAVITY_BATCH; k++)
+        list->x[k] = list->y[k] = list->z[k] = list->m[k] = 0.0f;
+
+    for (int i = group->lo; i < group->hi; i++) {
+        float at[3] = { t->x[i], t->y[i], t->z[i] };
+        float acc[3] = { 0.0f, 0.0f, 0.0f };
+        physicsKernels->gravity_batch(list->x, list->y, list->z, list->m, list->count,
+                                      at, job->soft2, acc);
+        glm_vec3_scale(acc, job->G, job->out[t->index[i]]);
+    }
+    return 1;
+}
+
+static void chunk_forces(GravityJob* job, int lo, int hi) {
+    const GravityTree* t = job->tree;
+    SourceList list;
+    memset(&list, 0, sizeof(list));
+    int ok = 1;
+    for (int i = lo; i < hi; i++) {
+        if (t->groupAt[i] < 0) continue;
+        if (ok) ok = group_forces(job, &t->nodes[t->groupAt[i]], &list);
+        // sin memoria para la lista las partículas quedan sin gravedad
+        if (!ok)
+            for (int k = t->nodes[t->groupAt[i]].lo; k < t->nodes[t->groupAt[i]].hi; k++)
+                glm_vec3_zero(job->out[t->index[k]]);
+    }
+    free(list.x);
+    free(list.y);
+    free(list.z);
+    free(list.m);
+}
+
+// ------------------------------------------------------------------ API
+
+static int reserve_particles(GravityTree* t, int count, int chunks) {
+    if (count > t->capacity) {
+        int capacity = t->capacity > 0 ? t->capacity : 1024;
+        while (capacity < count) capacity *= 2;
+        size_t padded = (size_t)capacity + GRAVITY_BATCH;
+        uint64_t* keys = realloc(t->keys, padded * sizeof(uint64_t));
+        if (keys) t->keys = keys;
+        uint64_t* keysTmp = realloc(t->keysTmp, padded * sizeof(uint64_t));
+        if (keysTmp) t->keysTmp = keysTmp;
+        int* index = realloc(t->index, padded * sizeof(int));
+        if (index) t->index = index;
+        int* indexTmp = realloc(t->indexTmp, padded * sizeof(int));
+        if (indexTmp) t->indexTmp = indexTmp;
+        int* groupAt = realloc(t->groupAt, padded * sizeof(int));
+        if (groupAt) t->groupAt = groupAt;
+        float* x = realloc(t->x, padded * sizeof(float));
+        if (x) t->x = x;
+        float* y = realloc(t->y, padded * sizeof(float));
+        if (y) t->y = y;
+        float* z = realloc(t->z, padded * sizeof(float));
+        if (z) t->z = z;
+        float* m = realloc(t->m, padded * sizeof(float));
+        if (m) t->m = m;
+        if (!keys || !keysTmp || !index || !indexTmp || !groupAt || !x || !y || !z || !m) {
+            fprintf(stderr, "Failed to alloc gravity tree\n");
+            return 0;
+        }
+        t->capacity = capacity;
+    }
+    if (chunks * GRAVITY_RADIX > t->histogramCapacity) {
+        int* grown = realloc(t->histogram, chunks * GRAVITY_RADIX * sizeof(int));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc gravity tree\n");
+            return 0;
+        }
+        t->histogram = grown;
+        t->histogramCapacity = chunks * GRAVITY_RADIX;
+    }
+    return 1;
+}
+
+int gravity_compute(GravityTree* tree, const Config* cfg, const Particles* p, int count,
+                    vec3* out, TaskPool* pool) {
+    if (count <= 0) return 1;
+    const int chunks = (count + GRAVITY_CHUNK - 1) / GRAVITY_CHUNK;
+    GravityJob job;
+    memset(&job, 0, sizeof(job));
+    job.tree = tree;
+    job.p = p;
+    job.count = count;
+    job.unitInv = cfg->PARTICLE_RADIUS > 0.0f ? 1.0f / cfg->PARTICLE_RADIUS : 1.0f;
+    job.G = cfg->GRAVITY_G;
+    job.theta = fmaxf(cfg->GRAVITY_THETA, 0.0f);
+    float soft = cfg->GRAVITY_SOFTENING * cfg->PARTICLE_RADIUS;
+    job.soft2 = soft * soft;
+    job.out = out;
+    job.bounds = malloc(chunks * sizeof(*job.bounds));
+    if (!job.bounds || !reserve_particles(tree, count, chunks)) {
+        if (!job.bounds) fprintf(stderr, "Failed to alloc gravity tree\n");
+        free(job.bounds);
+        return 0;
+    }
+
+    // Cubo de la raíz, con un margen para que el máximo caiga adentro
+    run_chunks(&job, pool, count, chunk_bounds);
+    float hi[3];
+    for (int a = 0; a < 3; a++) {
+        tree->min[a] = INFINITY;
+        hi[a] = -INFINITY;
+        for (int c = 0; c < chunks; c++) {
+            tree->min[a] = fminf(tree->min[a], job.bounds[c][a]);
+            hi[a] = fmaxf(hi[a], job.bounds[c][3 + a]);
+        }
+    }
+    tree->side = fmaxf(fmaxf(hi[0] - tree->min[0], hi[1] - tree->min[1]), hi[2] - tree->min[2]);
+    tree->side = tree->side > 0.0f ? tree->side * 1.0001f : 1.0f;
+    job.scale = (float)(1 << GRAVITY_MORTON_BITS) / tree->side;
+    free(job.bounds);
+
+    run_chunks(&job, pool, count, chunk_keys);
+    sort_keys(&job, pool);
+    run_chunks(&job, pool, count, chunk_gather);
+    for (int k = count; k < count + GRAVITY_BATCH; k++)
+        tree->x[k] = tree->y[k] = tree->z[k] = tree->m[k] = 0.0f;
+
+    int ok = build_tree(&job, pool);
+    if (ok) run_chunks(&job, pool, count, chunk_forces);
+    free(job.subtrees);
+    free(job.segments);
+    return ok;
+}
+
+void gravity_free(GravityTree* tree) {
+    free(tree->keys);
+    free(tree->keysTmp);
+    free(tree->index);
+    free(tree->indexTmp);
+    free(tree->x);
+    free(tree->y);
+    free(tree->z);
+    free(tree->m);
+    free(tree->groupAt);
+    free(tree->nodes);
+    free(tree->histogram);
+    memset(tree, 0, sizeof(*tree));
+}
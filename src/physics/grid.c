@@ -0,0 +1,129 @@
+#include "physics/grid.h"
+#include "physics/env.h"
+#include "physics/kernels.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int hashCount[HASH_TABLE_SIZE];
+int hashTable[HASH_TABLE_SIZE][MAX_BUCKET_SIZE];
+
+GridParams grid;
+int (*cellCoord)[3] = NULL;
+unsigned int* occupiedList = NULL;
+int occupiedCount = 0;
+int* overflowList = NULL;
+int overflowCount = 0;
+int* largeList = NULL;
+int largeCount = 0;
+
+static int gridCapacity = 0;
+
+void grid_setup(const Config* config, const Particles* p, int count) {
+    // Parámetro: tamaño de celda = doble del radio máximo de las comunes
+    float minRadius = FLT_MAX, maxRadius = 0.0f;
+    for (int i = 0; i < count; i++) {
+        if (p[i].radius < minRadius) minRadius = p[i].radius;
+        if (p[i].radius > maxRadius) maxRadius = p[i].radius;
+    }
+    float cellRadius = 0.0f;
+    for (int i = 0; i < count; i++)
+        if (p[i].radius <= LARGE_RATIO * minRadius && p[i].radius > cellRadius)
+            cellRadius = p[i].radius;
+    float cellSize = cellRadius * 2.0f;
+
+    const EnvInterface* env = env_get(config->ENV_TYPE);
+    grid.cellSize = cellSize;
+    grid.largeRadius = cellRadius;
+    grid.maxRadius = maxRadius;
+    grid.periodic = env && env->periodic;
+    if (grid.periodic) {
+        // dominio cúbico: se toma el eje x de la caja del entorno
+        vec3 min, max;
+        env->bounds(config, min, max);
+        grid.period = max[0] - min[0];
+        grid.origin = min[0];
+        grid.cells = (int)floorf(grid.period / cellSize);
+        if (grid.cells < 1) grid.cells = 1;
+        // celdas un poco más grandes para cubrir el dominio exacto
+        grid.cellSize = grid.period / grid.cells;
+    }
+}
+
+// Agranda los buffers por partícula de la grilla si hace falta
+static int reserve_grid(int count) {
+    if (count <= gridCapacity) return 1;
+    int capacity = gridCapacity > 0 ? gridCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    unsigned int* occupied = realloc(occupiedList, capacity * sizeof(unsigned int));
+    if (occupied) occupiedList = occupied;
+    int* overflow          = realloc(overflowList, capacity * sizeof(int));
+    if (overflow) overflowList = overflow;
+    int (*coords)[3]       = realloc(cellCoord, capacity * sizeof(*cellCoord));
+    if (coords) cellCoord  = coords;
+    int* large             = realloc(largeList, capacity * sizeof(int));
+    if (large) largeList   = large;
+    if (!occupied || !overflow || !coords || !large) {
+        fprintf(stderr, "Failed to alloc grid buffers\n");
+        return 0;
+    }
+    gridCapacity = capacity;
+    return 1;
+}
+
+int grid_insert_begin(const Particles* p, int count) {
+    // Limpiar sólo los buckets que ocupó el build anterior
+    for (int k = 0; k < occupiedCount; k++)
+        hashCount[occupiedList[k]] = 0;
+    occupiedCount = 0;
+    overflowCount = 0;
+    largeCount = 0;
+    grid.particles = p;
+    grid.count = 0;
+    if (count <= 0) return 1;
+    if (!reserve_grid(count)) return 0;
+
+    for (int a = 0; a < 3; a++) {
+        grid.cellMin[a] = 0x7fffffff;
+        grid.cellMax[a] = -0x7fffffff;
+    }
+    return 1;
+}
+
+// Guardamos las coordenadas de celda para no recalcularlas
+void grid_insert_cells(const Particles* p, int lo, int hi) {
+    physicsKernels->cell_coords(&grid, p + lo, hi - lo, cellCoord + lo);
+}
+
+// ... y la lista de buckets ocupados
+void grid_insert_range(const Particles* p, int lo, int hi) {
+    for (int i = lo; i < hi; i++) {
+        for (int a = 0; a < 3; a++) {
+            if (cellCoord[i][a] < grid.cellMin[a]) grid.cellMin[a] = cellCoord[i][a];
+            if (cellCoord[i][a] > grid.cellMax[a]) grid.cellMax[a] = cellCoord[i][a];
+        }
+        unsigned int h = spatial_hash(cellCoord[i][0], cellCoord[i][1], cellCoord[i][2]);
+        if (hashCount[h] == 0)
+            occupiedList[occupiedCount++] = h;
+        if (hashCount[h] < MAX_BUCKET_SIZE)
+            hashTable[h][hashCount[h]++] = i;
+        else
+            overflowList[overflowCount++] = i;
+        if (p[i].radius > grid.largeRadius)
+            largeList[largeCount++] = i;
+    }
+}
+
+void grid_insert_end(int count) {
+    grid.count = count;
+}
+
+int grid_insert(const Particles* p, int count) {
+    if (!grid_insert_begin(p, count)) return 0;
+    if (count <= 0) return 1;
+    grid_insert_cells(p, 0, count);
+    grid_insert_range(p, 0, count);
+    grid_insert_end(count);
+    return 1;
+}
@@ -0,0 +1,233 @@
+#include "physics/history.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Un delta ocupa como mucho 5 bytes por componente
+#define MAX_VARINT_BYTES 5
+#define MAX_QUANTIZED 1073741823.0f  // 2^30 - 1
+
+int history_init(History* h, size_t bytes, int keyInterval, float quantum) {
+    memset(h, 0, sizeof(*h));
+    if (bytes == 0) return 1;  // historial apagado
+    h->data = malloc(bytes);
+    if (!h->data) {
+        fprintf(stderr, "Failed to alloc history (%zu bytes)\n", bytes);
+        return 0;
+    }
+    h->capacity = bytes;
+    h->keyInterval = keyInterval > 0 ? keyInterval : 1;
+    h->quantum = quantum > 0.0f ? quantum : 1e-5f;
+    return 1;
+}
+
+void history_free(History* h) {
+    free(h->data);
+    free(h->frames);
+    free(h->recon);
+    free(h->scratch);
+    memset(h, 0, sizeof(*h));
+}
+
+void history_clear(History* h) {
+    h->head = 0;
+    h->first = 0;
+    h->frameCount = 0;
+    h->sinceKey = 0;
+    h->reconCount = 0;
+}
+
+int history_frames(const History* h) {
+    return h->frameCount;
+}
+
+static inline HistoryFrame* frame_at(History* h, int frame) {
+    return &h->frames[h->first + frame];
+}
+
+static int reserve_bytes(unsigned char** buf, size_t* capacity, size_t need) {
+    if (need <= *capacity) return 1;
+    unsigned char* grown = realloc(*buf, need);
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc history scratch\n");
+        return 0;
+    }
+    *buf = grown;
+    *capacity = need;
+    return 1;
+}
+
+static int reserve_recon(History* h, int count) {
+    if (count <= h->reconCapacity) return 1;
+    Particles* grown = realloc(h->recon, count * sizeof(Particles));
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc history state\n");
+        return 0;
+    }
+    h->recon = grown;
+    h->reconCapacity = count;
+    return 1;
+}
+
+static inline unsigned char* put_varint(unsigned char* out, int32_t v) {
+    uint32_t z = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);  // zigzag
+    while (z >= 0x80) {
+        *out++ = (unsigned char)(z | 0x80);
+        z >>= 7;
+    }
+    *out++ = (unsigned char)z;
+    return out;
+}
+
+static inline const unsigned char* get_varint(const unsigned char* in, int32_t* v) {
+    uint32_t z = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        z |= (uint32_t)(*in++ & 0x7f) << shift;
+        shift += 7;
+    }
+    z |= (uint32_t)*in++ << shift;
+    *v = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+    return in;
+}
+
+// Cuantiza target - base y avanza base con el valor que verá el
+// decodificador. Devuelve 0 si el salto no entra en un varint.
+static inline int encode_vec(unsigned char** out, const vec3 target, vec3 base, float quantum) {
+    for (int a = 0; a < 3; a++) {
+        float q = roundf((target[a] - base[a]) / quantum);
+        if (fabsf(q) > MAX_QUANTIZED) return 0;
+        int32_t d = (int32_t)q;
+        *out = put_varint(*out, d);
+        base[a] += (float)d * quantum;
+    }
+    return 1;
+}
+
+static inline const unsigned char* decode_vec(const unsigned char* in, vec3 base, float quantum) {
+    for (int a = 0; a < 3; a++) {
+        int32_t d;
+        in = get_varint(in, &d);
+        base[a] += (float)d * quantum;
+    }
+    return in;
+}
+
+// Deja libre [offset, offset + bytes) sacando frames viejos. Un delta sin su
+// keyframe no sirve, así que se saca hasta el próximo keyframe.
+static void evict_range(History* h, size_t offset, size_t bytes) {
+    while (h->frameCount > 0) {
+        HistoryFrame* oldest = frame_at(h, 0);
+        int overlaps = oldest->offset < offset + bytes && offset < oldest->offset + oldest->bytes;
+        if (!overlaps && oldest->keyframe) break;
+        h->first++;
+        h->frameCount--;
+    }
+    if (h->frameCount == 0) h->first = 0;
+}
+
+static int push_frame(History* h, const unsigned char* src, size_t bytes, int count, int keyframe) {
+    if (bytes > h->capacity) return 0;
+    size_t offset = h->head;
+    if (offset + bytes > h->capacity) {
+        // Da la vuelta: lo que quedaba al final es lo más viejo
+        evict_range(h, offset, h->capacity - offset);
+        offset = 0;
+    }
+    evict_range(h, offset, bytes);
+    // Si se fue todo el historial un delta ya no tiene base
+    if (!keyframe && h->frameCount == 0) return 0;
+
+    if (h->first + h->frameCount == h->frameCapacity) {
+        if (h->first > 0) {
+            memmove(h->frames, h->frames + h->first, h->frameCount * sizeof(HistoryFrame));
+            h->first = 0;
+        } else {
+            int capacity = h->frameCapacity > 0 ? h->frameCapacity * 2 : 256;
+            HistoryFrame* grown = realloc(h->frames, capacity * sizeof(HistoryFrame));
+            if (!grown) {
+                fprintf(stderr, "Failed to alloc history frames\n");
+                return 0;
+            }
+            h->frames = grown;
+            h->frameCapacity = capacity;
+        }
+    }
+
+    memcpy(h->data + offset, src, bytes);
+    HistoryFrame* f = &h->frames[h->first + h->frameCount++];
+    f->offset = offset;
+    f->bytes = bytes;
+    f->count = count;
+    f->keyframe = keyframe;
+    h->head = offset + bytes;
+    return 1;
+}
+
+static int record_keyframe(History* h, const Particles* p, int count) {
+    if (!reserve_recon(h, count)) return 0;
+    memcpy(h->recon, p, count * sizeof(Particles));
+    h->reconCount = count;
+    h->sinceKey = 0;
+    if (!push_frame(h, (const unsigned char*)p, count * sizeof(Particles), count, 1)) {
+        fprintf(stderr, "History too small for one keyframe\n");
+        history_clear(h);
+        return 0;
+    }
+    return 1;
+}
+
+int history_record(History* h, const Particles* p, int count) {
+    if (!h->data || count <= 0) return 0;
+
+    int key = h->frameCount == 0 || count != h->reconCount ||
+              ++h->sinceKey >= h->keyInterval;
+    if (!key) {
+        size_t worst = (size_t)count * 6 * MAX_VARINT_BYTES;
+        if (!reserve_bytes(&h->scratch, &h->scratchCapacity, worst)) return 0;
+        unsigned char* out = h->scratch;
+        for (int i = 0; i < count && !key; i++) {
+            key = !encode_vec(&out, p[i].current, h->recon[i].current, h->quantum) ||
+                  !encode_vec(&out, p[i].previus, h->recon[i].previus, h->quantum);
+        }
+        if (!key && push_frame(h, h->scratch, out - h->scratch, count, 0)) return 1;
+        // recon quedó a medio avanzar: se rehace desde un keyframe
+    }
+    return record_keyframe(h, p, count);
+}
+
+int history_restore(History* h, int frame, Particles* p) {
+    if (frame < 0 || frame >= h->frameCount) return -1;
+    int key = frame;
+    while (!frame_at(h, key)->keyframe) key--;
+
+    const HistoryFrame* kf = frame_at(h, key);
+    memcpy(p, h->data + kf->offset, kf->bytes);
+    for (int f = key + 1; f <= frame; f++) {
+        const HistoryFrame* df = frame_at(h, f);
+        const unsigned char* in = h->data + df->offset;
+        for (int i = 0; i < df->count; i++) {
+            in = decode_vec(in, p[i].current, h->quantum);
+            in = decode_vec(in, p[i].previus, h->quantum);
+        }
+    }
+    return frame_at(h, frame)->count;
+}
+
+void history_truncate(History* h, int frame) {
+    if (frame < 0 || frame >= h->frameCount) return;
+    h->frameCount = frame + 1;
+    HistoryFrame* last = frame_at(h, frame);
+    h->head = last->offset + last->bytes;
+
+    // El codificador sigue desde el frame elegido
+    if (!reserve_recon(h, last->count)) {
+        history_clear(h);
+        return;
+    }
+    h->reconCount = history_restore(h, frame, h->recon);
+    int key = frame;
+    while (!frame_at(h, key)->keyframe) key--;
+    h->sinceKey = frame - key;
+}
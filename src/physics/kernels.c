@@ -0,0 +1,171 @@
+// Este archivo se compila una vez por variante con -DKERNEL_ISA=<nombre> y
+// las flags de esa ISA; cada copia exporta su tabla physics_kernels_<nombre>.
+#include "physics/kernels.h"
+#include <math.h>
+
+#ifndef KERNEL_ISA
+#define KERNEL_ISA generic
+#endif
+#define KERNEL_CAT(a, b) a##_##b
+#define KERNEL_NAME(a, b) KERNEL_CAT(a, b)
+#define KERNEL_STR2(a) #a
+#define KERNEL_STR(a) KERNEL_STR2(a)
+
+static void integrate_uniform(const vec3 acc, Particles* p, int count, float dt) {
+    float dt2 = dt * dt;
+    vec3 accTerm;
+    glm_vec3_scale((float*)acc, dt2, accTerm);
+    glm_vec3_scale(accTerm, 0.5f, accTerm);
+    for (int i = 0; i < count; i++) {
+        for (int a = 0; a < 3; a++) {
+            float res = p[i].current[a] * 2.0f - p[i].previus[a] + accTerm[a];
+            p[i].previus[a] = p[i].current[a];
+            p[i].current[a] = res;
+        }
+    }
+}
+
+static void collide_box(float size, Particles* p, int count) {
+    for (int k = 0; k < count; k++) {
+        float min = -size + p[k].radius;
+        float max =  size - p[k].radius;
+        for (int i = 0; i < 3; ++i) {
+            float disp = p[k].current[i] - p[k].previus[i];
+            float clamped = fminf(fmaxf(p[k].current[i], min), max);
+            // rebote simple: si se recortó, la velocidad se invierte
+            if (clamped != p[k].current[i]) {
+                p[k].current[i] = clamped;
+                p[k].previus[i] = clamped + disp;
+            }
+        }
+    }
+}
+
+static void collide_sphere(float envRadius, Particles* p, int count) {
+    for (int k = 0; k < count; k++) {
+        float max_dist = envRadius - p[k].radius;
+        float dist2 = glm_vec3_norm2(p[k].current);
+        if (dist2 <= max_dist * max_dist) continue;
+
+        vec3 normal;
+        glm_vec3_scale(p[k].current, 1.0f / sqrtf(dist2), normal);
+        vec3 velocity;
+        glm_vec3_sub(p[k].current, p[k].previus, velocity);
+        glm_vec3_scale(normal, max_dist, p[k].current);
+
+        // reflejar la velocidad con pérdida de energía
+        float v_dot_n = glm_vec3_dot(velocity, normal);
+        glm_vec3_muladds(normal, -2.0f * v_dot_n, velocity);
+        glm_vec3_scale(velocity, 0.9f, velocity);
+        glm_vec3_sub(p[k].current, velocity, p[k].previus);
+    }
+}
+
+static void cell_coords(const GridParams* g, const Particles* p, int count, int (*out)[3]) {
+    if (!g->periodic) {
+        for (int i = 0; i < count; i++)
+            for (int a = 0; a < 3; a++)
+                out[i][a] = (int)floorf(p[i].current[a] / g->cellSize);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        for (int a = 0; a < 3; a++) {
+            int c = (int)floorf((p[i].current[a] - g->origin) / g->cellSize) % g->cells;
+            out[i][a] = c < 0 ? c + g->cells : c;
+        }
+    }
+}
+
+static int contact_filter(const Particles* p, int i, const int* candidates, int n,
+                          float padding, float period, int* out) {
+    const float xi = p[i].current[0], yi = p[i].current[1], zi = p[i].current[2];
+    const float reach = p[i].radius + padding;
+    int m = 0;
+    for (int k = 0; k < n; k++) {
+        const Particles* q = &p[candidates[k]];
+        float dx = q->current[0] - xi;
+        float dy = q->current[1] - yi;
+        float dz = q->current[2] - zi;
+        if (period > 0.0f) {
+            dx -= period * floorf(dx / period + 0.5f);
+            dy -= period * floorf(dy / period + 0.5f);
+            dz -= period * floorf(dz / period + 0.5f);
+        }
+        // margen relativo para no perder pares justo en el límite
+        float lim = (reach + q->radius) * 1.0001f;
+        float d2 = dx * dx + dy * dy + dz * dz;
+        out[m] = candidates[k];
+        m += d2 > 0.0f && d2 < lim * lim;
+    }
+    return m;
+}
+
+// Los candidatos van en bloques fijos: primero la distancia al cuadrado de
+// todo el bloque (sin raíces ni saltos, para que se vectorice al ancho de
+// la ISA), después se compactan los que tocan. El último bloque lee hasta
+// CONTACT_BATCH - 1 lugares después de hi y los descarta.
+static int contact_batch(const float* x, const float* y, const float* z, const float* r,
+                         int lo, int hi, const float at[3], float reach, float period,
+                         int* out) {
+    const float xi = at[0], yi = at[1], zi = at[2];
+    // los candidatos son vecinos, así que la imagen mínima es a lo sumo una
+    // vuelta: con comparaciones en vez de floorf el bucle se vectoriza
+    const float half = period > 0.0f ? 0.5f * period : INFINITY;
+    int m = 0;
+    for (int first = lo; first < hi; first += CONTACT_BATCH) {
+        int hit[CONTACT_BATCH];
+        for (int k = 0; k < CONTACT_BATCH; k++) {
+            float dx = x[first + k] - xi;
+            float dy = y[first + k] - yi;
+            float dz = z[first + k] - zi;
+            dx += period * (float)((dx < -half) - (dx > half));
+            dy += period * (float)((dy < -half) - (dy > half));
+            dz += period * (float)((dz < -half) - (dz > half));
+            float lim = (reach + r[first + k]) * 1.0001f;
+            float d2 = dx * dx + dy * dy + dz * dz;
+            hit[k] = (d2 > 0.0f) & (d2 < lim * lim) & (first + k < hi);
+        }
+        for (int k = 0; k < CONTACT_BATCH; k++) {
+            out[m] = first + k;
+            m += hit[k];
+        }
+    }
+    return m;
+}
+
+static void gravity_batch(const float* x, const float* y, const float* z, const float* m,
+                          int count, const float at[3], float soft2, float acc[3]) {
+    // un acumulador por carril: el orden de las sumas no depende de la ISA
+    float ax[GRAVITY_BATCH] = { 0 }, ay[GRAVITY_BATCH] = { 0 }, az[GRAVITY_BATCH] = { 0 };
+    for (int first = 0; first < count; first += GRAVITY_BATCH) {
+        for (int k = 0; k < GRAVITY_BATCH; k++) {
+            float dx = x[first + k] - at[0];
+            float dy = y[first + k] - at[1];
+            float dz = z[first + k] - at[2];
+            float d2 = dx * dx + dy * dy + dz * dz + soft2;
+            // sin suavizado la propia partícula (y las que coinciden) daría
+            // 0 · ∞: no aporta
+            float inv = d2 > 0.0f ? 1.0f / (d2 * sqrtf(d2)) : 0.0f;
+            float s = m[first + k] * inv;
+            ax[k] += s * dx;
+            ay[k] += s * dy;
+            az[k] += s * dz;
+        }
+    }
+    for (int k = 0; k < GRAVITY_BATCH; k++) {
+        acc[0] += ax[k];
+        acc[1] += ay[k];
+        acc[2] += az[k];
+    }
+}
+
+const PhysicsKernels KERNEL_NAME(physics_kernels, KERNEL_ISA) = {
+    KERNEL_STR(KERNEL_ISA),
+    integrate_uniform,
+    collide_box,
+    collide_sphere,
+    cell_coords,
+    contact_filter,
+    contact_batch,
+    gravity_batch,
+};
@@ -0,0 +1,312 @@
+#include "physics/multirate.h"
+#include "physics/env.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int multirate_init(MultiRate* mr, int capacity) {
+    memset(mr, 0, sizeof(*mr));
+    mr->members = malloc((size_t)capacity * sizeof(MultiRateMember));
+    mr->regions = malloc((size_t)capacity * sizeof(MultiRateRegion));
+    mr->level = malloc((size_t)capacity);
+    mr->regionState = malloc((size_t)capacity);
+    mr->work = malloc((size_t)capacity * sizeof(Particles));
+    mr->workIndex = malloc((size_t)capacity * sizeof(int));
+    mr->frozen = malloc((size_t)capacity);
+    mr->localIndex = malloc((size_t)capacity * sizeof(int));
+    if (!mr->members || !mr->regions || !mr->level || !mr->regionState ||
+        !mr->work || !mr->workIndex || !mr->frozen || !mr->localIndex) {
+        fprintf(stderr, "Failed to alloc multi-rate buffers\n");
+        multirate_free(mr);
+        return 0;
+    }
+    for (int i = 0; i < capacity; i++) mr->localIndex[i] = -1;
+    mr->capacity = capacity;
+    return 1;
+}
+
+void multirate_free(MultiRate* mr) {
+    free(mr->members);
+    free(mr->regions);
+    free(mr->level);
+    free(mr->regionState);
+    free(mr->work);
+    free(mr->workIndex);
+    free(mr->frozen);
+    free(mr->localIndex);
+    contact_cache_free(&mr->contacts);
+    memset(mr, 0, sizeof(*mr));
+}
+
+#define REGION_BITS 21
+#define REGION_MASK ((1u << REGION_BITS) - 1)
+
+static inline uint64_t region_key(int x, int y, int z) {
+    const int bias = 1 << (REGION_BITS - 1);
+    return ((uint64_t)((x + bias) & REGION_MASK) << (2 * REGION_BITS)) |
+           ((uint64_t)((y + bias) & REGION_MASK) << REGION_BITS) |
+            (uint64_t)((z + bias) & REGION_MASK);
+}
+
+static inline int key_axis(uint64_t key, int axis) {
+    int shift = (2 - axis) * REGION_BITS;
+    return (int)((key >> shift) & REGION_MASK) - (1 << (REGION_BITS - 1));
+}
+
+static int compare_members(const void* a, const void* b) {
+    const MultiRateMember* ma = a;
+    const MultiRateMember* mb = b;
+    if (ma->key != mb->key) return (ma->key > mb->key) - (ma->key < mb->key);
+    return ma->index - mb->index;
+}
+
+static int find_region(const MultiRate* mr, uint64_t key) {
+    int lo = 0, hi = mr->regionCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint64_t k = mr->regions[mid].key;
+        if (k == key) return mid;
+        if (k < key) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+// Agrupa las partículas por región, con sus vecinas y la velocidad máxima
+// convertida en nivel. Devuelve el nivel máximo.
+static int bin_regions(MultiRate* mr, const Config* cfg, const Particles* p, int count) {
+    const float size = MULTIRATE_REGION * cfg->PARTICLE_RADIUS;
+    for (int i = 0; i < count; i++) {
+        mr->members[i].key = region_key((int)floorf(p[i].current[0] / size),
+                                        (int)floorf(p[i].current[1] / size),
+                                        (int)floorf(p[i].current[2] / size));
+        mr->members[i].index = i;
+    }
+    qsort(mr->members, count, sizeof(MultiRateMember), compare_members);
+
+    // nivel: el menor k con vmax * dt / 2^k <= MULTIRATE_CFL * radio
+    const float limit = cfg->MULTIRATE_CFL * cfg->PARTICLE_RADIUS;
+    const int maxLevel = (int)cfg->MULTIRATE_LEVELS - 1;
+    mr->regionCount = 0;
+    for (int a = 0; a < count; ) {
+        MultiRateRegion* r = &mr->regions[mr->regionCount++];
+        r->key = mr->members[a].key;
+        r->first = a;
+        float vmax2 = 0.0f;
+        while (a < count && mr->members[a].key == r->key) {
+            vec3 step;
+            const Particles* q = &p[mr->members[a].index];
+            glm_vec3_sub((float*)q->current, (float*)q->previus, step);
+            float v2 = glm_vec3_norm2(step);
+            if (v2 > vmax2) vmax2 = v2;
+            a++;
+        }
+        r->count = a - r->first;
+        float move = sqrtf(vmax2);  // por paso dt
+        r->level = 0;
+        while (r->level < maxLevel && move > limit) {
+            move *= 0.5f;
+            r->level++;
+        }
+    }
+
+    for (int g = 0; g < mr->regionCount; g++) {
+        MultiRateRegion* r = &mr->regions[g];
+        int x = key_axis(r->key, 0), y = key_axis(r->key, 1), z = key_axis(r->key, 2);
+        r->neighbourCount = 0;
+        for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+        for (int dz = -1; dz <= 1; dz++) {
+            if (!dx && !dy && !dz) continue;
+            int n = find_region(mr, region_key(x + dx, y + dy, z + dz));
+            if (n >= 0) r->neighbours[r->neighbourCount++] = n;
+        }
+    }
+
+    // Interfaces: entre vecinas el nivel salta de a 1 como mucho
+    for (int pass = 0; pass < maxLevel; pass++) {
+        for (int g = 0; g < mr->regionCount; g++) {
+            MultiRateRegion* r = &mr->regions[g];
+            for (int k = 0; k < r->neighbourCount; k++) {
+                int level = mr->regions[r->neighbours[k]].level - 1;
+                if (level > r->level) r->level = level;
+            }
+        }
+    }
+
+    int top = 0;
+    for (int g = 0; g < mr->regionCount; g++) {
+        const MultiRateRegion* r = &mr->regions[g];
+        if (r->level > top) top = r->level;
+        for (int m = r->first; m < r->first + r->count; m++)
+            mr->level[mr->members[m].index] = (unsigned char)r->level;
+    }
+    return top;
+}
+
+// previus guarda el desplazamiento de un paso: al cambiar de paso se
+// escala para conservar la velocidad
+static void rescale_steps(const MultiRate* mr, Particles* p, int count, int toLevel) {
+    for (int i = 0; i < count; i++) {
+        if (mr->level[i] == 0) continue;
+        float factor = ldexpf(1.0f, toLevel ? -mr->level[i] : mr->level[i]);
+        vec3 step;
+        glm_vec3_sub(p[i].current, p[i].previus, step);
+        glm_vec3_scale(step, factor, step);
+        glm_vec3_sub(p[i].current, step, p[i].previus);
+    }
+}
+
+// Junta en work las partículas de las regiones que avanzan y, después, las
+// de sus vecinas congeladas. Devuelve cuántas avanzan; el total en *total.
+static int gather(MultiRate* mr, const Particles* p, int* total) {
+    int n = 0, moving = 0;
+    for (int pass = 2; pass >= 1; pass--) {
+        for (int g = 0; g < mr->regionCount; g++) {
+            if (mr->regionState[g] != pass) continue;
+            const MultiRateRegion* r = &mr->regions[g];
+            for (int m = r->first; m < r->first + r->count; m++) {
+                int i = mr->members[m].index;
+                mr->work[n] = p[i];
+                mr->workIndex[n] = i;
+                mr->frozen[n] = pass == 1;
+                n++;
+            }
+        }
+        if (pass == 2) moving = n;
+    }
+    *total = n;
+    return moving;
+}
+
+static void integrate_moving(MultiRate* mr, const ForceFieldSet* forces, int moving, float dt) {
+    vec3 uniform;
+    int isUniform = force_fields_uniform(forces, uniform) && !forces->particleAcceleration;
+    for (int k = 0; k < moving; k++) {
+        int i = mr->workIndex[k];
+        float h = ldexpf(dt, -mr->level[i]);
+        Particles* q = &mr->work[k];
+        if (isUniform) {
+            update_physics(uniform, q, h);
+            continue;
+        }
+        vec3 vel, acc;
+        glm_vec3_sub(q->current, q->previus, vel);
+        glm_vec3_scale(vel, 1.0f / h, vel);
+        force_fields_eval(forces, q->current, vel, acc);
+        if (forces->particleAcceleration)
+            glm_vec3_add(acc, forces->particleAcceleration[i], acc);
+        update_physics(acc, q, h);
+    }
+}
+
+static inline uint64_t pair_key(int i, int j) {
+    if (i > j) { int t = i; i = j; j = t; }
+    return ((uint64_t)(unsigned int)i << 32) | (unsigned int)j;
+}
+
+static int reserve_contacts(ContactCache* cache, int need) {
+    if (need <= cache->capacity) return 1;
+    Contact* grown = realloc(cache->items, need * sizeof(Contact));
+    if (!grown) return 0;
+    cache->items = grown;
+    cache->capacity = need;
+    return 1;
+}
+
+// Pasa a la caché del subpaso los pares de contacts con las dos partículas
+// en work y alguna que avanza (los de dos congeladas esperan su turno),
+// con índices de work. Sin memoria el subpaso arranca sin warm start.
+static void take_contacts(MultiRate* mr, ContactCache* contacts, int count) {
+    ContactCache* local = &mr->contacts;
+    local->count = 0;
+    if (!reserve_contacts(local, contacts->count)) return;
+    int kept = 0;
+    for (int k = 0; k < contacts->count; k++) {
+        Contact c = contacts->items[k];
+        int i = (int)(c.key >> 32), j = (int)(c.key & 0xffffffffu);
+        int li = i < count ? mr->localIndex[i] : -1;
+        int lj = j < count ? mr->localIndex[j] : -1;
+        if (li >= 0 && lj >= 0 && (!mr->frozen[li] || !mr->frozen[lj])) {
+            c.key = pair_key(li, lj);
+            local->items[local->count++] = c;
+        } else {
+            contacts->items[kept++] = c;
+        }
+    }
+    contacts->count = kept;
+}
+
+// Devuelve a contacts lo que dejó el solver, con índices de p. El orden no
+// importa para el warm start; el próximo paso común la vuelve a ordenar.
+static void return_contacts(MultiRate* mr, ContactCache* contacts) {
+    const ContactCache* local = &mr->contacts;
+    if (!reserve_contacts(contacts, contacts->count + local->count)) return;
+    for (int k = 0; k < local->count; k++) {
+        int li = (int)(local->items[k].key >> 32), lj = (int)(local->items[k].key & 0xffffffffu);
+        Contact* c = &contacts->items[contacts->count++];
+        c->key = pair_key(mr->workIndex[li], mr->workIndex[lj]);
+        c->lambda = local->items[k].lambda;
+    }
+}
+
+int multirate_step(MultiRate* mr, Config* cfg, const ForceFieldSet* forces,
+                   Particles* p, int count, float dt, ContactCache* contacts) {
+    mr->substeps = 1;
+    mr->updates = count;
+    if (count <= 0) return 0;
+    if (count > mr->capacity) count = mr->capacity;
+
+    // En el dominio periódico las regiones no dan la vuelta: ahí (y si todo
+    // es lento) se hace un paso común
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    int top = env && env->periodic ? 0 : bin_regions(mr, cfg, p, count);
+    if (top == 0) {
+        integrate_particles(cfg, forces, p, count, dt);
+        return resolve_collisions_cached(cfg, p, count, contacts);
+    }
+
+    const int substeps = 1 << top;
+    rescale_steps(mr, p, count, 1);
+    mr->substeps = substeps;
+    mr->updates = 0;
+    int maxSweeps = 0;
+
+    for (int s = 0; s < substeps; s++) {
+        // avanza la región de nivel k si su paso (2^(top - k) subpasos)
+        // termina en s
+        memset(mr->regionState, 0, mr->regionCount);
+        for (int g = 0; g < mr->regionCount; g++) {
+            int period = 1 << (top - mr->regions[g].level);
+            if ((s + 1) % period == 0) mr->regionState[g] = 2;
+        }
+        for (int g = 0; g < mr->regionCount; g++) {
+            if (mr->regionState[g] != 2) continue;
+            const MultiRateRegion* r = &mr->regions[g];
+            for (int k = 0; k < r->neighbourCount; k++)
+                if (mr->regionState[r->neighbours[k]] == 0)
+                    mr->regionState[r->neighbours[k]] = 1;
+        }
+
+        int total = 0;
+        int moving = gather(mr, p, &total);
+        if (moving == 0) continue;
+        integrate_moving(mr, forces, moving, dt);
+        if (env) env->collide(cfg, mr->work, moving);
+
+        for (int k = 0; k < total; k++) mr->localIndex[mr->workIndex[k]] = k;
+        take_contacts(mr, contacts, count);
+        int sweeps = resolve_collisions_masked(cfg, mr->work, total, &mr->contacts, mr->frozen);
+        if (sweeps > maxSweeps) maxSweeps = sweeps;
+        return_contacts(mr, contacts);
+        for (int k = 0; k < total; k++) mr->localIndex[mr->workIndex[k]] = -1;
+
+        for (int k = 0; k < moving; k++)
+            p[mr->workIndex[k]] = mr->work[k];
+        mr->updates += moving;
+    }
+
+    rescale_steps(mr, p, count, 0);
+    return maxSweeps;
+}
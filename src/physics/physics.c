@@ -1,85 +1,83 @@
 #include "physics/physics.h"
+#include "physics/env.h"
+#include "physics/grid.h"
+#include "physics/kernels.h"
+#include "physics/sweep.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <math.h>
 #include <cglm/cglm.h>
 
-#define HASH_TABLE_SIZE 2097152     // primo cercano a 2ⁿ para buen hashing
-#define MAX_BUCKET_SIZE 32          // max partículas por celda
-
-// Tabla de hash: por simplicidad, un arreglo fijo de buckets
-static int hashCount[HASH_TABLE_SIZE];
-static int hashTable[HASH_TABLE_SIZE][MAX_BUCKET_SIZE];
-
-// Constantes de hashing
-static const unsigned int p1 = 73856093u;
-static const unsigned int p2 = 19349663u;
-static const unsigned int p3 = 83492791u;
-
-// Función de hash espacial
-static inline unsigned int spatial_hash(int x, int y, int z) {
-    unsigned int h = (unsigned int)(x * p1 ^ y * p2 ^ z * p3);
-    return h & (HASH_TABLE_SIZE - 1);  // asume HASH_TABLE_SIZE potencia de 2
-}
-
-// Calcula coords de celda
-static inline void get_cell_coords(const vec3 pos, float cellSize, int *ix, int *iy, int *iz) {
-    *ix = (int)floorf(pos[0] / cellSize);
-    *iy = (int)floorf(pos[1] / cellSize);
-    *iz = (int)floorf(pos[2] / cellSize);
-}
-
-void collision_box(Config *config, Particles* p) {
-    float boxMin[3] = {-config->ENV_SIZE, -config->ENV_SIZE, -config->ENV_SIZE};
-    float boxMax[3] = { config->ENV_SIZE,  config->ENV_SIZE,  config->ENV_SIZE};
-    for (int i = 0; i < 3; ++i) {
-        float min = boxMin[i] + p->radius;
-        float max = boxMax[i] - p->radius;
-
-        float disp = p->current[i] - p->previus[i];
-        if (p->current[i] < min) {
-            p->current[i] = min;
-            p->previus[i] = p->current[i]+disp; // rebote simple
-        } else if (p->current[i] > max) {
-            p->current[i] = max;
-            p->previus[i] = p->current[i]+disp;
-        }
-    }
-}
+// Estado del solver adaptativo: marcas por bucket (evitan limpiar las
+// tablas en cada pasada) y listas de buckets a barrer
+static unsigned int activeStamp[HASH_TABLE_SIZE];
+static unsigned int nextStamp[HASH_TABLE_SIZE];
+static unsigned int sweepStamp = 0;
 
-void collision_sphere(Config *config, Particles* p) {
-    float env_radius = 2.0f * config->ENV_SIZE;
-    float max_dist   = env_radius - p->radius;
+// Candidatos de un bucket que pasaron el filtro de distancia
+static int contactHits[MAX_BUCKET_SIZE];
 
-    float dist = glm_vec3_norm(p->current);
+static unsigned int* activeList = NULL;
+static unsigned int* dirtyList = NULL;
+static int dirtyCount = 0;
+static int bufferCapacity = 0;
 
-    if (dist > max_dist) {
-        // Vector normal desde el centro hacia la partícula
-        vec3 normal;
-        glm_vec3_normalize_to(p->current, normal);
+#define CONTACT_PADDING 1e-3f
+#define SWEEP_MARGIN 0.5f  // holgura de los pares del barrido, en radios
 
-        // Calcular velocidad implícita (Verlet)
-        vec3 velocity;
-        glm_vec3_sub(p->current, p->previus, velocity);
+// BROADPHASE_SWEEP: pares del barrido, los que se revisan en la pasada y
+// la marca de las partículas que quedaron penetradas
+static SweepPrune sweep = {0};
+static int* pairList = NULL;
+static int pairListCapacity = 0;
+static unsigned int* particleStamp = NULL;
 
-        // Reubicar la partícula justo sobre la superficie
-        glm_vec3_scale(normal, max_dist, p->current);
+// Caché de la simulación principal (la de resolve_collisions)
+static ContactCache defaultContacts = {0};
 
-        // Reflejar la velocidad
-        float v_dot_n = glm_vec3_dot(velocity, normal);
-        vec3 v_reflected;
-        glm_vec3_scale(normal, 2.0f * v_dot_n, v_reflected);
-        glm_vec3_sub(velocity, v_reflected, velocity);
+// Masa proporcional al volumen (densidad uniforme): qué fracción de una
+// corrección le toca a i. Con radios iguales es exactamente 0.5. Las
+// congeladas tienen masa infinita.
+static inline float mass_share(const Particles* particle, int i, int j,
+                               const unsigned char* frozen) {
+    if (frozen) {
+        if (frozen[i]) return 0.0f;
+        if (frozen[j]) return 1.0f;
+    }
+    float mi = particle[i].radius * particle[i].radius * particle[i].radius;
+    float mj = particle[j].radius * particle[j].radius * particle[j].radius;
+    return mj / (mi + mj);
+}
 
-        // Aplicar pérdida de energía
-        glm_vec3_scale(velocity, 0.9f, velocity);  // podés ajustar 0.9f
+static inline uint64_t contact_key(int i, int j) {
+    if (i > j) { int t = i; i = j; j = t; }
+    return ((uint64_t)(unsigned int)i << 32) | (unsigned int)j;
+}
 
-        // Reconstruir previus en base a la nueva posición y velocidad
-        glm_vec3_sub(p->current, velocity, p->previus);
+// Agranda los buffers por partícula del solver si hace falta
+static int reserve_buffers(int count) {
+    if (count <= bufferCapacity) return 1;
+    int capacity = bufferCapacity > 0 ? bufferCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    unsigned int* active   = realloc(activeList, capacity * sizeof(unsigned int));
+    if (active) activeList = active;
+    unsigned int* dirty    = realloc(dirtyList, capacity * sizeof(unsigned int));
+    if (dirty) dirtyList   = dirty;
+    unsigned int* stamps   = realloc(particleStamp, capacity * sizeof(unsigned int));
+    if (stamps) particleStamp = stamps;
+    if (!active || !dirty || !stamps) {
+        fprintf(stderr, "Failed to alloc collision buffers\n");
+        return 0;
     }
+    memset(particleStamp + bufferCapacity, 0, (capacity - bufferCapacity) * sizeof(unsigned int));
+    bufferCapacity = capacity;
+    return 1;
 }
 
-
-void update_physics(Config *config, Particles* p,  float dt) {
+void update_physics(const vec3 acceleration, Particles* p, float dt) {
     float dt2 = dt*dt;
     vec3 res;
 
@@ -88,97 +86,951 @@ void update_physics(Config *config, Particles* p,  float dt) {
     glm_vec3_sub(res, p->previus, res);
 
     vec3 accTerm;
-    glm_vec3_scale(p->acceleration, dt2, accTerm);
+    glm_vec3_scale((float*)acceleration, dt2, accTerm);
     glm_vec3_scale(accTerm, 0.5, accTerm);
     glm_vec3_add(res, accTerm, res);
 
     // Update
     glm_vec3_copy(p->current, p->previus);
     glm_vec3_copy(res, p->current);
-    switch (config->ENV_TYPE) {
-        case ENV_BOX:
-            collision_box(config, p);
-            break;
-        case ENV_SPHERE:
-            collision_sphere(config, p);
-            break;
+}
+
+// Integra las partículas lo .. hi (el índice cuenta para
+// particleAcceleration)
+static void integrate_range(Config *config, const ForceFieldSet* forces,
+                            Particles* p, int lo, int hi, float dt) {
+    vec3 acc;
+    // Caso común: sólo campos uniformes, se evalúan una vez para todas
+    if (force_fields_uniform(forces, acc) && !forces->particleAcceleration) {
+        physicsKernels->integrate_uniform(acc, p + lo, hi - lo, dt);
+    } else {
+        float invDt = dt > 0.0f ? 1.0f / dt : 0.0f;
+        for (int i = lo; i < hi; i++) {
+            vec3 vel;
+            glm_vec3_sub(p[i].current, p[i].previus, vel);
+            glm_vec3_scale(vel, invDt, vel);
+            force_fields_eval(forces, p[i].current, vel, acc);
+            if (forces->particleAcceleration)
+                glm_vec3_add(acc, forces->particleAcceleration[i], acc);
+            update_physics(acc, &p[i], dt);
+        }
     }
+
+    // Colisión contra el contenedor, en un solo lote
+    const EnvInterface* env = env_get(config->ENV_TYPE);
+    if (env) env->collide(config, p + lo, hi - lo);
 }
 
+void integrate_particles(Config *config, const ForceFieldSet* forces,
+                         Particles* p, int count, float dt) {
+    integrate_range(config, forces, p, 0, count, dt);
+}
 
-void resolve_collisions(Particles* particle, int count) {
-    // Parámetro: tamaño de celda = doble del radio máximo
-    float maxRadius = 0.0f;
-    for (int i = 0; i < count; i++)
-        if (particle[i].radius > maxRadius) maxRadius = particle[i].radius;
-    float cellSize = maxRadius * 2.0f;
 
-    // 1) Limpiar hash
-    memset(hashCount, 0, sizeof(hashCount));
+// Agrega la corrección de un contacto al registro del paso actual
+static inline void contact_log_push(ContactCache* cache, int i, int j, float lambda) {
+    if (cache->logCount == cache->logCapacity) {
+        int capacity = cache->logCapacity > 0 ? cache->logCapacity * 2 : 4096;
+        Contact* grown = realloc(cache->log, capacity * sizeof(Contact));
+        if (!grown) return;  // sin memoria: sólo se pierde el warm start
+        cache->log = grown;
+        cache->logCapacity = capacity;
+    }
+    cache->log[cache->logCount].key = contact_key(i, j);
+    cache->log[cache->logCount].lambda = lambda;
+    cache->logCount++;
+}
+
+static int compare_contacts(const void* a, const void* b) {
+    uint64_t ka = ((const Contact*)a)->key;
+    uint64_t kb = ((const Contact*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Ordena el registro del paso y suma las correcciones del mismo par: el
+// resultado queda como caché para el próximo paso
+static void rebuild_contact_cache(ContactCache* cache) {
+    Contact* log = cache->log;
+    qsort(log, cache->logCount, sizeof(Contact), compare_contacts);
+    int n = 0;
+    for (int k = 0; k < cache->logCount; k++) {
+        if (n > 0 && log[n-1].key == log[k].key)
+            log[n-1].lambda += log[k].lambda;
+        else
+            log[n++] = log[k];
+    }
+
+    // el registro pasa a ser la caché y la caché vieja el próximo registro
+    Contact* items = cache->items;
+    int capacity = cache->capacity;
+    cache->items = log;
+    cache->count = n;
+    cache->capacity = cache->logCapacity;
+    cache->log = items;
+    cache->logCount = 0;
+    cache->logCapacity = capacity;
+}
+
+void contact_cache_free(ContactCache* cache) {
+    free(cache->items);
+    free(cache->log);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Warm start: vuelve a aplicar (escalada) la corrección que cada par en
+// contacto acumuló en el paso anterior. En pilas apoyadas la gravedad
+// genera casi la misma penetración cada paso, así que esto deja el
+// sistema cerca de la solución antes de la primera pasada.
+static void warm_start_contacts(ContactCache* cache, Particles* particle, int count, float factor,
+                                const unsigned char* frozen) {
+    for (int k = 0; k < cache->count; k++) {
+        int i = (int)(cache->items[k].key >> 32);
+        int j = (int)(cache->items[k].key & 0xffffffffu);
+        if (j >= count || (frozen && frozen[i] && frozen[j])) continue;
+
+        vec3 diff;
+        glm_vec3_sub(particle[j].current, particle[i].current, diff);
+        minimum_image(diff);
+        float dist = glm_vec3_norm(diff);
+        float overlap = particle[i].radius + particle[j].radius + CONTACT_PADDING - dist;
+        if (dist <= 0.0f || overlap <= 0.0f) continue;  // el contacto se rompió
+
+        // nunca separar más de lo que hoy se solapan
+        float lambda = factor * cache->items[k].lambda;
+        if (lambda > overlap) lambda = overlap;
+
+        float share = mass_share(particle, i, j, frozen);
+        vec3 correction;
+        glm_vec3_scale(diff, share * lambda / dist, correction);
+        glm_vec3_sub(particle[i].current, correction, particle[i].current);
+        glm_vec3_scale(diff, (1.0f - share) * lambda / dist, correction);
+        glm_vec3_add(particle[j].current, correction, particle[j].current);
+        contact_log_push(cache, i, j, lambda);
+    }
+}
+
+// Resuelve (si hace falta) el contacto i-j. Devuelve la penetración real
+// encontrada (0 si no se tocan) y anota la corrección aplicada en la
+// caché de contactos.
+static inline float solve_contact(Particles* particle, int i, int j, float restitution,
+                                  ContactCache* cache, const unsigned char* frozen) {
+    const float padding = CONTACT_PADDING;
+
+    vec3 diff;
+    glm_vec3_sub(particle[j].current, particle[i].current, diff);
+    minimum_image(diff);
+    float dist = glm_vec3_norm(diff);
+    float minDist = particle[i].radius + particle[j].radius;
+    if (dist <= 0.0f || dist >= minDist + padding) return 0.0f;
+
+    // Separación de posiciones, repartida según la masa
+    float overlap = (minDist + padding - dist);
+    float share = mass_share(particle, i, j, frozen);
+    vec3 normal;
+    glm_vec3_divs(diff, dist, normal);  // normaliza diff
+    vec3 correction;
+    // desplaza i y j en direcciones opuestas
+    glm_vec3_scale(normal, overlap * share, correction);
+    glm_vec3_sub(particle[i].current, correction, particle[i].current);
+    glm_vec3_scale(normal, overlap * (1.0f - share), correction);
+    glm_vec3_add(particle[j].current, correction, particle[j].current);
+    contact_log_push(cache, i, j, overlap);
+
+    // Impulso de colisión elástica
+    // calcula componente normal de la velocidad relativa
+    vec3 relVel;
+    glm_vec3_sub(particle[j].previus, particle[i].previus, relVel);
+    minimum_image(relVel);
+    float vRel = glm_vec3_dot(relVel, normal);
+    if (vRel <= 0.0f) {
+        // impulso -(1 + e) vRel / (1/mi + 1/mj), en cambio de velocidad
+        float jImpulse = -(1.0f + restitution) * vRel;
+        vec3 impulse;
+        glm_vec3_scale(normal, jImpulse * share, impulse);
+        glm_vec3_sub(particle[i].previus, impulse, particle[i].previus);
+        glm_vec3_scale(normal, jImpulse * (1.0f - share), impulse);
+        glm_vec3_add(particle[j].previus, impulse, particle[j].previus);
+    }
+    return minDist - dist > 0.0f ? minDist - dist : 0.0f;
+}
+
+static inline void mark_dirty(unsigned int h, unsigned int stamp) {
+    if (nextStamp[h] != stamp) {
+        nextStamp[h] = stamp;
+        dirtyList[dirtyCount++] = h;
+    }
+}
+
+// Pasadas del solver sobre los pares de sweep_find_pairs en vez de las
+// celdas. Como con la grilla, cada pasada sólo revisa los pares que tocan
+// a una partícula que quedó penetrada en la anterior. El pool (puede ser
+// NULL) sólo reparte el orden desde cero del barrido.
+static int resolve_pairs(Config* config, Particles* particle, int count,
+                         ContactCache* contacts, const unsigned char* frozen, TaskPool* pool) {
+    float margin = CONTACT_PADDING + SWEEP_MARGIN * grid.largeRadius;
+    float period = grid.periodic ? grid.period : 0.0f;
+    int pairCount = sweep_find_pairs(&sweep, particle, count, margin, grid.origin, period, frozen,
+                                     pool);
+    if (pairCount < 0) return 0;
+    if (pairCount > pairListCapacity) {
+        int capacity = pairListCapacity > 0 ? pairListCapacity : 4096;
+        while (capacity < pairCount) capacity *= 2;
+        int* list = realloc(pairList, capacity * sizeof(int));
+        if (!list) {
+            fprintf(stderr, "Failed to alloc collision buffers\n");
+            return 0;
+        }
+        pairList = list;
+        pairListCapacity = capacity;
+    }
+    for (int k = 0; k < pairCount; k++) pairList[k] = k;
+
+    int maxIterations = config->SOLVER_ITERATIONS > 0 ? (int)config->SOLVER_ITERATIONS : 1;
+    float tolerance = config->SOLVER_TOLERANCE;
+    float restitution = config->RESTITUTION;
+    int activeCount = pairCount;
+    int it = 0;
+    while (it < maxIterations && activeCount > 0) {
+        unsigned int stamp = ++sweepStamp;
+        float maxPenetration = 0.0f;
+        for (int a = 0; a < activeCount; a++) {
+            const SweepPair* pair = &sweep.pairs[pairList[a]];
+            float pen = solve_contact(particle, pair->i, pair->j, restitution, contacts, frozen);
+            if (pen > tolerance) particleStamp[pair->i] = particleStamp[pair->j] = stamp;
+            if (pen > maxPenetration) maxPenetration = pen;
+        }
+        it++;
+        if (maxPenetration <= tolerance) break;
+
+        activeCount = 0;
+        for (int k = 0; k < pairCount; k++)
+            if (particleStamp[sweep.pairs[k].i] == stamp || particleStamp[sweep.pairs[k].j] == stamp)
+                pairList[activeCount++] = k;
+    }
+    rebuild_contact_cache(contacts);
+    return it;
+}
+
+// ------------------------------------------------------------- teselas
+//
+// Con SOLVER_TILE > 0 las celdas se agrupan en teselas de SOLVER_TILE por
+// lado. Cada tesela copia sus partículas y las de la capa de celdas que la
+// rodea (el halo) a un buffer chico, contiguo y ordenado por celda, relaja
+// ahí todos sus contactos y copia el resultado de vuelta. El solver recorre
+// memoria en orden en vez de escribir en posiciones al azar de todo el
+// arreglo en cada contacto.
+//
+// Los pares entre la tesela y su halo los resuelven las dos teselas (las
+// correcciones repetidas se suman en la caché, como las de varias
+// pasadas). Las grandes que se mueven no entran: las resuelve solve_large.
+
+// Copia de trabajo: la tesela y su halo en (lado + 2)³ celdas locales. Los
+// arreglos tienen CONTACT_BATCH lugares de más para el último bloque de
+// contact_batch.
+typedef struct {
+    float* x;  float* y;  float* z;   // current
+    float* px; float* py; float* pz;  // previus
+    float* r;
+    int* index;                       // partícula global
+    int* cell;                        // celda local
+    unsigned char* owned;             // de la tesela (no del halo)
+    unsigned char* frozen;
+    unsigned char* pushed;            // del halo y corregida más que la tolerancia
+    int* hits;                        // candidatos de contact_batch
+    int count;
+    int capacity;
+    int* cellStart;                   // comienzo de cada celda local y el final
+    unsigned char* near;              // celdas locales vecinas de una ocupada
+    int cellCapacity;
+} TileScratch;
+
+static TileScratch scratch = {0};
+
+// Lo juntado de una tesela antes de ordenarlo por celda local
+static int* gatherIndex = NULL;
+static int* gatherCell = NULL;
+static int gatherCapacity = 0;
+
+// Teselas del paso: tileParticles[tileStart[t] .. tileStart[t + 1]) son
+// las partículas de la tesela t
+static int tileCount = 0;
+static int (*tileCoord)[3] = NULL;
+static int* tileStart = NULL;
+static int* tileParticles = NULL;
+static int* tileOf = NULL;
+static unsigned int* tileStamp = NULL;
+static int* tileActive = NULL;
+static int* tileNext = NULL;
+static int tileNextCount = 0;
+static int* tileSlot = NULL;  // tabla abierta de coordenadas de tesela a id
+static int tileCapacity = 0;
+
+static inline int floor_div(int c, int n) {
+    return c >= 0 ? c / n : -((-c + n - 1) / n);
+}
+
+static void mark_tile(int t, unsigned int stamp) {
+    if (tileStamp[t] != stamp) {
+        tileStamp[t] = stamp;
+        tileNext[tileNextCount++] = t;
+    }
+}
+
+// Agranda los buffers de teselas si hace falta (nunca hay más teselas que
+// partículas)
+static int reserve_tiles(int count) {
+    if (count <= tileCapacity) return 1;
+    int capacity = tileCapacity > 0 ? tileCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    int (*coords)[3]    = realloc(tileCoord, capacity * sizeof(*tileCoord));
+    if (coords) tileCoord = coords;
+    int* start          = realloc(tileStart, (capacity + 1) * sizeof(int));
+    if (start) tileStart = start;
+    int* members        = realloc(tileParticles, capacity * sizeof(int));
+    if (members) tileParticles = members;
+    int* owner          = realloc(tileOf, capacity * sizeof(int));
+    if (owner) tileOf = owner;
+    unsigned int* stamp = realloc(tileStamp, capacity * sizeof(unsigned int));
+    if (stamp) tileStamp = stamp;
+    int* active         = realloc(tileActive, capacity * sizeof(int));
+    if (active) tileActive = active;
+    int* next           = realloc(tileNext, capacity * sizeof(int));
+    if (next) tileNext = next;
+    int* slot           = realloc(tileSlot, 2 * capacity * sizeof(int));
+    if (slot) tileSlot = slot;
+    if (!coords || !start || !members || !owner || !stamp || !active || !next || !slot) {
+        fprintf(stderr, "Failed to alloc tile buffers\n");
+        return 0;
+    }
+    memset(tileStamp + tileCapacity, 0, (capacity - tileCapacity) * sizeof(unsigned int));
+    tileCapacity = capacity;
+    return 1;
+}
+
+static int reserve_gather(int count) {
+    if (count <= gatherCapacity) return 1;
+    int capacity = gatherCapacity > 0 ? gatherCapacity : 1024;
+    while (capacity < count) capacity *= 2;
 
-    // 2) Insertar cada partícula en su celda
+    int* index = realloc(gatherIndex, capacity * sizeof(int));
+    if (index) gatherIndex = index;
+    int* cell  = realloc(gatherCell, capacity * sizeof(int));
+    if (cell) gatherCell = cell;
+    if (!index || !cell) {
+        fprintf(stderr, "Failed to alloc tile buffers\n");
+        return 0;
+    }
+    gatherCapacity = capacity;
+    return 1;
+}
+
+static int reserve_scratch(int count, int cells) {
+    if (cells + 1 > scratch.cellCapacity) {
+        int* start = realloc(scratch.cellStart, (cells + 1) * sizeof(int));
+        if (start) scratch.cellStart = start;
+        unsigned char* near = realloc(scratch.near, cells + 1);
+        if (near) scratch.near = near;
+        if (!start || !near) {
+            fprintf(stderr, "Failed to alloc tile scratch\n");
+            return 0;
+        }
+        scratch.cellCapacity = cells + 1;
+    }
+    if (count <= scratch.capacity) return 1;
+    int capacity = scratch.capacity > 0 ? scratch.capacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    int ok = 1;
+    float** floats[] = { &scratch.x, &scratch.y, &scratch.z,
+                         &scratch.px, &scratch.py, &scratch.pz, &scratch.r };
+    for (int k = 0; k < 7; k++) {
+        float* grown = realloc(*floats[k], (capacity + CONTACT_BATCH) * sizeof(float));
+        if (grown) *floats[k] = grown;
+        ok = ok && grown;
+    }
+    int** ints[] = { &scratch.index, &scratch.cell, &scratch.hits };
+    for (int k = 0; k < 3; k++) {
+        int* grown = realloc(*ints[k], (capacity + CONTACT_BATCH) * sizeof(int));
+        if (grown) *ints[k] = grown;
+        ok = ok && grown;
+    }
+    unsigned char** flags[] = { &scratch.owned, &scratch.frozen, &scratch.pushed };
+    for (int k = 0; k < 3; k++) {
+        unsigned char* grown = realloc(*flags[k], capacity);
+        if (grown) *flags[k] = grown;
+        ok = ok && grown;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to alloc tile scratch\n");
+        return 0;
+    }
+    scratch.capacity = capacity;
+    return 1;
+}
+
+// Agrupa las partículas por tesela con una tabla abierta y un counting
+// sort
+static int build_tiles(int count, int side) {
+    if (!reserve_tiles(count)) return 0;
+    unsigned int slots = 2u * (unsigned int)tileCapacity;  // potencia de 2
+    memset(tileSlot, -1, slots * sizeof(int));
+    tileCount = 0;
+    tileStart[0] = 0;
     for (int i = 0; i < count; i++) {
-        int cx, cy, cz;
-        get_cell_coords(particle[i].current, cellSize, &cx, &cy, &cz);
-        unsigned int h = spatial_hash(cx, cy, cz);
-        if (hashCount[h] < MAX_BUCKET_SIZE)
-            hashTable[h][hashCount[h]++] = i;
-    }
-
-    // 3) Varias iteraciones de corrección (evita que queden atrapadas)
-    const int iterations = 4;
-    const float restitution = 0.8f;  // coeficiente de restitución
-    const float padding = 1e-3f;
-
-    for (int it = 0; it < iterations; it++) {
-        // Para cada partícula
-        for (int i = 0; i < count; i++) {
-            // Localizar su celda base
-            int cx, cy, cz;
-            get_cell_coords(particle[i].current, cellSize, &cx, &cy, &cz);
-
-            // Chequear vecinos en las 27 celdas alrededor
-            for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-            for (int dz = -1; dz <= 1; dz++) {
-                unsigned int h = spatial_hash(cx+dx, cy+dy, cz+dz);
-                int bucketSize = hashCount[h];
-                for (int bi = 0; bi < bucketSize; bi++) {
-                    int j = hashTable[h][bi];
-                    if (j <= i) continue;  // evita duplicados y self
-
-                    vec3 diff;
-                    glm_vec3_sub(particle[j].current, particle[i].current, diff);
-                    float dist = glm_vec3_norm(diff);
-                    float minDist = particle[i].radius + particle[j].radius;
-                    if (dist <= 0.0f || dist >= minDist + padding) continue;
-
-                    // 3a) Separación de posiciones
-                    float overlap = (minDist + padding - dist);
-                    vec3 normal;
-                    glm_vec3_divs(diff, dist, normal);  // normaliza diff
-                    vec3 correction;
-                    glm_vec3_scale(normal, overlap * 0.5f, correction);
-                    // desplaza i y j en direcciones opuestas
-                    glm_vec3_sub(particle[i].current, correction, particle[i].current);
-                    glm_vec3_add(particle[j].current, correction, particle[j].current);
-
-                    // 3b) Impulso de colisión elástica
-                    // calcula componente normal de la velocidad relativa
-                    vec3 relVel;
-                    glm_vec3_sub(particle[j].previus, particle[i].previus, relVel);
-                    float vRel = glm_vec3_dot(relVel, normal);
-                    if (vRel > 0.0f) continue;  // se alejan, no aplica impulso
-
-                    // masa = 1 para ambas → impulso simple
-                    float jImpulse = -(1.0f + restitution) * vRel * 0.5f;
-                    vec3 impulse;
-                    glm_vec3_scale(normal, jImpulse, impulse);
-                    glm_vec3_sub(particle[i].previus, impulse, particle[i].previus);
-                    glm_vec3_add(particle[j].previus, impulse, particle[j].previus);
+        int tx = floor_div(cellCoord[i][0], side);
+        int ty = floor_div(cellCoord[i][1], side);
+        int tz = floor_div(cellCoord[i][2], side);
+        unsigned int h = (unsigned int)(tx * HASH_P1 ^ ty * HASH_P2 ^ tz * HASH_P3) & (slots - 1);
+        int t;
+        while ((t = tileSlot[h]) >= 0 &&
+               (tileCoord[t][0] != tx || tileCoord[t][1] != ty || tileCoord[t][2] != tz))
+            h = (h + 1) & (slots - 1);
+        if (t < 0) {
+            t = tileCount++;
+            tileSlot[h] = t;
+            tileCoord[t][0] = tx;
+            tileCoord[t][1] = ty;
+            tileCoord[t][2] = tz;
+            tileStart[t + 1] = 0;
+        }
+        tileOf[i] = t;
+        tileStart[t + 1]++;
+    }
+    for (int t = 0; t < tileCount; t++) {
+        tileStart[t + 1] += tileStart[t];
+        tileActive[t] = tileStart[t];  // cursor del reparto
+    }
+    for (int i = 0; i < count; i++)
+        tileParticles[tileActive[tileOf[i]]++] = i;
+    return 1;
+}
+
+// Posición local (0 .. lado + 1) de la celda c en la tesela que empieza en
+// base, dando la vuelta en el dominio periódico
+static inline int local_coord(int c, int base) {
+    int d = c - (base - 1);
+    if (grid.periodic) {
+        d %= grid.cells;
+        if (d < 0) d += grid.cells;
+    }
+    return d;
+}
+
+static inline int in_tile(const int c[3], int t, int side) {
+    return floor_div(c[0], side) == tileCoord[t][0] &&
+           floor_div(c[1], side) == tileCoord[t][1] &&
+           floor_div(c[2], side) == tileCoord[t][2];
+}
+
+// Copia la tesela t y su halo al buffer, ordenados por celda local.
+// Devuelve 0 si no pudo reservar memoria.
+static int gather_tile(const Particles* particle, int t, int side, const unsigned char* frozen) {
+    const int E = side + 2;
+    const float largeRadius = grid.largeRadius;
+    const int base[3] = { tileCoord[t][0] * side, tileCoord[t][1] * side, tileCoord[t][2] * side };
+
+    // Las de la tesela salen de su lista
+    const int cells = E * E * E;
+    int n = 0, owned = tileStart[t + 1] - tileStart[t];
+    if (!reserve_gather(owned) || !reserve_scratch(0, cells)) return 0;
+    for (int k = tileStart[t]; k < tileStart[t + 1]; k++) {
+        int i = tileParticles[k];
+        if (particle[i].radius > largeRadius && !(frozen && frozen[i])) continue;
+        gatherIndex[n] = i;
+        gatherCell[n] = (local_coord(cellCoord[i][0], base[0]) * E +
+                         local_coord(cellCoord[i][1], base[1])) * E +
+                         local_coord(cellCoord[i][2], base[2]);
+        n++;
+    }
+    owned = n;
+
+    // Halo: las celdas alrededor que no son de la tesela, desde los
+    // buckets. Sólo se miran las vecinas de una celda ocupada de la tesela
+    // y, fuera del periódico, dentro de las celdas ocupadas de la grilla.
+    // Sólo cuentan las partículas de esa celda exacta: el bucket puede
+    // tener otras por colisiones de hash.
+    unsigned char* near = scratch.near;
+    memset(near, 0, (size_t)E * E * E);
+    for (int k = 0; k < owned; k++) {
+        int c = gatherCell[k];
+        int lx = c / (E * E), ly = (c / E) % E, lz = c % E;
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dz = -1; dz <= 1; dz++)
+                    near[((lx + dx) * E + ly + dy) * E + lz + dz] = 1;
+    }
+    for (int lx = 0; lx < E; lx++)
+    for (int ly = 0; ly < E; ly++)
+    for (int lz = 0; lz < E; lz++) {
+        if (!near[(lx * E + ly) * E + lz]) continue;
+        int c[3] = { base[0] - 1 + lx, base[1] - 1 + ly, base[2] - 1 + lz };
+        if (grid.periodic)
+            for (int a = 0; a < 3; a++) c[a] = wrap_cell(c[a]);
+        else if (c[0] < grid.cellMin[0] || c[0] > grid.cellMax[0] ||
+                 c[1] < grid.cellMin[1] || c[1] > grid.cellMax[1] ||
+                 c[2] < grid.cellMin[2] || c[2] > grid.cellMax[2]) continue;
+        if (in_tile(c, t, side)) continue;
+        unsigned int h = spatial_hash(c[0], c[1], c[2]);
+        for (int b = 0; b < hashCount[h]; b++) {
+            int j = hashTable[h][b];
+            if (cellCoord[j][0] != c[0] || cellCoord[j][1] != c[1] || cellCoord[j][2] != c[2]) continue;
+            if (particle[j].radius > largeRadius && !(frozen && frozen[j])) continue;
+            if (!reserve_gather(n + 1)) return 0;
+            gatherIndex[n] = j;
+            gatherCell[n] = (lx * E + ly) * E + lz;
+            n++;
+        }
+    }
+
+    // Counting sort por celda local
+    if (!reserve_scratch(n, cells)) return 0;
+    int* start = scratch.cellStart;
+    memset(start, 0, (cells + 1) * sizeof(int));
+    for (int k = 0; k < n; k++) start[gatherCell[k] + 1]++;
+    for (int c = 0; c < cells; c++) start[c + 1] += start[c];
+    for (int k = 0; k < n; k++) {
+        int slot = start[gatherCell[k]]++;
+        int i = gatherIndex[k];
+        scratch.x[slot]  = particle[i].current[0];
+        scratch.y[slot]  = particle[i].current[1];
+        scratch.z[slot]  = particle[i].current[2];
+        scratch.px[slot] = particle[i].previus[0];
+        scratch.py[slot] = particle[i].previus[1];
+        scratch.pz[slot] = particle[i].previus[2];
+        scratch.r[slot]  = particle[i].radius;
+        scratch.index[slot]  = i;
+        scratch.cell[slot]   = gatherCell[k];
+        scratch.owned[slot]  = k < owned;
+        scratch.frozen[slot] = frozen ? frozen[i] != 0 : 0;
+        scratch.pushed[slot] = 0;
+    }
+    // el reparto dejó cada comienzo en el de la celda siguiente
+    for (int c = cells; c > 0; c--) start[c] = start[c - 1];
+    start[0] = 0;
+    scratch.count = n;
+    // el relleno que lee el último bloque de contact_batch
+    for (int k = n; k < n + CONTACT_BATCH; k++)
+        scratch.x[k] = scratch.y[k] = scratch.z[k] = scratch.r[k] = 0.0f;
+    return 1;
+}
+
+static void scatter_tile(Particles* particle) {
+    for (int k = 0; k < scratch.count; k++) {
+        Particles* q = &particle[scratch.index[k]];
+        q->current[0] = scratch.x[k];
+        q->current[1] = scratch.y[k];
+        q->current[2] = scratch.z[k];
+        q->previus[0] = scratch.px[k];
+        q->previus[1] = scratch.py[k];
+        q->previus[2] = scratch.pz[k];
+    }
+}
+
+// solve_contact sobre la copia de trabajo
+static inline float tile_contact(TileScratch* s, int a, int b, float restitution, float period,
+                                 ContactCache* cache) {
+    const float padding = CONTACT_PADDING;
+    float dx = s->x[b] - s->x[a];
+    float dy = s->y[b] - s->y[a];
+    float dz = s->z[b] - s->z[a];
+    if (period > 0.0f) {
+        dx -= period * floorf(dx / period + 0.5f);
+        dy -= period * floorf(dy / period + 0.5f);
+        dz -= period * floorf(dz / period + 0.5f);
+    }
+    float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+    float minDist = s->r[a] + s->r[b];
+    if (dist <= 0.0f || dist >= minDist + padding) return 0.0f;
+
+    float overlap = minDist + padding - dist;
+    float share;
+    if (s->frozen[a]) share = 0.0f;
+    else if (s->frozen[b]) share = 1.0f;
+    else {
+        float ma = s->r[a] * s->r[a] * s->r[a];
+        float mb = s->r[b] * s->r[b] * s->r[b];
+        share = mb / (ma + mb);
+    }
+    float nx = dx / dist, ny = dy / dist, nz = dz / dist;
+    s->x[a] -= nx * (overlap * share);
+    s->y[a] -= ny * (overlap * share);
+    s->z[a] -= nz * (overlap * share);
+    s->x[b] += nx * (overlap * (1.0f - share));
+    s->y[b] += ny * (overlap * (1.0f - share));
+    s->z[b] += nz * (overlap * (1.0f - share));
+    contact_log_push(cache, s->index[a], s->index[b], overlap);
+
+    float vx = s->px[b] - s->px[a];
+    float vy = s->py[b] - s->py[a];
+    float vz = s->pz[b] - s->pz[a];
+    if (period > 0.0f) {
+        vx -= period * floorf(vx / period + 0.5f);
+        vy -= period * floorf(vy / period + 0.5f);
+        vz -= period * floorf(vz / period + 0.5f);
+    }
+    float vRel = vx * nx + vy * ny + vz * nz;
+    if (vRel <= 0.0f) {
+        float jImpulse = -(1.0f + restitution) * vRel;
+        s->px[a] -= nx * (jImpulse * share);
+        s->py[a] -= ny * (jImpulse * share);
+        s->pz[a] -= nz * (jImpulse * share);
+        s->px[b] += nx * (jImpulse * (1.0f - share));
+        s->py[b] += ny * (jImpulse * (1.0f - share));
+        s->pz[b] += nz * (jImpulse * (1.0f - share));
+    }
+    return minDist - dist > 0.0f ? minDist - dist : 0.0f;
+}
+
+// Una pasada sobre la copia: cada partícula de la tesela mira las 27
+// celdas locales alrededor de la suya; entre dos de la tesela resuelve el
+// índice menor. Como la copia está ordenada por celda local, las tres
+// celdas vecinas en z son un solo rango contiguo: son 9 rangos, y
+// contact_batch los filtra por distancia al cuadrado antes de resolver
+// par por par. Devuelve la penetración máxima.
+static float relax_tile(TileScratch* s, int side, float restitution, float tolerance,
+                        float period, ContactCache* cache) {
+    const int E = side + 2;
+    int rows[9], o = 0;
+    for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+            rows[o++] = (dx * E + dy) * E;
+
+    float maxPenetration = 0.0f;
+    for (int a = 0; a < s->count; a++) {
+        if (!s->owned[a] || s->frozen[a]) continue;
+        for (int n = 0; n < 9; n++) {
+            int c = s->cell[a] + rows[n];
+            float at[3] = { s->x[a], s->y[a], s->z[a] };
+            int hits = physicsKernels->contact_batch(s->x, s->y, s->z, s->r,
+                                                     s->cellStart[c - 1], s->cellStart[c + 2],
+                                                     at, s->r[a] + CONTACT_PADDING, period,
+                                                     s->hits);
+            for (int h = 0; h < hits; h++) {
+                int b = s->hits[h];
+                if (b == a) continue;
+                // a una congelada nadie la barre: el par es de a
+                if (s->owned[b] && b < a && !s->frozen[b]) continue;
+                float pen = tile_contact(s, a, b, restitution, period, cache);
+                if (pen > tolerance && !s->owned[b]) s->pushed[b] = 1;
+                if (pen > maxPenetration) maxPenetration = pen;
+            }
+        }
+    }
+    return maxPenetration;
+}
+
+// Las grandes se barren siempre, con un vecindario más ancho. Resuelven
+// sus pares con las comunes y, entre grandes, el índice menor. Marcan para
+// la próxima pasada las celdas (o las teselas, con tiled) donde quedó
+// penetración. Devuelve la penetración máxima.
+static float solve_large(Particles* particle, float restitution, float tolerance, float period,
+                         ContactCache* contacts, const unsigned char* frozen,
+                         unsigned int active, int tiled) {
+    float largeRadius = grid.largeRadius;
+    float maxPenetration = 0.0f;
+    for (int l = 0; l < largeCount; l++) {
+        int i = largeList[l];
+        if (frozen && frozen[i]) continue;
+        int reach = grid_reach(particle[i].radius);
+        int nx[2 * GRID_MAX_REACH + 1], ny[2 * GRID_MAX_REACH + 1], nz[2 * GRID_MAX_REACH + 1];
+        int cntX = neighbour_span(cellCoord[i][0], reach, nx);
+        int cntY = neighbour_span(cellCoord[i][1], reach, ny);
+        int cntZ = neighbour_span(cellCoord[i][2], reach, nz);
+        for (int dx = 0; dx < cntX; dx++) {
+        for (int dy = 0; dy < cntY; dy++) {
+        for (int dz = 0; dz < cntZ; dz++) {
+            unsigned int h = spatial_hash(nx[dx], ny[dy], nz[dz]);
+            int hits = physicsKernels->contact_filter(particle, i, hashTable[h], hashCount[h],
+                                                      CONTACT_PADDING, period, contactHits);
+            for (int bi = 0; bi < hits; bi++) {
+                int j = contactHits[bi];
+                int jMoves = !frozen || !frozen[j];
+                if (j == i || (particle[j].radius > largeRadius && j < i && jMoves)) continue;
+
+                float pen = solve_contact(particle, i, j, restitution, contacts, frozen);
+                if (pen > tolerance) {
+                    if (tiled) mark_tile(tileOf[j], active);
+                    else mark_dirty(h, active);
                 }
-            } } }
+                if (pen > maxPenetration) maxPenetration = pen;
+            }
+        } } }
+    }
+    return maxPenetration;
+}
+
+// Solver por teselas. Cada pasada relaja las teselas activas (la primera,
+// todas las que tienen alguna partícula que se mueve); la siguiente repite
+// las que no llegaron a la tolerancia y las vecinas cuyas partículas
+// quedaron corregidas desde el halo de otra.
+static int resolve_tiles(Config* config, Particles* particle, int count,
+                         ContactCache* contacts, const unsigned char* frozen) {
+    const int side = (int)config->SOLVER_TILE;
+    if (!build_tiles(count, side)) return 0;
+
+    int activeCount = 0;
+    for (int t = 0; t < tileCount; t++) {
+        int moving = !frozen;
+        for (int k = tileStart[t]; k < tileStart[t + 1] && !moving; k++)
+            moving = !frozen[tileParticles[k]];
+        if (moving) tileActive[activeCount++] = t;
+    }
+
+    int maxIterations = config->SOLVER_ITERATIONS > 0 ? (int)config->SOLVER_ITERATIONS : 1;
+    float tolerance = config->SOLVER_TOLERANCE;
+    float restitution = config->RESTITUTION;
+    float period = grid.periodic ? grid.period : 0.0f;
+    int it = 0;
+    while (it < maxIterations && (activeCount > 0 || largeCount > 0)) {
+        unsigned int active = ++sweepStamp;
+        tileNextCount = 0;
+        for (int a = 0; a < activeCount; a++) {
+            int t = tileActive[a];
+            if (!gather_tile(particle, t, side, frozen)) return 0;
+            float pen = relax_tile(&scratch, side, restitution, tolerance, period, contacts);
+            scatter_tile(particle);
+            if (pen > tolerance) mark_tile(t, active);
+            for (int k = 0; k < scratch.count; k++)
+                if (scratch.pushed[k]) mark_tile(tileOf[scratch.index[k]], active);
+        }
+        float largePenetration = solve_large(particle, restitution, tolerance, period,
+                                             contacts, frozen, active, 1);
+        it++;
+        if (tileNextCount == 0 && largePenetration <= tolerance) break;
+
+        memcpy(tileActive, tileNext, tileNextCount * sizeof(int));
+        activeCount = tileNextCount;
+    }
+
+    rebuild_contact_cache(contacts);
+    return it;
+}
+
+int resolve_collisions(Config *config, Particles* particle, int count) {
+    return resolve_collisions_cached(config, particle, count, &defaultContacts);
+}
+
+int resolve_collisions_cached(Config *config, Particles* particle, int count,
+                              ContactCache* contacts) {
+    return resolve_collisions_masked(config, particle, count, contacts, NULL);
+}
+
+// El resto del solver, con la grilla ya armada y el warm start aplicado
+static int resolve_inserted(Config *config, Particles* particle, int count,
+                            ContactCache* contacts, const unsigned char* frozen, TaskPool* pool) {
+    if (config->BROADPHASE == BROADPHASE_SWEEP)
+        return resolve_pairs(config, particle, count, contacts, frozen, pool);
+    // Por teselas, si en el dominio periódico la tesela y su halo no dan
+    // la vuelta completa
+    int tile = (int)config->SOLVER_TILE;
+    if (tile > 0 && (!grid.periodic || grid.cells >= tile + 2))
+        return resolve_tiles(config, particle, count, contacts, frozen);
+    int activeCount = 0;
+    for (int k = 0; k < occupiedCount; k++) {
+        unsigned int h = occupiedList[k];
+        int moving = !frozen;
+        for (int b = 0; b < hashCount[h] && !moving; b++)
+            moving = !frozen[hashTable[h][b]];
+        if (moving) activeList[activeCount++] = h;
+    }
+
+    // 3) Pasadas de corrección hasta que la penetración máxima baje de la
+    //    tolerancia. Cada pasada sólo revisa las celdas que tuvieron
+    //    solapamientos en la anterior (la primera revisa todas).
+    int maxIterations = config->SOLVER_ITERATIONS > 0 ? (int)config->SOLVER_ITERATIONS : 1;
+    float tolerance = config->SOLVER_TOLERANCE;
+    float restitution = config->RESTITUTION;
+    float period = grid.periodic ? grid.period : 0.0f;
+    float largeRadius = grid.largeRadius;
+    int it = 0;
+
+    while (it < maxIterations && (activeCount > 0 || overflowCount > 0 || largeCount > 0)) {
+        unsigned int active = ++sweepStamp;  // marca de las celdas a barrer
+        for (int a = 0; a < activeCount; a++)
+            activeStamp[activeList[a]] = active;
+        dirtyCount = 0;
+        float maxPenetration = 0.0f;
+
+        for (int a = 0; a < activeCount + overflowCount; a++) {
+            int isOverflow = a >= activeCount;
+            unsigned int hi = isOverflow ? 0u : activeList[a];
+            int nInBucket = isOverflow ? 1 : hashCount[hi];
+
+            for (int bi0 = 0; bi0 < nInBucket; bi0++) {
+                int i = isOverflow ? overflowList[a - activeCount] : hashTable[hi][bi0];
+                if (particle[i].radius > largeRadius) continue;  // ver 3b
+                if (frozen && frozen[i]) continue;
+                int nx[3], ny[3], nz[3];
+                int cntX = neighbour_coords(cellCoord[i][0], nx);
+                int cntY = neighbour_coords(cellCoord[i][1], ny);
+                int cntZ = neighbour_coords(cellCoord[i][2], nz);
+
+                // Chequear vecinos en las 27 celdas alrededor
+                for (int dx = 0; dx < cntX; dx++) {
+                for (int dy = 0; dy < cntY; dy++) {
+                for (int dz = 0; dz < cntZ; dz++) {
+                    unsigned int h = spatial_hash(nx[dx], ny[dy], nz[dz]);
+                    int hits = physicsKernels->contact_filter(particle, i, hashTable[h], hashCount[h],
+                                                              CONTACT_PADDING, period, contactHits);
+                    // si la celda vecina también se barre, el par lo
+                    // resuelve el índice menor (evita duplicados y self)
+                    int bothActive = activeStamp[h] == active;
+                    for (int bi = 0; bi < hits; bi++) {
+                        int j = contactHits[bi];
+                        // a una congelada nadie la barre: el par es de i
+                        int jMoves = !frozen || !frozen[j];
+                        if (j == i || (bothActive && !isOverflow && j < i && jMoves)) continue;
+                        if (particle[j].radius > largeRadius && jMoves) continue;
+
+                        float pen = solve_contact(particle, i, j, restitution, contacts, frozen);
+                        if (pen > tolerance) {
+                            if (!isOverflow) mark_dirty(hi, active);
+                            mark_dirty(h, active);
+                        }
+                        if (pen > maxPenetration) maxPenetration = pen;
+                    }
+                } } }
+            }
         }
+
+        // 3b) Las grandes se barren siempre, con un vecindario más ancho
+        float largePenetration = solve_large(particle, restitution, tolerance, period,
+                                             contacts, frozen, active, 0);
+        if (largePenetration > maxPenetration) maxPenetration = largePenetration;
+        it++;
+        if (maxPenetration <= tolerance) break;
+
+        // la próxima pasada sólo revisa las celdas sucias
+        memcpy(activeList, dirtyList, dirtyCount * sizeof(unsigned int));
+        activeCount = dirtyCount;
     }
+
+    // 4) Lo corregido en este paso es el warm start del siguiente
+    rebuild_contact_cache(contacts);
+    return it;
+}
+
+int resolve_collisions_masked(Config *config, Particles* particle, int count,
+                              ContactCache* contacts, const unsigned char* frozen) {
+    if (count <= 0) return 0;
+
+    if (!reserve_buffers(count)) return 0;
+    grid_setup(config, particle, count);
+
+    // 0) Warm start con los contactos del paso anterior
+    contacts->logCount = 0;
+    if (config->WARM_START > 0.0f)
+        warm_start_contacts(contacts, particle, count, config->WARM_START, frozen);
+
+    // 1-2) Insertar cada partícula en su celda. Los buckets ocupados son la
+    //      primera lista de celdas a barrer; las partículas que no entraron
+    //      en su bucket se barren siempre.
+    //      Con partículas congeladas sólo se barren los buckets que tienen
+    //      alguna que se mueve: las congeladas son obstáculos.
+    //      La grilla se arma también con BROADPHASE_SWEEP: las consultas
+    //      espaciales la usan.
+    if (!grid_insert(particle, count)) return 0;
+    return resolve_inserted(config, particle, count, contacts, frozen, NULL);
 }
 
+// Paso en grafo de tareas. Por bloque de partículas: integrar, calcular
+// las celdas e insertar en los buckets. La inserción va en orden de
+// bloques (así la grilla queda igual que con grid_insert) pero el bloque k
+// se inserta mientras los siguientes todavía integran. Vaciar la grilla
+// anterior no depende de nadie. El warm start toca pares de cualquier
+// bloque: con WARM_START las celdas esperan a que integren todos.
+typedef struct {
+    Config* config;
+    const ForceFieldSet* forces;
+    Particles* particle;
+    int count;
+    int chunk;
+    float dt;
+    ContactCache* contacts;
+    int ok;
+} StepGraph;
+
+static inline int chunk_end(const StepGraph* g, int k) {
+    int hi = (k + 1) * g->chunk;
+    return hi < g->count ? hi : g->count;
+}
+
+static void task_grid_begin(void* arg, int index) {
+    StepGraph* g = arg;
+    (void)index;
+    // grid_setup sólo mira los radios: no choca con la integración
+    grid_setup(g->config, g->particle, g->count);
+    g->ok = grid_insert_begin(g->particle, g->count);
+}
+
+static void task_integrate(void* arg, int k) {
+    StepGraph* g = arg;
+    integrate_range(g->config, g->forces, g->particle, k * g->chunk, chunk_end(g, k), g->dt);
+}
+
+static void task_warm_start(void* arg, int index) {
+    StepGraph* g = arg;
+    (void)index;
+    warm_start_contacts(g->contacts, g->particle, g->count, g->config->WARM_START, NULL);
+}
+
+static void task_cells(void* arg, int k) {
+    StepGraph* g = arg;
+    if (g->ok) grid_insert_cells(g->particle, k * g->chunk, chunk_end(g, k));
+}
+
+static void task_insert(void* arg, int k) {
+    StepGraph* g = arg;
+    if (g->ok) grid_insert_range(g->particle, k * g->chunk, chunk_end(g, k));
+}
+
+int integrate_and_resolve(Config *config, const ForceFieldSet* forces, Particles* particle,
+                          int count, float dt, ContactCache* contacts, TaskPool* pool,
+                          int chunk) {
+    if (chunk <= 0) chunk = STEP_CHUNK;
+    int chunks = count > 0 ? (count + chunk - 1) / chunk : 0;
+    if (!pool || chunks < 2 || !reserve_buffers(count)) {
+        integrate_particles(config, forces, particle, count, dt);
+        return resolve_collisions_cached(config, particle, count, contacts);
+    }
+
+    StepGraph g = { config, forces, particle, count, chunk, dt, contacts, 0 };
+    contacts->logCount = 0;
+    int warm = config->WARM_START > 0.0f;
+
+    // ids crecientes en el orden de las dependencias (ver task_depend)
+    int begin = task_add(pool, task_grid_begin, &g, 0);
+    int ok = begin >= 0;
+    int firstIntegrate = begin + 1;
+    for (int k = 0; k < chunks && ok; k++)
+        ok = task_add(pool, task_integrate, &g, k) >= 0;
+    int warmTask = -1;
+    if (ok && warm) {
+        warmTask = task_add(pool, task_warm_start, &g, 0);
+        ok = warmTask >= 0;
+        for (int k = 0; k < chunks && ok; k++)
+            ok = task_depend(pool, warmTask, firstIntegrate + k);
+    }
+    for (int k = 0, lastInsert = -1; k < chunks && ok; k++) {
+        int cells = task_add(pool, task_cells, &g, k);
+        int insert = task_add(pool, task_insert, &g, k);
+        ok = cells >= 0 && insert >= 0 &&
+             task_depend(pool, cells, begin) &&
+             task_depend(pool, cells, warm ? warmTask : firstIntegrate + k) &&
+             task_depend(pool, insert, cells) &&
+             (lastInsert < 0 || task_depend(pool, insert, lastInsert));
+        lastInsert = insert;
+    }
+    if (!ok) {
+        // sin memoria para el grafo: el paso de siempre
+        task_pool_clear(pool);
+        integrate_particles(config, forces, particle, count, dt);
+        return resolve_collisions_cached(config, particle, count, contacts);
+    }
+
+    task_pool_run(pool);
+    if (!g.ok) return 0;
+    grid_insert_end(count);
+    return resolve_inserted(config, particle, count, contacts, NULL, pool);
+}
@@ -0,0 +1,443 @@
+#include "physics/planar.h"
+#include "physics/env.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLANAR_PADDING 1e-3f    // igual que CONTACT_PADDING del solver 3D
+#define PLANAR_MAX_CELLS 1024   // celdas por eje como máximo
+
+typedef struct {
+    float* x;
+    float* y;
+    float* px;
+    float* py;
+    float* radius;
+} PlanarArrays;
+
+struct PlanarSim {
+    PlanarArrays a;       // estado, ordenado por celda desde el último paso
+    PlanarArrays sorted;  // destino del reordenamiento
+    int count;
+    int capacity;
+
+    int* cell;            // celda de cada partícula
+    int* sortedCell;
+    int* cellStart;       // primera partícula de cada celda (cells + 1)
+    int cellCapacity;
+    int cellsX, cellsY;
+    float cellSize;
+    float minX, minY;
+    int periodic;
+    float period;
+};
+
+enum { SHAPE_BOX, SHAPE_CIRCLE, SHAPE_TORUS };
+
+static int arrays_alloc(PlanarArrays* arr, int capacity) {
+    arr->x = malloc((size_t)capacity * sizeof(float));
+    arr->y = malloc((size_t)capacity * sizeof(float));
+    arr->px = malloc((size_t)capacity * sizeof(float));
+    arr->py = malloc((size_t)capacity * sizeof(float));
+    arr->radius = malloc((size_t)capacity * sizeof(float));
+    return arr->x && arr->y && arr->px && arr->py && arr->radius;
+}
+
+static void arrays_free(PlanarArrays* arr) {
+    free(arr->x);
+    free(arr->y);
+    free(arr->px);
+    free(arr->py);
+    free(arr->radius);
+}
+
+PlanarSim* planar_create(int capacity) {
+    PlanarSim* sim = calloc(1, sizeof(PlanarSim));
+    if (!sim) return NULL;
+    sim->cell = malloc((size_t)capacity * sizeof(int));
+    sim->sortedCell = malloc((size_t)capacity * sizeof(int));
+    if (!arrays_alloc(&sim->a, capacity) || !arrays_alloc(&sim->sorted, capacity) ||
+        !sim->cell || !sim->sortedCell) {
+        fprintf(stderr, "Failed to alloc planar simulation\n");
+        planar_destroy(sim);
+        return NULL;
+    }
+    sim->capacity = capacity;
+    return sim;
+}
+
+void planar_destroy(PlanarSim* sim) {
+    if (!sim) return;
+    arrays_free(&sim->a);
+    arrays_free(&sim->sorted);
+    free(sim->cell);
+    free(sim->sortedCell);
+    free(sim->cellStart);
+    free(sim);
+}
+
+int planar_spawn(PlanarSim* sim, const Config* cfg, int n) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env) return 0;
+    int added = 0;
+    while (added < n && sim->count < sim->capacity) {
+        vec3 pos;
+        env->spawn(cfg, pos);
+        int i = sim->count++;
+        sim->a.x[i] = sim->a.px[i] = pos[0];
+        sim->a.y[i] = sim->a.py[i] = pos[1];
+        sim->a.radius[i] = cfg->PARTICLE_RADIUS;
+        added++;
+    }
+    return added;
+}
+
+void planar_set_count(PlanarSim* sim, int count) {
+    if (count < 0) count = 0;
+    if (count > sim->capacity) count = sim->capacity;
+    sim->count = count;
+}
+
+int planar_count(const PlanarSim* sim) {
+    return sim->count;
+}
+
+// ------------------------------------------------------------- entorno
+
+static int env_shape(const Config* cfg, const EnvInterface* env) {
+    if (env->periodic) return SHAPE_TORUS;
+    if (cfg->ENV_TYPE == ENV_SPHERE) return SHAPE_CIRCLE;
+    return SHAPE_BOX;
+}
+
+// Mismo rebote que collide_box / collide_sphere / collide_periodic, en el
+// plano. Los entornos registrados se tratan como su caja.
+static void collide_env(PlanarSim* sim, const Config* cfg, const EnvInterface* env) {
+    PlanarArrays* a = &sim->a;
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    const int n = sim->count;
+
+    switch (env_shape(cfg, env)) {
+    case SHAPE_TORUS: {
+        const float period = max[0] - min[0];
+        for (int i = 0; i < n; i++) {
+            float sx = a->x[i] < min[0] ? period : (a->x[i] >= max[0] ? -period : 0.0f);
+            float sy = a->y[i] < min[1] ? period : (a->y[i] >= max[1] ? -period : 0.0f);
+            a->x[i] += sx; a->px[i] += sx;
+            a->y[i] += sy; a->py[i] += sy;
+        }
+        break;
+    }
+    case SHAPE_CIRCLE: {
+        const float envRadius = max[0];
+        for (int i = 0; i < n; i++) {
+            float maxDist = envRadius - a->radius[i];
+            float d2 = a->x[i] * a->x[i] + a->y[i] * a->y[i];
+            if (d2 <= maxDist * maxDist) continue;
+            float d = sqrtf(d2);
+            float nx = a->x[i] / d, ny = a->y[i] / d;
+            float vx = a->x[i] - a->px[i], vy = a->y[i] - a->py[i];
+            a->x[i] = nx * maxDist;
+            a->y[i] = ny * maxDist;
+            // reflejar la velocidad con pérdida de energía
+            float vn = vx * nx + vy * ny;
+            vx = 0.9f * (vx - 2.0f * vn * nx);
+            vy = 0.9f * (vy - 2.0f * vn * ny);
+            a->px[i] = a->x[i] - vx;
+            a->py[i] = a->y[i] - vy;
+        }
+        break;
+    }
+    default:
+        for (int i = 0; i < n; i++) {
+            float r = a->radius[i];
+            float cx = fminf(fmaxf(a->x[i], min[0] + r), max[0] - r);
+            float cy = fminf(fmaxf(a->y[i], min[1] + r), max[1] - r);
+            // rebote simple: si se recortó, la velocidad se invierte
+            if (cx != a->x[i]) {
+                a->px[i] = cx + (a->x[i] - a->px[i]);
+                a->x[i] = cx;
+            }
+            if (cy != a->y[i]) {
+                a->py[i] = cy + (a->y[i] - a->py[i]);
+                a->y[i] = cy;
+            }
+        }
+        break;
+    }
+}
+
+static void integrate(PlanarSim* sim, const ForceFieldSet* forces, float dt) {
+    PlanarArrays* a = &sim->a;
+    const int n = sim->count;
+    const float half = 0.5f * dt * dt;
+    vec3 acc;
+    if (force_fields_uniform(forces, acc)) {
+        const float ax = acc[0] * half, ay = acc[1] * half;
+        for (int i = 0; i < n; i++) {
+            float x = 2.0f * a->x[i] - a->px[i] + ax;
+            float y = 2.0f * a->y[i] - a->py[i] + ay;
+            a->px[i] = a->x[i];
+            a->py[i] = a->y[i];
+            a->x[i] = x;
+            a->y[i] = y;
+        }
+        return;
+    }
+    // particleAcceleration es por partícula 3D: acá no se usa
+    const float invDt = dt > 0.0f ? 1.0f / dt : 0.0f;
+    for (int i = 0; i < n; i++) {
+        vec3 pos = { a->x[i], a->y[i], 0.0f };
+        vec3 vel = { (a->x[i] - a->px[i]) * invDt, (a->y[i] - a->py[i]) * invDt, 0.0f };
+        force_fields_eval(forces, pos, vel, acc);
+        float x = 2.0f * a->x[i] - a->px[i] + acc[0] * half;
+        float y = 2.0f * a->y[i] - a->py[i] + acc[1] * half;
+        a->px[i] = a->x[i];
+        a->py[i] = a->y[i];
+        a->x[i] = x;
+        a->y[i] = y;
+    }
+}
+
+// --------------------------------------------------------------- grilla
+
+// Celdas de lado 2 * radio máximo sobre la caja del entorno (en el toro,
+// un número entero de celdas por período)
+static int grid_setup(PlanarSim* sim, const Config* cfg, const EnvInterface* env) {
+    float maxRadius = 0.0f;
+    for (int i = 0; i < sim->count; i++)
+        if (sim->a.radius[i] > maxRadius) maxRadius = sim->a.radius[i];
+    float cellSize = 2.0f * maxRadius;
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+
+    sim->periodic = env->periodic;
+    if (sim->periodic) {
+        sim->period = max[0] - min[0];
+        int cells = (int)floorf(sim->period / cellSize);
+        if (cells > PLANAR_MAX_CELLS) cells = PLANAR_MAX_CELLS;
+        // con menos de 3 celdas las vecinas se repetirían: una sola celda
+        if (cells < 3) cells = 1;
+        sim->cellsX = sim->cellsY = cells;
+        sim->cellSize = sim->period / cells;
+        sim->minX = min[0];
+        sim->minY = min[1];
+    } else {
+        // una celda de margen: el solver puede sacar partículas del borde
+        sim->minX = min[0] - cellSize;
+        sim->minY = min[1] - cellSize;
+        float extent = fmaxf(max[0] - min[0], max[1] - min[1]) + 2.0f * cellSize;
+        if (extent / cellSize > PLANAR_MAX_CELLS) cellSize = extent / PLANAR_MAX_CELLS;
+        sim->cellsX = (int)ceilf((max[0] - sim->minX + cellSize) / cellSize);
+        sim->cellsY = (int)ceilf((max[1] - sim->minY + cellSize) / cellSize);
+        sim->cellSize = cellSize;
+    }
+
+    int cells = sim->cellsX * sim->cellsY;
+    if (cells + 1 > sim->cellCapacity) {
+        int* grown = realloc(sim->cellStart, (size_t)(cells + 1) * sizeof(int));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc planar grid\n");
+            return 0;
+        }
+        sim->cellStart = grown;
+        sim->cellCapacity = cells + 1;
+    }
+    return 1;
+}
+
+static inline int cell_axis(const PlanarSim* sim, float v, float origin, int cells) {
+    int c = (int)floorf((v - origin) / sim->cellSize);
+    if (sim->periodic) {
+        c %= cells;
+        return c < 0 ? c + cells : c;
+    }
+    return c < 0 ? 0 : (c >= cells ? cells - 1 : c);
+}
+
+// Ordena las partículas por celda (counting sort) intercambiando los
+// arreglos con los de sorted, y las celdas con sortedCell
+static void grid_sort(PlanarSim* sim) {
+    const int n = sim->count;
+    const int cells = sim->cellsX * sim->cellsY;
+    PlanarArrays* a = &sim->a;
+    int* start = sim->cellStart;
+    memset(start, 0, (size_t)(cells + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int c = cell_axis(sim, a->x[i], sim->minX, sim->cellsX) +
+                cell_axis(sim, a->y[i], sim->minY, sim->cellsY) * sim->cellsX;
+        sim->cell[i] = c;
+        start[c + 1]++;
+    }
+    for (int c = 0; c < cells; c++) start[c + 1] += start[c];
+
+    PlanarArrays* s = &sim->sorted;
+    for (int i = 0; i < n; i++) {
+        int k = start[sim->cell[i]]++;
+        sim->sortedCell[k] = sim->cell[i];
+        s->x[k] = a->x[i];
+        s->y[k] = a->y[i];
+        s->px[k] = a->px[i];
+        s->py[k] = a->py[i];
+        s->radius[k] = a->radius[i];
+    }
+    // el scatter corrió cada inicio al de la celda siguiente
+    memmove(start + 1, start, (size_t)cells * sizeof(int));
+    start[0] = 0;
+
+    PlanarArrays swap = sim->a;
+    sim->a = sim->sorted;
+    sim->sorted = swap;
+    int* cellSwap = sim->cell;
+    sim->cell = sim->sortedCell;
+    sim->sortedCell = cellSwap;
+}
+
+// -------------------------------------------------------------- solver
+
+// Resuelve el par i-j como solve_contact de physics.c, con la masa
+// proporcional al área. Devuelve la penetración (0 si no se tocan).
+static inline float solve_pair(PlanarArrays* a, int i, int j, float restitution, float period) {
+    float dx = a->x[j] - a->x[i];
+    float dy = a->y[j] - a->y[i];
+    if (period > 0.0f) {
+        dx -= period * floorf(dx / period + 0.5f);
+        dy -= period * floorf(dy / period + 0.5f);
+    }
+    float minDist = a->radius[i] + a->radius[j];
+    float reach = minDist + PLANAR_PADDING;
+    float d2 = dx * dx + dy * dy;
+    if (d2 <= 0.0f || d2 >= reach * reach) return 0.0f;
+
+    float dist = sqrtf(d2);
+    float nx = dx / dist, ny = dy / dist;
+    float overlap = reach - dist;
+    float mi = a->radius[i] * a->radius[i];
+    float mj = a->radius[j] * a->radius[j];
+    float share = mj / (mi + mj);
+    a->x[i] -= nx * overlap * share;
+    a->y[i] -= ny * overlap * share;
+    a->x[j] += nx * overlap * (1.0f - share);
+    a->y[j] += ny * overlap * (1.0f - share);
+
+    float rx = a->px[j] - a->px[i];
+    float ry = a->py[j] - a->py[i];
+    if (period > 0.0f) {
+        rx -= period * floorf(rx / period + 0.5f);
+        ry -= period * floorf(ry / period + 0.5f);
+    }
+    float vRel = rx * nx + ry * ny;
+    if (vRel <= 0.0f) {
+        float impulse = -(1.0f + restitution) * vRel;
+        a->px[i] -= nx * impulse * share;
+        a->py[i] -= ny * impulse * share;
+        a->px[j] += nx * impulse * (1.0f - share);
+        a->py[j] += ny * impulse * (1.0f - share);
+    }
+    return minDist - dist > 0.0f ? minDist - dist : 0.0f;
+}
+
+// Ejecuta body para cada par (i, j) del vecindario de 9 celdas una sola
+// vez: cada partícula contra el resto de su celda y las cuatro vecinas
+// "hacia adelante". Necesita la grilla ordenada (grid_sort).
+static const int forward[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+
+#define FOR_EACH_STENCIL_PAIR(sim, i, j, body)                               \
+    do {                                                                     \
+        const int* start_ = (sim)->cellStart;                                \
+        const int cellsX_ = (sim)->cellsX, cellsY_ = (sim)->cellsY;          \
+        const int stencil_ = cellsX_ * cellsY_ > 1 ? 4 : 0;                  \
+        for (int i = 0; i < (sim)->count; i++) {                             \
+            int c_ = (sim)->cell[i];                                         \
+            int cx_ = c_ % cellsX_, cy_ = c_ / cellsX_;                      \
+            for (int j = i + 1; j < start_[c_ + 1]; j++) body                \
+            for (int k_ = 0; k_ < stencil_; k_++) {                          \
+                int nx_ = cx_ + forward[k_][0], ny_ = cy_ + forward[k_][1];  \
+                if ((sim)->periodic) {                                       \
+                    nx_ = (nx_ + cellsX_) % cellsX_;                         \
+                    ny_ = ny_ % cellsY_;                                     \
+                } else if (nx_ < 0 || nx_ >= cellsX_ || ny_ >= cellsY_) {    \
+                    continue;                                                \
+                }                                                            \
+                int n_ = nx_ + ny_ * cellsX_;                                \
+                for (int j = start_[n_]; j < start_[n_ + 1]; j++) body       \
+            }                                                                \
+        }                                                                    \
+    } while (0)
+
+// Una pasada del solver sobre todos los pares del vecindario
+static float sweep(PlanarSim* sim, float restitution) {
+    PlanarArrays* a = &sim->a;
+    const float period = sim->periodic ? sim->period : 0.0f;
+    float maxPenetration = 0.0f;
+    FOR_EACH_STENCIL_PAIR(sim, i, j, {
+        float pen = solve_pair(a, i, j, restitution, period);
+        if (pen > maxPenetration) maxPenetration = pen;
+    });
+    return maxPenetration;
+}
+
+int planar_step(PlanarSim* sim, const Config* cfg, const ForceFieldSet* forces, float dt) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env || sim->count <= 0) return 0;
+    integrate(sim, forces, dt);
+    collide_env(sim, cfg, env);
+    if (!grid_setup(sim, cfg, env)) return 0;
+    grid_sort(sim);
+
+    int maxIterations = cfg->SOLVER_ITERATIONS > 0 ? (int)cfg->SOLVER_ITERATIONS : 1;
+    int it = 0;
+    while (it < maxIterations) {
+        float pen = sweep(sim, cfg->RESTITUTION);
+        it++;
+        if (pen <= cfg->SOLVER_TOLERANCE) break;
+    }
+    // el solver empuja las de abajo de una pila contra las paredes (y en
+    // el toro, fuera del período): el paso termina adentro
+    collide_env(sim, cfg, env);
+    return it;
+}
+
+int planar_pairs(PlanarSim* sim, const Config* cfg, float margin, int (*out)[2], int maxOut) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env || sim->count <= 0) return 0;
+    if (!grid_setup(sim, cfg, env)) return -1;
+    grid_sort(sim);
+    const PlanarArrays* a = &sim->a;
+    const float period = sim->periodic ? sim->period : 0.0f;
+    int found = 0;
+    FOR_EACH_STENCIL_PAIR(sim, i, j, {
+        float dx = a->x[j] - a->x[i];
+        float dy = a->y[j] - a->y[i];
+        if (period > 0.0f) {
+            dx -= period * floorf(dx / period + 0.5f);
+            dy -= period * floorf(dy / period + 0.5f);
+        }
+        float reach = a->radius[i] + a->radius[j] + margin;
+        if (dx * dx + dy * dy < reach * reach) {
+            if (found < maxOut) {
+                out[found][0] = i;
+                out[found][1] = j;
+            }
+            found++;
+        }
+    });
+    return found;
+}
+
+void planar_positions(const PlanarSim* sim, vec2* out) {
+    for (int i = 0; i < sim->count; i++) {
+        out[i][0] = sim->a.x[i];
+        out[i][1] = sim->a.y[i];
+    }
+}
+
+int planar_pick(const PlanarSim* sim, float x, float y) {
+    for (int i = 0; i < sim->count; i++) {
+        float dx = sim->a.x[i] - x, dy = sim->a.y[i] - y;
+        if (dx * dx + dy * dy <= sim->a.radius[i] * sim->a.radius[i]) return i;
+    }
+    return -1;
+}
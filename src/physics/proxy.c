@@ -0,0 +1,268 @@
+#include "physics/proxy.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Pasos después de unirse en los que el proxy no se parte por moverse: el
+// solver todavía lo está acomodando entre sus vecinos
+#define PROXY_GRACE 8
+#define QUIET_MAX 0xffff
+
+int proxy_init(ProxySet* set, int capacity) {
+    memset(set, 0, sizeof(*set));
+    set->quiet = malloc((size_t)capacity * sizeof(unsigned short));
+    set->proxy = malloc((size_t)capacity * sizeof(int));
+    set->anchor = malloc((size_t)capacity * sizeof(vec3));
+    set->candidates = malloc((size_t)capacity * sizeof(ProxyCandidate));
+    if (!set->quiet || !set->proxy || !set->anchor || !set->candidates) {
+        fprintf(stderr, "Failed to alloc proxy state\n");
+        proxy_free(set);
+        return 0;
+    }
+    set->capacity = capacity;
+    return 1;
+}
+
+void proxy_free(ProxySet* set) {
+    free(set->quiet);
+    free(set->proxy);
+    free(set->anchor);
+    free(set->candidates);
+    free(set->records);
+    free(set->freeRecords);
+    memset(set, 0, sizeof(*set));
+}
+
+void proxy_forget(ProxySet* set) {
+    set->tracked = 0;
+    set->recordCount = 0;
+    set->freeCount = 0;
+    set->active = 0;
+}
+
+void proxy_set_focus(ProxySet* set, const vec3 focus) {
+    glm_vec3_copy((float*)focus, set->focus);
+    set->hasFocus = 1;
+}
+
+static int new_record(ProxySet* set) {
+    if (set->freeCount > 0) return set->freeRecords[--set->freeCount];
+    if (set->recordCount == set->recordCapacity) {
+        int capacity = set->recordCapacity > 0 ? set->recordCapacity * 2 : 1024;
+        ProxyChildren* records = realloc(set->records, capacity * sizeof(ProxyChildren));
+        if (records) set->records = records;
+        int* freeRecords = realloc(set->freeRecords, capacity * sizeof(int));
+        if (freeRecords) set->freeRecords = freeRecords;
+        if (!records || !freeRecords) return -1;
+        set->recordCapacity = capacity;
+    }
+    return set->recordCount++;
+}
+
+static void release_record(ProxySet* set, int r) {
+    set->records[r].count = 0;
+    set->freeRecords[set->freeCount++] = r;
+    set->active--;
+}
+
+static float focus_dist2(const ProxySet* set, const vec3 pos) {
+    if (!set->hasFocus) return INFINITY;
+    return glm_vec3_distance2((float*)pos, (float*)set->focus);
+}
+
+// Reemplaza el proxy i por sus hijas: la primera ocupa su lugar y el resto
+// va al final. Todas heredan la velocidad del proxy.
+static int split_proxy(ProxySet* set, Particles* p, int i, int* count, int capacity) {
+    int r = set->proxy[i];
+    ProxyChildren* rec = &set->records[r];
+    if (*count + rec->count - 1 > capacity) return 0;
+
+    vec3 center, vel;
+    glm_vec3_copy(p[i].current, center);
+    glm_vec3_sub(p[i].current, p[i].previus, vel);
+    for (int c = 0; c < rec->count; c++) {
+        int k = c == 0 ? i : (*count)++;
+        glm_vec3_add(center, rec->offset[c], p[k].current);
+        glm_vec3_sub(p[k].current, vel, p[k].previus);
+        p[k].radius = rec->radius[c];
+        glm_vec3_copy(p[k].current, set->anchor[k]);
+        set->quiet[k] = 0;
+        set->proxy[k] = -1;
+    }
+    release_record(set, r);
+    return 1;
+}
+
+int proxy_expand(const ProxySet* set, const Particles* p, int count, Particles* out, int capacity) {
+    if (count > capacity) count = capacity;
+    memcpy(out, p, (size_t)count * sizeof(Particles));
+    int n = count;
+    for (int i = 0; i < count && i < set->tracked; i++) {
+        if (set->proxy[i] < 0) continue;
+        const ProxyChildren* rec = &set->records[set->proxy[i]];
+        if (n + rec->count - 1 > capacity) continue;
+        vec3 vel;
+        glm_vec3_sub((float*)p[i].current, (float*)p[i].previus, vel);
+        for (int c = 0; c < rec->count; c++) {
+            int k = c == 0 ? i : n++;
+            glm_vec3_add((float*)p[i].current, (float*)rec->offset[c], out[k].current);
+            glm_vec3_sub(out[k].current, vel, out[k].previus);
+            out[k].radius = rec->radius[c];
+        }
+    }
+    return n;
+}
+
+static int compare_candidates(const void* a, const void* b) {
+    const ProxyCandidate* ca = a;
+    const ProxyCandidate* cb = b;
+    if (ca->key != cb->key) return (ca->key > cb->key) - (ca->key < cb->key);
+    return ca->index - cb->index;
+}
+
+static inline uint64_t coarse_key(const vec3 pos, float cellSize) {
+    uint64_t key = 0;
+    for (int a = 0; a < 3; a++) {
+        int c = (int)floorf(pos[a] / cellSize);
+        key = (key << 21) | ((uint64_t)(c + (1 << 20)) & 0x1fffff);
+    }
+    return key;
+}
+
+// Une members[0..n) en el primero. Los demás quedan marcados con proxy = -2
+// para la compactación.
+static void merge_group(ProxySet* set, Particles* p, const ProxyCandidate* members, int n) {
+    int r = new_record(set);
+    if (r < 0) return;
+    ProxyChildren* rec = &set->records[r];
+
+    // masa proporcional al volumen (r³)
+    vec3 current = {0}, previus = {0};
+    float mass = 0.0f;
+    for (int m = 0; m < n; m++) {
+        const Particles* q = &p[members[m].index];
+        float w = q->radius * q->radius * q->radius;
+        glm_vec3_muladds((float*)q->current, w, current);
+        glm_vec3_muladds((float*)q->previus, w, previus);
+        mass += w;
+    }
+    glm_vec3_scale(current, 1.0f / mass, current);
+    glm_vec3_scale(previus, 1.0f / mass, previus);
+
+    for (int m = 0; m < n; m++) {
+        int k = members[m].index;
+        glm_vec3_sub(p[k].current, current, rec->offset[m]);
+        rec->radius[m] = p[k].radius;
+        if (m > 0) set->proxy[k] = -2;
+    }
+    rec->count = n;
+    set->active++;
+
+    int head = members[0].index;
+    glm_vec3_copy(current, p[head].current);
+    glm_vec3_copy(previus, p[head].previus);
+    p[head].radius = cbrtf(mass);
+    set->proxy[head] = r;
+    set->quiet[head] = 0;
+}
+
+int proxy_update(ProxySet* set, const Config* cfg, Particles* p, int* count, int capacity) {
+    if (capacity > set->capacity) capacity = set->capacity;
+    if (cfg->PROXY_FRAMES == 0) {
+        // apagado: volver a resolución completa
+        int changed = 0;
+        for (int i = 0; i < *count && i < set->tracked; i++)
+            if (set->proxy[i] >= 0) changed |= split_proxy(set, p, i, count, capacity);
+        proxy_forget(set);
+        return changed;
+    }
+
+    // Estado de las partículas nuevas y de las que desaparecieron
+    for (int i = *count; i < set->tracked; i++)
+        if (set->proxy[i] >= 0) release_record(set, set->proxy[i]);
+    for (int i = set->tracked; i < *count; i++) {
+        glm_vec3_copy(p[i].current, set->anchor[i]);
+        set->quiet[i] = 0;
+        set->proxy[i] = -1;
+    }
+    set->tracked = *count;
+
+    const float unit = cfg->PARTICLE_RADIUS;
+    const float drift = cfg->PROXY_DRIFT * unit;
+    const float splitDist2 = cfg->PROXY_DISTANCE * cfg->PROXY_DISTANCE;
+    const float mergeDist2 = 1.5625f * splitDist2;  // (1.25 d)²: histéresis
+    int changed = 0;
+
+    // 1) Quietud: una partícula en una pila apoyada nunca está detenida del
+    //    todo, así que cuenta como quieta mientras no se aleje más de drift
+    //    del lugar donde se asentó. Un proxy puede deslizarse despacio con
+    //    la pila; se parte si recibe un golpe (un paso de más de drift) o
+    //    si el foco se acerca.
+    int n = *count;
+    for (int i = 0; i < n; i++) {
+        vec3 d;
+        if (set->proxy[i] < 0) {
+            glm_vec3_sub(p[i].current, set->anchor[i], d);
+            if (glm_vec3_norm2(d) > drift * drift) {
+                glm_vec3_copy(p[i].current, set->anchor[i]);
+                set->quiet[i] = 0;
+            } else if (set->quiet[i] < QUIET_MAX) {
+                set->quiet[i]++;
+            }
+            continue;
+        }
+
+        // en un proxy quiet cuenta la edad
+        if (set->quiet[i] < QUIET_MAX) set->quiet[i]++;
+        glm_vec3_sub(p[i].current, p[i].previus, d);
+        int hit = set->quiet[i] > PROXY_GRACE && glm_vec3_norm2(d) > drift * drift;
+        if (hit || focus_dist2(set, p[i].current) < splitDist2)
+            changed |= split_proxy(set, p, i, count, capacity);
+    }
+    set->tracked = *count;
+
+    // 2) Candidatos: quietas, de resolución completa y lejos del foco,
+    //    agrupadas por celdas gruesas de 4 radios
+    int candidateCount = 0;
+    const float coarse = 4.0f * unit;
+    for (int i = 0; i < *count; i++) {
+        if (set->proxy[i] != -1 || set->quiet[i] < cfg->PROXY_FRAMES) continue;
+        if (focus_dist2(set, p[i].current) < mergeDist2) continue;
+        set->candidates[candidateCount].key = coarse_key(p[i].current, coarse);
+        set->candidates[candidateCount].index = i;
+        candidateCount++;
+    }
+    if (candidateCount >= PROXY_MIN_CHILDREN) {
+        qsort(set->candidates, candidateCount, sizeof(ProxyCandidate), compare_candidates);
+        for (int a = 0; a < candidateCount; ) {
+            int b = a;
+            while (b < candidateCount && set->candidates[b].key == set->candidates[a].key) b++;
+            int group = b - a;
+            if (group > PROXY_MAX_CHILDREN) group = PROXY_MAX_CHILDREN;
+            if (group >= PROXY_MIN_CHILDREN) {
+                merge_group(set, p, &set->candidates[a], group);
+                changed = 1;
+            }
+            a = b;
+        }
+    }
+
+    // 3) Compactar: las hijas absorbidas dejan huecos
+    if (changed) {
+        int w = 0;
+        for (int i = 0; i < *count; i++) {
+            if (set->proxy[i] == -2) continue;
+            if (w != i) {
+                p[w] = p[i];
+                set->quiet[w] = set->quiet[i];
+                glm_vec3_copy(set->anchor[i], set->anchor[w]);
+                set->proxy[w] = set->proxy[i];
+            }
+            w++;
+        }
+        *count = w;
+        set->tracked = w;
+    }
+    return changed;
+}
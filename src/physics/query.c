@@ -0,0 +1,374 @@
+#include "physics/physics.h"
+#include "physics/grid.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Consultas espaciales sobre la grilla que dejó el último resolve_collisions.
+// Las partículas se movieron un poco desde que se insertaron (correcciones
+// del solver), así que todas las búsquedas miran una celda de margen y
+// comparan contra la posición actual.
+
+// Celda (sin dar la vuelta) de una coordenada sobre un eje
+static inline int axis_cell(float v) {
+    float base = grid.periodic ? grid.origin : 0.0f;
+    return (int)floorf((v - base) / grid.cellSize);
+}
+
+// Rango de celdas [lo, hi] sobre un eje que cubre [a, b] más el margen.
+// Devuelve la cantidad de celdas (en periódico, como mucho cells).
+static int cell_range(float a, float b, int axis, int* lo, int* hi) {
+    *lo = axis_cell(a) - 1;
+    *hi = axis_cell(b) + 1;
+    if (grid.periodic) {
+        if (*hi - *lo + 1 > grid.cells) *hi = *lo + grid.cells - 1;
+    } else {
+        // no hace falta mirar fuera de las celdas ocupadas
+        if (*lo < grid.cellMin[axis]) *lo = grid.cellMin[axis];
+        if (*hi > grid.cellMax[axis]) *hi = grid.cellMax[axis];
+    }
+    return *hi >= *lo ? *hi - *lo + 1 : 0;
+}
+
+// Verdadero si el rayo ya salió de las celdas ocupadas y se aleja
+static inline int ray_left_grid(const int cell[3], const int step[3]) {
+    if (grid.periodic) return 0;
+    for (int a = 0; a < 3; a++) {
+        if (cell[a] > grid.cellMax[a] + 1 && step[a] >= 0) return 1;
+        if (cell[a] < grid.cellMin[a] - 1 && step[a] <= 0) return 1;
+    }
+    return 0;
+}
+
+// Ejecuta body para cada partícula i insertada en la celda (x, y, z).
+// Se compara la celda guardada de la partícula para no repetir resultados
+// cuando dos celdas comparten bucket.
+#define FOR_EACH_IN_CELL(x, y, z, i, body)                                   \
+    do {                                                                     \
+        int cx_ = grid.periodic ? wrap_cell(x) : (x);                        \
+        int cy_ = grid.periodic ? wrap_cell(y) : (y);                        \
+        int cz_ = grid.periodic ? wrap_cell(z) : (z);                        \
+        unsigned int h_ = spatial_hash(cx_, cy_, cz_);                       \
+        for (int b_ = 0; b_ < hashCount[h_]; b_++) {                         \
+            int i = hashTable[h_][b_];                                       \
+            if (cellCoord[i][0] != cx_ || cellCoord[i][1] != cy_ ||          \
+                cellCoord[i][2] != cz_) continue;                            \
+            body                                                             \
+        }                                                                    \
+    } while (0)
+
+static inline float distance2_to(const vec3 point, int i) {
+    vec3 d;
+    glm_vec3_sub((float*)grid.particles[i].current, (float*)point, d);
+    minimum_image(d);
+    return glm_vec3_norm2(d);
+}
+
+// Las que no entraron en su bucket se revisan siempre
+#define FOR_EACH_OVERFLOW(i, body)                                           \
+    for (int o_ = 0; o_ < overflowCount; o_++) {                             \
+        int i = overflowList[o_];                                            \
+        body                                                                 \
+    }
+
+// Las grandes (proxies, radios mayores que el de la celda) sólo están en
+// el bucket de su centro pero asoman a celdas más lejanas: el rayo las
+// prueba a todas
+#define FOR_EACH_LARGE(i, body)                                              \
+    for (int l_ = 0; l_ < largeCount; l_++) {                                \
+        int i = largeList[l_];                                               \
+        body                                                                 \
+    }
+
+int physics_query_radius(const vec3 center, float radius, int* out, int maxOut) {
+    if (grid.count <= 0) return 0;
+    int lo[3], hi[3];
+    for (int a = 0; a < 3; a++)
+        if (!cell_range(center[a] - radius, center[a] + radius, a, &lo[a], &hi[a]))
+            return 0;
+
+    float r2 = radius * radius;
+    int found = 0;
+    for (int x = lo[0]; x <= hi[0]; x++)
+    for (int y = lo[1]; y <= hi[1]; y++)
+    for (int z = lo[2]; z <= hi[2]; z++) {
+        FOR_EACH_IN_CELL(x, y, z, i, {
+            if (distance2_to(center, i) <= r2) {
+                if (found < maxOut) out[found] = i;
+                found++;
+            }
+        });
+    }
+    FOR_EACH_OVERFLOW(i, {
+        if (distance2_to(center, i) <= r2) {
+            if (found < maxOut) out[found] = i;
+            found++;
+        }
+    })
+    return found;
+}
+
+int physics_query_aabb(const vec3 min, const vec3 max, int* out, int maxOut) {
+    if (grid.count <= 0) return 0;
+    int lo[3], hi[3];
+    for (int a = 0; a < 3; a++)
+        if (!cell_range(min[a], max[a], a, &lo[a], &hi[a]))
+            return 0;
+
+    int found = 0;
+    for (int x = lo[0]; x <= hi[0]; x++)
+    for (int y = lo[1]; y <= hi[1]; y++)
+    for (int z = lo[2]; z <= hi[2]; z++) {
+        FOR_EACH_IN_CELL(x, y, z, i, {
+            const float* c = grid.particles[i].current;
+            if (c[0] >= min[0] && c[0] <= max[0] &&
+                c[1] >= min[1] && c[1] <= max[1] &&
+                c[2] >= min[2] && c[2] <= max[2]) {
+                if (found < maxOut) out[found] = i;
+                found++;
+            }
+        });
+    }
+    FOR_EACH_OVERFLOW(i, {
+        const float* c = grid.particles[i].current;
+        if (c[0] >= min[0] && c[0] <= max[0] &&
+            c[1] >= min[1] && c[1] <= max[1] &&
+            c[2] >= min[2] && c[2] <= max[2]) {
+            if (found < maxOut) out[found] = i;
+            found++;
+        }
+    })
+    return found;
+}
+
+// Inserta i en la lista de los k mejores (ordenada por distancia)
+static inline void knn_insert(int i, float d2, int k, int* out, float* dist2, int* n) {
+    if (*n == k && d2 >= dist2[k-1]) return;
+    int pos = *n < k ? (*n)++ : k - 1;
+    while (pos > 0 && dist2[pos-1] > d2) {
+        out[pos] = out[pos-1];
+        dist2[pos] = dist2[pos-1];
+        pos--;
+    }
+    out[pos] = i;
+    dist2[pos] = d2;
+}
+
+int physics_query_knn(const vec3 center, int k, int* out, float* dist2) {
+    if (grid.count <= 0 || k <= 0) return 0;
+    int n = 0;
+    FOR_EACH_OVERFLOW(i, { knn_insert(i, distance2_to(center, i), k, out, dist2, &n); })
+
+    int c[3] = { axis_cell(center[0]), axis_cell(center[1]), axis_cell(center[2]) };
+
+    // Hasta dónde hay que crecer para haber visto todas las celdas
+    int maxRing = 0;
+    for (int a = 0; a < 3; a++) {
+        int reach = grid.periodic ? grid.cells / 2
+                  : (c[a] - grid.cellMin[a] > grid.cellMax[a] - c[a]
+                         ? c[a] - grid.cellMin[a] : grid.cellMax[a] - c[a]);
+        if (reach > maxRing) maxRing = reach;
+    }
+
+    // Anillos de celdas a distancia de Chebyshev r del centro. Todo lo que
+    // queda afuera del cubo de radio r está a más de (r - 1) celdas (una
+    // celda de margen por el movimiento desde la inserción).
+    for (int r = 0; r <= maxRing; r++) {
+        for (int x = c[0] - r; x <= c[0] + r; x++)
+        for (int y = c[1] - r; y <= c[1] + r; y++)
+        for (int z = c[2] - r; z <= c[2] + r; z++) {
+            if (abs(x - c[0]) != r && abs(y - c[1]) != r && abs(z - c[2]) != r) continue;
+            // con cantidad par de celdas, -cells/2 y +cells/2 son la misma
+            if (grid.periodic && grid.cells % 2 == 0 &&
+                (x - c[0] == -grid.cells / 2 || y - c[1] == -grid.cells / 2 ||
+                 z - c[2] == -grid.cells / 2)) continue;
+            if (!grid.periodic &&
+                (x < grid.cellMin[0] || x > grid.cellMax[0] ||
+                 y < grid.cellMin[1] || y > grid.cellMax[1] ||
+                 z < grid.cellMin[2] || z > grid.cellMax[2])) continue;
+            FOR_EACH_IN_CELL(x, y, z, i, {
+                knn_insert(i, distance2_to(center, i), k, out, dist2, &n);
+            });
+        }
+        float bound = (r - 1) * grid.cellSize;
+        if (n == k && bound > 0.0f && dist2[k-1] <= bound * bound) break;
+    }
+    return n;
+}
+
+// Intersección rayo-esfera; dir normalizada
+static inline float ray_sphere(const vec3 origin, const vec3 dir, int i) {
+    const Particles* p = &grid.particles[i];
+    vec3 oc;
+    glm_vec3_sub((float*)p->current, (float*)origin, oc);
+    minimum_image(oc);
+    float tc = glm_vec3_dot(oc, (float*)dir);
+    float d2 = glm_vec3_norm2(oc) - tc * tc;
+    float r2 = p->radius * p->radius;
+    if (d2 > r2) return -1.0f;
+    float half = sqrtf(r2 - d2);
+    return tc - half >= 0.0f ? tc - half : tc + half;
+}
+
+int physics_raycast(const vec3 origin, const vec3 direction, float maxDist, float* tHit) {
+    if (grid.count <= 0) return -1;
+    vec3 dir;
+    glm_vec3_normalize_to((float*)direction, dir);
+
+    int best = -1;
+    float bestT = maxDist;
+    FOR_EACH_OVERFLOW(i, {
+        float t = ray_sphere(origin, dir, i);
+        if (t >= 0.0f && t < bestT) { bestT = t; best = i; }
+    })
+    FOR_EACH_LARGE(i, {
+        float t = ray_sphere(origin, dir, i);
+        if (t >= 0.0f && t < bestT) { bestT = t; best = i; }
+    })
+
+    // Recorrido de celdas a lo largo del rayo (Amanatides-Woo). En cada
+    // celda se prueban sus 27 vecinas: una esfera puede asomar desde la
+    // celda de al lado.
+    // en periódico la imagen mínima sólo vale hasta medio dominio
+    if (grid.periodic && maxDist > 0.5f * grid.period) maxDist = 0.5f * grid.period;
+
+    const float cs = grid.cellSize;
+    float base = grid.periodic ? grid.origin : 0.0f;
+    int cell[3], step[3];
+    float tMax[3], tDelta[3];
+    for (int a = 0; a < 3; a++) {
+        float rel = (origin[a] - base) / cs;
+        cell[a] = (int)floorf(rel);
+        if (dir[a] > 0.0f) {
+            step[a] = 1;
+            tMax[a] = ((float)(cell[a] + 1) - rel) * cs / dir[a];
+            tDelta[a] = cs / dir[a];
+        } else if (dir[a] < 0.0f) {
+            step[a] = -1;
+            tMax[a] = (rel - (float)cell[a]) * cs / -dir[a];
+            tDelta[a] = cs / -dir[a];
+        } else {
+            step[a] = 0;
+            tMax[a] = tDelta[a] = FLT_MAX;
+        }
+    }
+
+    float t = 0.0f;
+    while (t <= maxDist && t <= bestT + cs) {
+        for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+        for (int dz = -1; dz <= 1; dz++) {
+            FOR_EACH_IN_CELL(cell[0] + dx, cell[1] + dy, cell[2] + dz, i, {
+                float ti = ray_sphere(origin, dir, i);
+                if (ti >= 0.0f && ti < bestT) { bestT = ti; best = i; }
+            });
+        }
+        // avanzar a la próxima celda
+        int a = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2)
+                                  : (tMax[1] < tMax[2] ? 1 : 2);
+        if (tMax[a] == FLT_MAX) break;
+        t = tMax[a];
+        cell[a] += step[a];
+        tMax[a] += tDelta[a];
+        // fuera de las celdas ocupadas y alejándose: no hay más nada
+        if (ray_left_grid(cell, step)) break;
+    }
+
+    if (best >= 0 && tHit) *tHit = bestT;
+    return best;
+}
+
+// ------------------------------------------------------------------ lotes
+
+// Las consultas sólo leen la grilla: el lote se reparte en bloques de
+// QUERY_CHUNK consultas, una tarea por bloque
+#define QUERY_CHUNK 256
+
+typedef struct {
+    const float (*a)[3];     // centros, mínimos u orígenes
+    const float (*b)[3];     // máximos o direcciones
+    const float* radii;
+    float maxDist;
+    int   k;                 // maxPerQuery o k
+    int   queryCount;
+    int*  out;
+    float* values;           // dist2 o tHit
+    int*  counts;
+} QueryBatch;
+
+typedef void (*QueryRangeFn)(QueryBatch* batch, int lo, int hi);
+
+typedef struct {
+    QueryBatch*  batch;
+    QueryRangeFn fn;
+} QueryJob;
+
+static void task_queries(void* arg, int lo) {
+    QueryJob* job = arg;
+    int hi = lo + QUERY_CHUNK < job->batch->queryCount ? lo + QUERY_CHUNK : job->batch->queryCount;
+    job->fn(job->batch, lo, hi);
+}
+
+// En tareas si hay pool con hilos y más de un bloque; si no (o sin
+// memoria para el grafo), en este hilo
+static void run_queries(QueryBatch* batch, QueryRangeFn fn, TaskPool* pool) {
+    QueryJob job = { batch, fn };
+    int ok = pool && task_pool_threads(pool) > 0 && batch->queryCount > QUERY_CHUNK;
+    for (int lo = 0; lo < batch->queryCount && ok; lo += QUERY_CHUNK)
+        ok = task_add(pool, task_queries, &job, lo) >= 0;
+    if (ok) {
+        task_pool_run(pool);
+        return;
+    }
+    if (pool) task_pool_clear(pool);
+    fn(batch, 0, batch->queryCount);
+}
+
+static void radius_range(QueryBatch* b, int lo, int hi) {
+    for (int q = lo; q < hi; q++)
+        b->counts[q] = physics_query_radius(b->a[q], b->radii[q], b->out + (size_t)q * b->k, b->k);
+}
+
+static void knn_range(QueryBatch* b, int lo, int hi) {
+    for (int q = lo; q < hi; q++)
+        b->counts[q] = physics_query_knn(b->a[q], b->k, b->out + (size_t)q * b->k,
+                                         b->values + (size_t)q * b->k);
+}
+
+static void aabb_range(QueryBatch* b, int lo, int hi) {
+    for (int q = lo; q < hi; q++)
+        b->counts[q] = physics_query_aabb(b->a[q], b->b[q], b->out + (size_t)q * b->k, b->k);
+}
+
+static void ray_range(QueryBatch* b, int lo, int hi) {
+    for (int q = lo; q < hi; q++)
+        b->out[q] = physics_raycast(b->a[q], b->b[q], b->maxDist, &b->values[q]);
+}
+
+void physics_query_radius_batch(const vec3* centers, const float* radii, int queryCount,
+                                int* out, int maxPerQuery, int* counts, TaskPool* pool) {
+    QueryBatch batch = { .a = centers, .radii = radii, .k = maxPerQuery,
+                         .queryCount = queryCount, .out = out, .counts = counts };
+    run_queries(&batch, radius_range, pool);
+}
+
+void physics_query_knn_batch(const vec3* centers, int queryCount, int k,
+                             int* out, float* dist2, int* counts, TaskPool* pool) {
+    QueryBatch batch = { .a = centers, .k = k, .queryCount = queryCount,
+                         .out = out, .values = dist2, .counts = counts };
+    run_queries(&batch, knn_range, pool);
+}
+
+void physics_query_aabb_batch(const vec3* mins, const vec3* maxs, int queryCount,
+                              int* out, int maxPerQuery, int* counts, TaskPool* pool) {
+    QueryBatch batch = { .a = mins, .b = maxs, .k = maxPerQuery,
+                         .queryCount = queryCount, .out = out, .counts = counts };
+    run_queries(&batch, aabb_range, pool);
+}
+
+void physics_raycast_batch(const vec3* origins, const vec3* directions, int queryCount,
+                           float maxDist, int* hits, float* tHit, TaskPool* pool) {
+    QueryBatch batch = { .a = origins, .b = directions, .maxDist = maxDist,
+                         .queryCount = queryCount, .out = hits, .values = tHit };
+    run_queries(&batch, ray_range, pool);
+}
@@ -0,0 +1,386 @@
+#include "physics/shape.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Matrices 3x3 por filas: m[3 * fila + columna]
+
+static float det3(const float m[9]) {
+    return m[0] * (m[4] * m[8] - m[5] * m[7]) -
+           m[1] * (m[3] * m[8] - m[5] * m[6]) +
+           m[2] * (m[3] * m[7] - m[4] * m[6]);
+}
+
+static int invert3(const float m[9], float out[9]) {
+    float det = det3(m);
+    float scale = (fabsf(m[0]) + fabsf(m[4]) + fabsf(m[8])) / 3.0f;
+    // forma plana o en línea: sin inversa útil
+    if (!(fabsf(det) > 1e-6f * scale * scale * scale)) return 0;
+    float inv = 1.0f / det;
+    out[0] = (m[4] * m[8] - m[5] * m[7]) * inv;
+    out[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+    out[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+    out[3] = (m[5] * m[6] - m[3] * m[8]) * inv;
+    out[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+    out[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+    out[6] = (m[3] * m[7] - m[4] * m[6]) * inv;
+    out[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+    out[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+    return 1;
+}
+
+static void quat_to_mat3(const float q[4], float m[9]) {
+    float x = q[0], y = q[1], z = q[2], w = q[3];
+    m[0] = 1.0f - 2.0f * (y * y + z * z);
+    m[1] = 2.0f * (x * y - z * w);
+    m[2] = 2.0f * (x * z + y * w);
+    m[3] = 2.0f * (x * y + z * w);
+    m[4] = 1.0f - 2.0f * (x * x + z * z);
+    m[5] = 2.0f * (y * z - x * w);
+    m[6] = 2.0f * (x * z - y * w);
+    m[7] = 2.0f * (y * z + x * w);
+    m[8] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+// Parte rotacional de A (Müller et al. 2016, "A Robust Method to Extract
+// the Rotational Part of Deformations"): gira q hasta que sus columnas
+// queden alineadas con las de A. El paso del paper (el torque sobre
+// tr(Rᵀ A)) avanza dos tercios del ángulo que falta; acá se divide por la
+// curvatura, tr(M) I - sym(M) con M = A Rᵀ, y converge en una o dos vueltas.
+// Lejos de la solución (esa matriz no es definida positiva o el paso sale
+// muy largo) se usa el paso del paper. Arranca de la rotación del paso
+// anterior.
+static void extract_rotation(const float A[9], float q[4]) {
+    // A_pq escala con r⁵: el epsilon tiene que ser relativo
+    float size = 0.0f;
+    for (int k = 0; k < 9; k++) size += fabsf(A[k]);
+    if (!(size > 0.0f)) return;
+    for (int it = 0; it < SHAPE_POLAR_ITERATIONS; it++) {
+        float R[9];
+        quat_to_mat3(q, R);
+        float omega[3] = { 0.0f, 0.0f, 0.0f };
+        float dot = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            float r[3] = { R[k], R[3 + k], R[6 + k] };
+            float a[3] = { A[k], A[3 + k], A[6 + k] };
+            omega[0] += r[1] * a[2] - r[2] * a[1];
+            omega[1] += r[2] * a[0] - r[0] * a[2];
+            omega[2] += r[0] * a[1] - r[1] * a[0];
+            dot += r[0] * a[0] + r[1] * a[1] + r[2] * a[2];
+        }
+
+        float H[9], Hinv[9];
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                float mij = A[3 * i] * R[3 * j] + A[3 * i + 1] * R[3 * j + 1] + A[3 * i + 2] * R[3 * j + 2];
+                float mji = A[3 * j] * R[3 * i] + A[3 * j + 1] * R[3 * i + 1] + A[3 * j + 2] * R[3 * i + 2];
+                H[3 * i + j] = (i == j ? dot : 0.0f) - 0.5f * (mij + mji);
+            }
+        float inv = 1.0f / (fabsf(dot) + 1e-9f * size);
+        float step[3] = { omega[0] * inv, omega[1] * inv, omega[2] * inv };
+        float w = sqrtf(step[0] * step[0] + step[1] * step[1] + step[2] * step[2]);
+        if (dot > 0.0f && H[0] > 0.0f && H[0] * H[4] - H[1] * H[3] > 0.0f && det3(H) > 0.0f &&
+            invert3(H, Hinv)) {
+            float newton[3];
+            for (int i = 0; i < 3; i++)
+                newton[i] = Hinv[3 * i] * omega[0] + Hinv[3 * i + 1] * omega[1] + Hinv[3 * i + 2] * omega[2];
+            float length = sqrtf(newton[0] * newton[0] + newton[1] * newton[1] + newton[2] * newton[2]);
+            // cerca de la solución es 1.5 veces el del paper; mucho más
+            // largo puede saltar a un punto silla
+            if (length < 2.0f * w) {
+                memcpy(step, newton, sizeof(step));
+                w = length;
+            }
+        }
+        if (w < 1e-6f) break;  // por debajo de la resolución de float
+
+        // q = (rotación de ángulo w alrededor de step) * q
+        float s = sinf(0.5f * w) / w, c = cosf(0.5f * w);
+        float d[4] = { step[0] * s, step[1] * s, step[2] * s, c };
+        float n[4] = {
+            d[3] * q[0] + d[0] * q[3] + d[1] * q[2] - d[2] * q[1],
+            d[3] * q[1] - d[0] * q[2] + d[1] * q[3] + d[2] * q[0],
+            d[3] * q[2] + d[0] * q[1] - d[1] * q[0] + d[2] * q[3],
+            d[3] * q[3] - d[0] * q[0] - d[1] * q[1] - d[2] * q[2],
+        };
+        float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] + n[3] * n[3]);
+        for (int k = 0; k < 4; k++) q[k] = n[k] / len;
+    }
+}
+
+// Centro de masa actual y A_pq = Σ m (x - centro) qᵀ del cluster c
+static void cluster_frame(const ShapeSet* set, const Particles* p, int c,
+                          float com[3], float A[9]) {
+    int lo = set->start[c], hi = set->start[c + 1];
+    float total = 0.0f;
+    com[0] = com[1] = com[2] = 0.0f;
+    for (int k = lo; k < hi; k++) {
+        const float* x = p[set->members[k]].current;
+        float m = set->mass[k];
+        com[0] += m * x[0];
+        com[1] += m * x[1];
+        com[2] += m * x[2];
+        total += m;
+    }
+    for (int a = 0; a < 3; a++) com[a] /= total;
+
+    memset(A, 0, 9 * sizeof(float));
+    for (int k = lo; k < hi; k++) {
+        const float* x = p[set->members[k]].current;
+        const float* q = set->rest[k];
+        float m = set->mass[k];
+        for (int r = 0; r < 3; r++) {
+            float dx = m * (x[r] - com[r]);
+            A[3 * r + 0] += dx * q[0];
+            A[3 * r + 1] += dx * q[1];
+            A[3 * r + 2] += dx * q[2];
+        }
+    }
+}
+
+// Transformación lineal del cluster: F = A_pq A_qq⁻¹, casi una rotación si
+// el cuerpo es casi rígido, así que la iteración converge enseguida. En
+// A_pq la forma de reposo pesa (un grano alargado la hace lenta); queda
+// solo para las formas planas, sin A_qq⁻¹.
+static int cluster_transform(const ShapeSet* set, int c, const float A[9], float F[9]) {
+    const float* Aqq = set->restInverse[c];
+    if (Aqq[0] + Aqq[4] + Aqq[8] == 0.0f) {
+        memcpy(F, A, 9 * sizeof(float));
+        return 0;
+    }
+    for (int r = 0; r < 3; r++)
+        for (int k = 0; k < 3; k++)
+            F[3 * r + k] = A[3 * r] * Aqq[k] + A[3 * r + 1] * Aqq[3 + k] + A[3 * r + 2] * Aqq[6 + k];
+    return 1;
+}
+
+static void match_cluster(ShapeSet* set, Particles* p, int c) {
+    float com[3], A[9], F[9], G[9];
+    cluster_frame(set, p, c, com, A);
+    int linear = cluster_transform(set, c, A, F);
+    extract_rotation(F, set->rotation[c]);
+    quat_to_mat3(set->rotation[c], G);
+
+    // Deformable: β F + (1 - β) R, con F llevada a determinante 1 para que
+    // conserve el volumen
+    float beta = set->deform[c];
+    if (beta > 0.0f && linear) {
+        float det = det3(F);
+        if (det > 0.0f) {
+            float scale = 1.0f / cbrtf(det);
+            for (int k = 0; k < 9; k++) G[k] = beta * F[k] * scale + (1.0f - beta) * G[k];
+        }
+    }
+
+    float alpha = set->stiffness[c];
+    for (int k = set->start[c]; k < set->start[c + 1]; k++) {
+        float* x = p[set->members[k]].current;
+        const float* q = set->rest[k];
+        for (int r = 0; r < 3; r++) {
+            float goal = G[3 * r] * q[0] + G[3 * r + 1] * q[1] + G[3 * r + 2] * q[2] + com[r];
+            x[r] += alpha * (goal - x[r]);
+        }
+    }
+}
+
+static int reserve_members(ShapeSet* set, int count) {
+    if (count <= set->memberCapacity) return 1;
+    int capacity = set->memberCapacity > 0 ? set->memberCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+    int* members = realloc(set->members, capacity * sizeof(int));
+    if (members) set->members = members;
+    float (*rest)[3] = realloc(set->rest, capacity * sizeof(*rest));
+    if (rest) set->rest = rest;
+    float* mass = realloc(set->mass, capacity * sizeof(float));
+    if (mass) set->mass = mass;
+    if (!members || !rest || !mass) {
+        fprintf(stderr, "Failed to alloc shape clusters\n");
+        return 0;
+    }
+    set->memberCapacity = capacity;
+    return 1;
+}
+
+static int reserve_clusters(ShapeSet* set, int count) {
+    if (count <= set->capacity) return 1;
+    int capacity = set->capacity > 0 ? set->capacity : 256;
+    while (capacity < count) capacity *= 2;
+    int* start = realloc(set->start, (capacity + 1) * sizeof(int));
+    if (start) set->start = start;
+    float (*rotation)[4] = realloc(set->rotation, capacity * sizeof(*rotation));
+    if (rotation) set->rotation = rotation;
+    float (*inverse)[9] = realloc(set->restInverse, capacity * sizeof(*inverse));
+    if (inverse) set->restInverse = inverse;
+    float* stiffness = realloc(set->stiffness, capacity * sizeof(float));
+    if (stiffness) set->stiffness = stiffness;
+    float* deform = realloc(set->deform, capacity * sizeof(float));
+    if (deform) set->deform = deform;
+    if (!start || !rotation || !inverse || !stiffness || !deform) {
+        fprintf(stderr, "Failed to alloc shape clusters\n");
+        return 0;
+    }
+    if (set->capacity == 0) start[0] = 0;
+    set->capacity = capacity;
+    return 1;
+}
+
+static int reserve_owner(ShapeSet* set, int count) {
+    if (count <= set->ownerCapacity) return 1;
+    int capacity = set->ownerCapacity > 0 ? set->ownerCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+    int* owner = realloc(set->owner, capacity * sizeof(int));
+    if (!owner) {
+        fprintf(stderr, "Failed to alloc shape clusters\n");
+        return 0;
+    }
+    for (int i = set->ownerCapacity; i < capacity; i++) owner[i] = -1;
+    set->owner = owner;
+    set->ownerCapacity = capacity;
+    return 1;
+}
+
+int shape_add(ShapeSet* set, const Particles* p, int count, const int* indices, int n,
+              float stiffness, float deform) {
+    if (n < 2) return -1;
+    int highest = 0;
+    for (int k = 0; k < n; k++) {
+        if (indices[k] < 0 || indices[k] >= count) {
+            fprintf(stderr, "Invalid shape cluster member %d\n", indices[k]);
+            return -1;
+        }
+        if (indices[k] > highest) highest = indices[k];
+    }
+    if (!reserve_owner(set, highest + 1) || !reserve_clusters(set, set->count + 1) ||
+        !reserve_members(set, set->memberCount + n))
+        return -1;
+    int c = set->count;
+    for (int k = 0; k < n; k++) {
+        if (set->owner[indices[k]] >= 0) {
+            fprintf(stderr, "Particle %d is already in a shape cluster\n", indices[k]);
+            while (k-- > 0) set->owner[indices[k]] = -1;
+            return -1;
+        }
+        // se marca ya para detectar índices repetidos
+        set->owner[indices[k]] = c;
+    }
+
+    int lo = set->memberCount;
+    float com[3] = { 0.0f, 0.0f, 0.0f }, total = 0.0f;
+    for (int k = 0; k < n; k++) {
+        const Particles* q = &p[indices[k]];
+        float m = q->radius * q->radius * q->radius;
+        set->members[lo + k] = indices[k];
+        set->mass[lo + k] = m;
+        for (int a = 0; a < 3; a++) com[a] += m * q->current[a];
+        total += m;
+    }
+    for (int a = 0; a < 3; a++) com[a] /= total;
+
+    float Aqq[9] = { 0 };
+    for (int k = 0; k < n; k++) {
+        float* q = set->rest[lo + k];
+        for (int a = 0; a < 3; a++) q[a] = p[indices[k]].current[a] - com[a];
+        float m = set->mass[lo + k];
+        for (int r = 0; r < 3; r++)
+            for (int s = 0; s < 3; s++) Aqq[3 * r + s] += m * q[r] * q[s];
+    }
+    if (!invert3(Aqq, set->restInverse[c]))
+        memset(set->restInverse[c], 0, sizeof(set->restInverse[c]));
+
+    set->rotation[c][0] = set->rotation[c][1] = set->rotation[c][2] = 0.0f;
+    set->rotation[c][3] = 1.0f;
+    set->stiffness[c] = fminf(fmaxf(stiffness, 0.0f), 1.0f);
+    set->deform[c] = fminf(fmaxf(deform, 0.0f), 1.0f);
+    set->memberCount += n;
+    set->start[c + 1] = set->memberCount;
+    set->count++;
+    return c;
+}
+
+void shape_truncate(ShapeSet* set, int count) {
+    int kept = 0, members = 0;
+    for (int c = 0; c < set->count; c++) {
+        int lo = set->start[c], hi = set->start[c + 1];
+        int keep = 1;
+        for (int k = lo; k < hi && keep; k++) keep = set->members[k] < count;
+        for (int k = lo; k < hi; k++)
+            set->owner[set->members[k]] = keep ? kept : -1;
+        if (!keep) continue;
+        // los miembros se corren hacia atrás: nunca pisan lo que falta leer
+        memmove(&set->members[members], &set->members[lo], (hi - lo) * sizeof(int));
+        memmove(&set->rest[members], &set->rest[lo], (hi - lo) * sizeof(*set->rest));
+        memmove(&set->mass[members], &set->mass[lo], (hi - lo) * sizeof(float));
+        memcpy(set->rotation[kept], set->rotation[c], sizeof(set->rotation[c]));
+        memcpy(set->restInverse[kept], set->restInverse[c], sizeof(set->restInverse[c]));
+        set->stiffness[kept] = set->stiffness[c];
+        set->deform[kept] = set->deform[c];
+        members += hi - lo;
+        set->start[kept + 1] = members;
+        kept++;
+    }
+    set->count = kept;
+    set->memberCount = members;
+}
+
+void shape_free(ShapeSet* set) {
+    free(set->start);
+    free(set->members);
+    free(set->rest);
+    free(set->mass);
+    free(set->rotation);
+    free(set->restInverse);
+    free(set->stiffness);
+    free(set->deform);
+    free(set->owner);
+    memset(set, 0, sizeof(*set));
+}
+
+typedef struct {
+    ShapeSet* set;
+    Particles* p;
+} ShapeJob;
+
+static void task_match(void* arg, int first) {
+    ShapeJob* job = arg;
+    int last = first + SHAPE_CHUNK < job->set->count ? first + SHAPE_CHUNK : job->set->count;
+    for (int c = first; c < last; c++) match_cluster(job->set, job->p, c);
+}
+
+void shape_solve(ShapeSet* set, Particles* p, TaskPool* pool) {
+    ShapeJob job = { set, p };
+    int ok = pool && task_pool_threads(pool) > 0 && set->count > SHAPE_CHUNK;
+    // los clusters no comparten partículas: las tareas no dependen entre sí
+    for (int c = 0; c < set->count && ok; c += SHAPE_CHUNK)
+        ok = task_add(pool, task_match, &job, c) >= 0;
+    if (ok) {
+        task_pool_run(pool);
+        return;
+    }
+    if (pool) task_pool_clear(pool);
+    for (int c = 0; c < set->count; c++) match_cluster(set, p, c);
+}
+
+float shape_max_error(const ShapeSet* set, const Particles* p) {
+    float worst = 0.0f;
+    for (int c = 0; c < set->count; c++) {
+        float com[3], A[9], F[9], R[9];
+        float q[4] = { set->rotation[c][0], set->rotation[c][1], set->rotation[c][2],
+                       set->rotation[c][3] };
+        cluster_frame(set, p, c, com, A);
+        cluster_transform(set, c, A, F);
+        extract_rotation(F, q);
+        quat_to_mat3(q, R);
+        for (int k = set->start[c]; k < set->start[c + 1]; k++) {
+            const float* x = p[set->members[k]].current;
+            const float* r = set->rest[k];
+            float d2 = 0.0f;
+            for (int a = 0; a < 3; a++) {
+                float goal = R[3 * a] * r[0] + R[3 * a + 1] * r[1] + R[3 * a + 2] * r[2] + com[a];
+                d2 += (goal - x[a]) * (goal - x[a]);
+            }
+            worst = fmaxf(worst, sqrtf(d2));
+        }
+    }
+    return worst;
+}
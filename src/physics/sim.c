@@ -0,0 +1,441 @@
+#include "physics/sim.h"
+#include "physics/env.h"
+#include "physics/grid.h"
+#include "physics/proxy.h"
+#include "physics/multirate.h"
+#include "physics/events.h"
+#include "physics/constraints.h"
+#include "physics/shape.h"
+#include "physics/gravity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ParticleSim {
+    Config config;
+    ForceFieldSet forces;
+    ContactCache contacts;
+    ProxySet proxies;
+    MultiRate multirate;
+    EventSim* events;           // con EVENT_DRIVEN; NULL si hay que rearmarlo
+    float eventDt;              // dt con el que se exportó previus
+    int eventFailed;            // no se pudo armar: paso fijo
+    TaskPool* tasks;            // con TASK_THREADS; se arma en el primer paso
+    ConstraintSet constraints;  // aristas de distancia (sogas, telas)
+    ShapeSet shapes;            // clusters rígidos o deformables
+    GravityTree gravity;        // octree de GRAVITY_G, rearmado en cada paso
+    vec3* gravityAcc;           // su aceleración por partícula (forces.particleAcceleration)
+    int taskThreads;            // los hilos con que se armó (o se intentó)
+    int restored;               // set_count movió count: falta podar restricciones y clusters
+    int gridDirty;              // las partículas cambiaron desde que se armó la grilla
+    Particles* snapshot;        // para particle_sim_snapshot con proxies
+    Particles* particles;
+    int count;
+    int capacity;
+};
+
+ParticleSim* particle_sim_create(const Config* cfg, int capacity) {
+    if (capacity <= 0) return NULL;
+    ParticleSim* sim = calloc(1, sizeof(ParticleSim));
+    if (!sim) {
+        fprintf(stderr, "Failed to alloc simulation\n");
+        return NULL;
+    }
+    sim->particles = malloc((size_t)capacity * sizeof(Particles));
+    if (!sim->particles || !proxy_init(&sim->proxies, capacity) ||
+        !multirate_init(&sim->multirate, capacity)) {
+        fprintf(stderr, "Failed to alloc %d particles\n", capacity);
+        proxy_free(&sim->proxies);
+        free(sim->particles);
+        free(sim);
+        return NULL;
+    }
+    sim->capacity = capacity;
+    sim->config = *cfg;
+    force_fields_from_config(&sim->forces, cfg);
+    return sim;
+}
+
+ParticleSim* particle_sim_create_from_file(const char* configPath, int capacity) {
+    Config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    if (!load_config(&cfg, configPath)) return NULL;
+    ParticleSim* sim = particle_sim_create(&cfg, capacity);
+    if (sim) force_fields_load(&sim->forces, &cfg, configPath);
+    return sim;
+}
+
+void particle_sim_destroy(ParticleSim* sim) {
+    if (!sim) return;
+    // que las consultas no apunten a memoria liberada
+    if (grid.particles == sim->particles) grid_insert(NULL, 0);
+    contact_cache_free(&sim->contacts);
+    event_sim_destroy(sim->events);
+    proxy_free(&sim->proxies);
+    multirate_free(&sim->multirate);
+    task_pool_destroy(sim->tasks);
+    constraint_free(&sim->constraints);
+    shape_free(&sim->shapes);
+    gravity_free(&sim->gravity);
+    free(sim->gravityAcc);
+    free(sim->snapshot);
+    free(sim->particles);
+    free(sim);
+}
+
+// El motor por eventos tiene su propia copia del estado: cualquier cambio
+// de afuera lo obliga a rearmarse
+static void drop_events(ParticleSim* sim) {
+    event_sim_destroy(sim->events);
+    sim->events = NULL;
+    sim->eventFailed = 0;
+}
+
+// Rebobinar el historial mueve count para los dos lados: las restricciones
+// y los clusters de partículas más allá de count se guardan hasta que se
+// simula o se agregan partículas desde ahí
+static void drop_restored(ParticleSim* sim) {
+    if (!sim->restored) return;
+    constraint_truncate(&sim->constraints, sim->count);
+    shape_truncate(&sim->shapes, sim->count);
+    sim->restored = 0;
+}
+
+void particle_sim_set_config(ParticleSim* sim, const Config* cfg) {
+    sim->config = *cfg;
+    sim->gridDirty = 1;
+    drop_events(sim);
+}
+
+const Config* particle_sim_config(const ParticleSim* sim) {
+    return &sim->config;
+}
+
+ForceFieldSet* particle_sim_forces(ParticleSim* sim) {
+    drop_events(sim);
+    return &sim->forces;
+}
+
+int particle_sim_spawn(ParticleSim* sim, int n) {
+    const EnvInterface* env = env_get(sim->config.ENV_TYPE);
+    if (!env || n <= 0) return 0;
+    drop_restored(sim);
+    if (n > sim->capacity - sim->count) n = sim->capacity - sim->count;
+    for (int i = sim->count; i < sim->count + n; i++) {
+        Particles* p = &sim->particles[i];
+        env->spawn(&sim->config, p->current);
+        glm_vec3_copy(p->current, p->previus);
+        p->radius = sim->config.PARTICLE_RADIUS;
+    }
+    sim->count += n;
+    sim->gridDirty = 1;
+    drop_events(sim);
+    return n;
+}
+
+int particle_sim_set_count(ParticleSim* sim, int count) {
+    if (count < 0) count = 0;
+    if (count > sim->capacity) count = sim->capacity;
+    sim->count = count;
+    sim->restored = 1;
+    sim->gridDirty = 1;
+    proxy_forget(&sim->proxies);
+    drop_events(sim);
+    return count;
+}
+
+int particle_sim_count(const ParticleSim* sim) {
+    return sim->count;
+}
+
+int particle_sim_capacity(const ParticleSim* sim) {
+    return sim->capacity;
+}
+
+// Paso por eventos. Al armarlo se separan primero los solapamientos (las
+// partículas nuevas aparecen en cualquier lado) con el solver común.
+static int step_events(ParticleSim* sim, float dt) {
+    if (!sim->events) {
+        resolve_collisions_cached(&sim->config, sim->particles, sim->count, &sim->contacts);
+        float importDt = sim->eventDt > 0.0f ? sim->eventDt : dt;
+        sim->events = event_sim_create(&sim->config, &sim->forces, sim->particles,
+                                       sim->count, importDt);
+        if (!sim->events) {
+            sim->eventFailed = 1;
+            return -1;
+        }
+    }
+    long events = event_sim_advance(sim->events, dt);
+    event_sim_export(sim->events, sim->particles, dt);
+    sim->eventDt = dt;
+    if (events < 0) {
+        fprintf(stderr, "Event-driven mode stopped (too many collisions or no memory); using fixed steps\n");
+        event_sim_destroy(sim->events);
+        sim->events = NULL;
+        sim->eventFailed = 1;
+        return -1;
+    }
+    return events > 0x7fffffff ? 0x7fffffff : (int)events;
+}
+
+// Los hilos del grafo de tareas, rearmados si cambió TASK_THREADS. NULL sin
+// hilos o si no se pudieron crear (queda el paso de un solo hilo).
+static TaskPool* step_tasks(ParticleSim* sim) {
+    int threads = (int)sim->config.TASK_THREADS;
+    if (threads != sim->taskThreads) {
+        task_pool_destroy(sim->tasks);
+        sim->tasks = threads > 0 ? task_pool_create(threads) : NULL;
+        sim->taskThreads = threads;
+    }
+    return sim->tasks;
+}
+
+// Gravedad entre partículas con las posiciones de ahora: el integrador la
+// toma de forces.particleAcceleration. Sin memoria queda apagada en este
+// paso.
+static int step_gravity(ParticleSim* sim) {
+    if (!sim->gravityAcc) {
+        sim->gravityAcc = malloc((size_t)sim->capacity * sizeof(vec3));
+        if (!sim->gravityAcc) {
+            fprintf(stderr, "Failed to alloc gravity\n");
+            return 0;
+        }
+    }
+    return gravity_compute(&sim->gravity, &sim->config, sim->particles, sim->count,
+                           sim->gravityAcc, step_tasks(sim));
+}
+
+int particle_sim_step(ParticleSim* sim, float dt) {
+    drop_restored(sim);
+    // los eventos, las restricciones y los clusters mueven partículas
+    // después de armar la grilla (o sin armarla)
+    sim->gridDirty = 1;
+    // las restricciones necesitan paso fijo e índices estables: no hay
+    // eventos ni proxies mientras haya alguna
+    int constrained = sim->constraints.count > 0 || sim->constraints.pinCount > 0 ||
+                      sim->shapes.count > 0;
+    // con gravedad entre partículas tampoco hay eventos: no es un campo
+    // uniforme
+    int gravity = sim->config.GRAVITY_G != 0.0f;
+    if (sim->forces.particleAcceleration == sim->gravityAcc)
+        sim->forces.particleAcceleration = NULL;
+    if (sim->config.EVENT_DRIVEN && !sim->eventFailed && sim->count > 0 && !constrained &&
+        !gravity) {
+        int events = step_events(sim, dt);
+        if (events >= 0) return events;
+    }
+    sim->eventDt = 0.0f;
+    // Unir o partir proxies cambia los índices: la caché de contactos del
+    // paso anterior ya no vale
+    if (!constrained &&
+        proxy_update(&sim->proxies, &sim->config, sim->particles, &sim->count, sim->capacity))
+        sim->contacts.count = 0;
+    // una aceleración por partícula puesta desde afuera tiene prioridad
+    if (gravity && !sim->forces.particleAcceleration && step_gravity(sim))
+        sim->forces.particleAcceleration = sim->gravityAcc;
+    int passes;
+    if (sim->config.MULTIRATE_LEVELS > 1)
+        passes = multirate_step(&sim->multirate, &sim->config, &sim->forces,
+                                sim->particles, sim->count, dt, &sim->contacts);
+    else
+        passes = integrate_and_resolve(&sim->config, &sim->forces, sim->particles, sim->count, dt,
+                                       &sim->contacts, step_tasks(sim), 0);
+    // Después de los contactos: las aristas tienen la última palabra y lo
+    // que vuelvan a solapar se separa en el paso siguiente
+    if (constrained)
+        constraint_solve(&sim->constraints, sim->particles, sim->count,
+                         (int)sim->config.CONSTRAINT_ITERATIONS, step_tasks(sim));
+    if (sim->shapes.count > 0)
+        shape_solve(&sim->shapes, sim->particles, step_tasks(sim));
+    return passes;
+}
+
+int particle_sim_add_distance(ParticleSim* sim, int a, int b, float rest, float stiffness) {
+    drop_restored(sim);
+    drop_events(sim);
+    return constraint_add(&sim->constraints, sim->particles, sim->count, a, b, rest, stiffness);
+}
+
+int particle_sim_pin(ParticleSim* sim, int i) {
+    if (i < 0 || i >= sim->count) return 0;
+    drop_restored(sim);
+    return constraint_pin(&sim->constraints, sim->particles, i);
+}
+
+// Grilla de nu x nv partículas a distancia spacing: aristas entre vecinas
+// (estiramiento), en diagonal (corte) y salteando una (flexión, más
+// blandas). Con pinCorners se fijan las dos esquinas de la primera fila.
+int particle_sim_add_cloth(ParticleSim* sim, const vec3 origin, const vec3 u, const vec3 v,
+                           int nu, int nv, float spacing, float stiffness, int pinCorners) {
+    if (nu < 2 || nv < 2 || nu * nv > sim->capacity - sim->count) return -1;
+    drop_restored(sim);
+    vec3 du, dv;
+    glm_vec3_normalize_to((float*)u, du);
+    glm_vec3_normalize_to((float*)v, dv);
+    glm_vec3_scale(du, spacing, du);
+    glm_vec3_scale(dv, spacing, dv);
+
+    int first = sim->count;
+    for (int j = 0; j < nv; j++)
+        for (int i = 0; i < nu; i++) {
+            Particles* q = &sim->particles[first + j * nu + i];
+            glm_vec3_copy((float*)origin, q->current);
+            glm_vec3_muladds(du, (float)i, q->current);
+            glm_vec3_muladds(dv, (float)j, q->current);
+            glm_vec3_copy(q->current, q->previus);
+            q->radius = sim->config.PARTICLE_RADIUS;
+        }
+    sim->count += nu * nv;
+    sim->gridDirty = 1;
+    drop_events(sim);
+
+    ConstraintSet* set = &sim->constraints;
+    int ok = 1;
+    for (int j = 0; j < nv && ok; j++)
+        for (int i = 0; i < nu && ok; i++) {
+            int k = first + j * nu + i;
+            if (i + 1 < nu) ok = ok && constraint_add(set, sim->particles, sim->count, k, k + 1, -1.0f, stiffness);
+            if (j + 1 < nv) ok = ok && constraint_add(set, sim->particles, sim->count, k, k + nu, -1.0f, stiffness);
+            if (i + 1 < nu && j + 1 < nv) {
+                ok = ok && constraint_add(set, sim->particles, sim->count, k, k + nu + 1, -1.0f, stiffness);
+                ok = ok && constraint_add(set, sim->particles, sim->count, k + 1, k + nu, -1.0f, stiffness);
+            }
+            if (i + 2 < nu) ok = ok && constraint_add(set, sim->particles, sim->count, k, k + 2, -1.0f, 0.5f * stiffness);
+            if (j + 2 < nv) ok = ok && constraint_add(set, sim->particles, sim->count, k, k + 2 * nu, -1.0f, 0.5f * stiffness);
+        }
+    if (ok && pinCorners)
+        ok = constraint_pin(set, sim->particles, first) &&
+             constraint_pin(set, sim->particles, first + nu - 1);
+    if (!ok) {
+        // sin la tela entera no queda nada: ni partículas ni aristas sueltas
+        constraint_truncate(set, first);
+        sim->count = first;
+        return -1;
+    }
+    return first;
+}
+
+int particle_sim_add_cluster(ParticleSim* sim, const int* indices, int n,
+                             float stiffness, float deform) {
+    drop_restored(sim);
+    drop_events(sim);
+    return shape_add(&sim->shapes, sim->particles, sim->count, indices, n, stiffness, deform);
+}
+
+int particle_sim_add_body(ParticleSim* sim, const vec3* offsets, const float* radii, int n,
+                          const vec3 position, float stiffness, float deform) {
+    if (n < 2 || n > sim->capacity - sim->count) return -1;
+    drop_restored(sim);
+    int first = sim->count;
+    int* indices = malloc(n * sizeof(int));
+    if (!indices) {
+        fprintf(stderr, "Failed to alloc body\n");
+        return -1;
+    }
+    for (int k = 0; k < n; k++) {
+        Particles* q = &sim->particles[first + k];
+        glm_vec3_add((float*)position, (float*)offsets[k], q->current);
+        glm_vec3_copy(q->current, q->previus);
+        q->radius = radii ? radii[k] : sim->config.PARTICLE_RADIUS;
+        indices[k] = first + k;
+    }
+    sim->count += n;
+    sim->gridDirty = 1;
+    int id = particle_sim_add_cluster(sim, indices, n, stiffness, deform);
+    free(indices);
+    if (id < 0) {
+        sim->count = first;
+        return -1;
+    }
+    return first;
+}
+
+void particle_sim_set_focus(ParticleSim* sim, const vec3 focus) {
+    proxy_set_focus(&sim->proxies, focus);
+}
+
+int particle_sim_proxy_count(const ParticleSim* sim) {
+    return sim->proxies.active;
+}
+
+Particles* particle_sim_particles(ParticleSim* sim) {
+    return sim->particles;
+}
+
+const Particles* particle_sim_snapshot(ParticleSim* sim, int* count) {
+    *count = sim->count;
+    if (sim->proxies.active == 0) return sim->particles;
+    if (!sim->snapshot) {
+        sim->snapshot = malloc((size_t)sim->capacity * sizeof(Particles));
+        if (!sim->snapshot) {
+            fprintf(stderr, "Failed to alloc snapshot\n");
+            return sim->particles;
+        }
+    }
+    *count = proxy_expand(&sim->proxies, sim->particles, sim->count, sim->snapshot, sim->capacity);
+    return sim->snapshot;
+}
+
+const float* particle_sim_positions(const ParticleSim* sim, int* stride) {
+    if (stride) *stride = (int)(sizeof(Particles) / sizeof(float));
+    return sim->particles[0].current;
+}
+
+// La grilla es global: si la última que se armó es de otra simulación (o de
+// otra cantidad de partículas), o las partículas cambiaron desde entonces,
+// se vuelve a armar con las posiciones actuales
+static void ensure_grid(ParticleSim* sim) {
+    if (!sim->gridDirty && grid.particles == sim->particles && grid.count == sim->count) return;
+    grid_setup(&sim->config, sim->particles, sim->count);
+    grid_insert(sim->particles, sim->count);
+    sim->gridDirty = 0;
+}
+
+int particle_sim_query_radius(ParticleSim* sim, const vec3 center, float radius,
+                              int* out, int maxOut) {
+    ensure_grid(sim);
+    return physics_query_radius(center, radius, out, maxOut);
+}
+
+int particle_sim_query_aabb(ParticleSim* sim, const vec3 min, const vec3 max,
+                            int* out, int maxOut) {
+    ensure_grid(sim);
+    return physics_query_aabb(min, max, out, maxOut);
+}
+
+int particle_sim_query_knn(ParticleSim* sim, const vec3 center, int k,
+                           int* out, float* dist2) {
+    ensure_grid(sim);
+    return physics_query_knn(center, k, out, dist2);
+}
+
+int particle_sim_raycast(ParticleSim* sim, const vec3 origin, const vec3 direction,
+                         float maxDist, float* tHit) {
+    ensure_grid(sim);
+    return physics_raycast(origin, direction, maxDist, tHit);
+}
+
+void particle_sim_query_radius_batch(ParticleSim* sim, const vec3* centers, const float* radii,
+                                     int queryCount, int* out, int maxPerQuery, int* counts) {
+    ensure_grid(sim);
+    physics_query_radius_batch(centers, radii, queryCount, out, maxPerQuery, counts,
+                               step_tasks(sim));
+}
+
+void particle_sim_query_aabb_batch(ParticleSim* sim, const vec3* mins, const vec3* maxs,
+                                   int queryCount, int* out, int maxPerQuery, int* counts) {
+    ensure_grid(sim);
+    physics_query_aabb_batch(mins, maxs, queryCount, out, maxPerQuery, counts, step_tasks(sim));
+}
+
+void particle_sim_query_knn_batch(ParticleSim* sim, const vec3* centers, int queryCount, int k,
+                                  int* out, float* dist2, int* counts) {
+    ensure_grid(sim);
+    physics_query_knn_batch(centers, queryCount, k, out, dist2, counts, step_tasks(sim));
+}
+
+void particle_sim_raycast_batch(ParticleSim* sim, const vec3* origins, const vec3* directions,
+                                int queryCount, float maxDist, int* hits, float* tHit) {
+    ensure_grid(sim);
+    physics_raycast_batch(origins, directions, queryCount, maxDist, hits, tHit, step_tasks(sim));
+}
@@ -0,0 +1,337 @@
+#define _DEFAULT_SOURCE  // madvise
+#include "physics/stream.h"
+#include "physics/env.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct {
+    Particles* items;
+    int count;
+    int capacity;
+} ParticleList;
+
+typedef struct {
+    int fd;
+    size_t bytes;
+    StreamHeader* header;
+    char* records;
+    size_t recordBytes;
+    const CompactFormat* compact;  // NULL si los registros son Particles
+} StreamMap;
+
+static int list_reserve(ParticleList* list, int need) {
+    if (need <= list->capacity) return 1;
+    int capacity = list->capacity > 0 ? list->capacity : 4096;
+    while (capacity < need) capacity *= 2;
+    Particles* grown = realloc(list->items, capacity * sizeof(Particles));
+    if (!grown) {
+        fprintf(stderr, "Failed to alloc stream buffer\n");
+        return 0;
+    }
+    list->items = grown;
+    list->capacity = capacity;
+    return 1;
+}
+
+static inline int list_push(ParticleList* list, const Particles* p) {
+    if (!list_reserve(list, list->count + 1)) return 0;
+    list->items[list->count++] = *p;
+    return 1;
+}
+
+// madvise sobre un rango de partículas, extendido a páginas completas
+static void advise_range(StreamMap* map, int64_t first, int64_t n, int advice) {
+    if (n <= 0) return;
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)(map->records + first * map->recordBytes) & ~(page - 1);
+    uintptr_t end = (uintptr_t)(map->records + (first + n) * map->recordBytes);
+    madvise((void*)start, end - start, advice);
+}
+
+static void load_records(const StreamMap* map, int64_t first, int n, Particles* out) {
+    if (map->compact)
+        compact_decode(map->compact, (const CompactParticle*)map->records + first, n, out);
+    else
+        memcpy(out, (const Particles*)map->records + first, (size_t)n * sizeof(Particles));
+}
+
+static int store_records(StreamMap* map, int64_t first, int n, const Particles* in) {
+    if (map->compact)
+        return compact_encode(&map->header->compact, in, n, (CompactParticle*)map->records + first);
+    memcpy((Particles*)map->records + first, in, (size_t)n * sizeof(Particles));
+    return 1;
+}
+
+size_t stream_record_bytes(const Config* cfg) {
+    return cfg->COMPACT_STATE ? sizeof(CompactParticle) : sizeof(Particles);
+}
+
+// Al crear, recordBytes da el formato; al abrir se toma del encabezado
+static int map_file(StreamMap* map, const char* path, int64_t count, size_t recordBytes, int create) {
+    memset(map, 0, sizeof(*map));
+    map->fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (map->fd < 0) {
+        perror("Error opening stream file");
+        return 0;
+    }
+    if (create) {
+        map->bytes = STREAM_HEADER_BYTES + (size_t)count * recordBytes;
+        if (ftruncate(map->fd, (off_t)map->bytes) != 0) {
+            perror("Error sizing stream file");
+            close(map->fd);
+            return 0;
+        }
+    } else {
+        struct stat st;
+        fstat(map->fd, &st);
+        map->bytes = (size_t)st.st_size;
+        if (map->bytes < STREAM_HEADER_BYTES) {
+            fprintf(stderr, "Stream file too small: %s\n", path);
+            close(map->fd);
+            return 0;
+        }
+    }
+    void* base = mmap(NULL, map->bytes, create ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                      MAP_SHARED, map->fd, 0);
+    if (base == MAP_FAILED) {
+        perror("Error mapping stream file");
+        close(map->fd);
+        return 0;
+    }
+    map->header = base;
+    map->records = (char*)base + STREAM_HEADER_BYTES;
+    if (!create) {
+        // los archivos anteriores al formato compacto tienen 0
+        recordBytes = map->header->recordBytes ? (size_t)map->header->recordBytes : sizeof(Particles);
+        if (memcmp(map->header->magic, "PSTREAM1", 8) != 0 ||
+            (recordBytes != sizeof(Particles) && recordBytes != sizeof(CompactParticle)) ||
+            map->bytes < STREAM_HEADER_BYTES + (size_t)map->header->count * recordBytes) {
+            fprintf(stderr, "Bad stream file: %s\n", path);
+            munmap(base, map->bytes);
+            close(map->fd);
+            return 0;
+        }
+    }
+    map->recordBytes = recordBytes;
+    map->compact = recordBytes == sizeof(CompactParticle) ? &map->header->compact : NULL;
+    return 1;
+}
+
+static void unmap_file(StreamMap* map) {
+    if (!map->header) return;
+    munmap(map->header, map->bytes);
+    close(map->fd);
+    map->header = NULL;
+}
+
+static int slab_of(const StreamHeader* h, float x) {
+    int lo = 0, hi = h->slabs - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (x >= h->cuts[mid]) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+int stream_create(const char* path, const Config* cfg, int64_t count, int slabs) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env || count <= 0) return 0;
+    if (env->periodic) {
+        fprintf(stderr, "Stream mode does not support periodic environments\n");
+        return 0;
+    }
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    float halo = 2.0f * cfg->PARTICLE_RADIUS;
+    if (slabs < 1 || slabs > MAX_STREAM_SLABS || (max[0] - min[0]) < 2.0f * halo * slabs) {
+        fprintf(stderr, "Bad slab count %d (max %d, each at least %.3f wide)\n",
+                slabs, MAX_STREAM_SLABS, 2.0f * halo);
+        return 0;
+    }
+
+    StreamMap map;
+    if (!map_file(&map, path, count, stream_record_bytes(cfg), 1)) return 0;
+    StreamHeader* h = map.header;
+    memcpy(h->magic, "PSTREAM1", 8);
+    h->count = count;
+    h->slabs = slabs;
+    h->envType = cfg->ENV_TYPE;
+    h->recordBytes = (int32_t)map.recordBytes;
+    if (map.compact && !compact_format_init(&h->compact, cfg)) {
+        fprintf(stderr, "Bad bounds for the compact stream format\n");
+        unmap_file(&map);
+        return 0;
+    }
+    for (int s = 0; s <= slabs; s++)
+        h->cuts[s] = min[0] + (max[0] - min[0]) * s / slabs;
+
+    // Dos pasadas con la misma semilla: la primera cuenta por franja y la
+    // segunda escribe cada partícula en su lugar, sin tenerlas en memoria
+    const unsigned int seed = 1234;
+    int64_t* cursor = calloc(slabs + 1, sizeof(int64_t));
+    if (!cursor) {
+        unmap_file(&map);
+        return 0;
+    }
+    srand(seed);
+    for (int64_t i = 0; i < count; i++) {
+        vec3 pos;
+        env->spawn(cfg, pos);
+        cursor[slab_of(h, pos[0]) + 1]++;
+    }
+    for (int s = 0; s < slabs; s++) cursor[s + 1] += cursor[s];
+    memcpy(h->offsets, cursor, (slabs + 1) * sizeof(int64_t));
+
+    srand(seed);
+    for (int64_t i = 0; i < count; i++) {
+        Particles p;
+        env->spawn(cfg, p.current);
+        glm_vec3_copy(p.current, p.previus);
+        p.radius = cfg->PARTICLE_RADIUS;
+        store_records(&map, cursor[slab_of(h, p.current[0])]++, 1, &p);
+    }
+    free(cursor);
+    msync(map.header, map.bytes, MS_SYNC);
+    unmap_file(&map);
+    return 1;
+}
+
+int stream_step(const char* srcPath, const char* dstPath, const Config* cfg,
+                const ForceFieldSet* forces, float dt) {
+    if (forces->particleAcceleration) {
+        fprintf(stderr, "Stream mode does not support per-particle acceleration\n");
+        return 0;
+    }
+    StreamMap src, dst;
+    if (!map_file(&src, srcPath, 0, 0, 0)) return 0;
+    const StreamHeader* h = src.header;
+    if (!map_file(&dst, dstPath, h->count, src.recordBytes, 1)) {
+        unmap_file(&src);
+        return 0;
+    }
+    memcpy(dst.header, h, sizeof(StreamHeader));
+
+    const int S = h->slabs;
+    const float halo = 2.0f * cfg->PARTICLE_RADIUS;
+    // Los índices cambian de franja en franja: el warm start no aplica
+    Config config = *cfg;
+    config.ENV_TYPE = h->envType;
+    config.WARM_START = 0.0f;
+    ContactCache contacts;
+    memset(&contacts, 0, sizeof(contacts));
+
+    // Franjas integradas pero sin resolver, en un anillo de tres: al
+    // cargar la franja k+1 sus partículas pueden caer en k, k+1 o k+2
+    ParticleList owned[3], incoming, work, carry, nextCarry;
+    memset(owned, 0, sizeof(owned));
+    memset(&incoming, 0, sizeof(incoming));
+    memset(&work, 0, sizeof(work));
+    memset(&carry, 0, sizeof(carry));
+    memset(&nextCarry, 0, sizeof(nextCarry));
+    advise_range(&src, 0, h->count, MADV_SEQUENTIAL);
+
+    int ok = 1;
+    int64_t written = 0;
+    for (int k = -1; k < S && ok; k++) {
+        // Cargar e integrar la franja k+1 mientras se pide la siguiente
+        int load = k + 1;
+        if (load < S) {
+            int64_t first = h->offsets[load];
+            int n = (int)(h->offsets[load + 1] - first);
+            if (load + 1 < S)
+                advise_range(&src, h->offsets[load + 1],
+                             h->offsets[load + 2] - h->offsets[load + 1], MADV_WILLNEED);
+            ok = list_reserve(&incoming, n);
+            if (!ok) break;
+            load_records(&src, first, n, incoming.items);
+            incoming.count = n;
+            advise_range(&src, first, n, MADV_DONTNEED);
+
+            integrate_particles(&config, forces, incoming.items, n, dt);
+            for (int i = 0; i < n && ok; i++) {
+                // Sólo se mueve a franjas vecinas: el ancho mínimo es dos halos
+                int s = slab_of(h, incoming.items[i].current[0]);
+                if (s < load - 1) s = load - 1;
+                if (s > load + 1) s = load + 1;
+                if (s < 0) s = 0;
+                if (s >= S) s = S - 1;
+                ok = list_push(&owned[s % 3], &incoming.items[i]);
+            }
+        }
+        if (k < 0 || !ok) continue;
+
+        // Resolver la franja k con fantasmas de ambos lados, tomados antes
+        // de resolver: el borde de k-1 (carry) y el de k+1
+        ParticleList* mine = &owned[k % 3];
+        ok = list_reserve(&work, mine->count + carry.count);
+        if (!ok) break;
+        memcpy(work.items, mine->items, (size_t)mine->count * sizeof(Particles));
+        memcpy(work.items + mine->count, carry.items, (size_t)carry.count * sizeof(Particles));
+        work.count = mine->count + carry.count;
+
+        nextCarry.count = 0;
+        if (k + 1 < S) {
+            float upper = h->cuts[k + 1];
+            const ParticleList* next = &owned[(k + 1) % 3];
+            for (int i = 0; i < next->count && ok; i++)
+                if (next->items[i].current[0] < upper + halo)
+                    ok = list_push(&work, &next->items[i]);
+            for (int i = 0; i < mine->count && ok; i++)
+                if (mine->items[i].current[0] >= upper - halo)
+                    ok = list_push(&nextCarry, &mine->items[i]);
+        }
+        if (!ok) break;
+
+        resolve_collisions_cached(&config, work.items, work.count, &contacts);
+
+        // Sólo las propias vuelven al disco; los fantasmas se descartan
+        dst.header->offsets[k] = written;
+        ok = store_records(&dst, written, mine->count, work.items);
+        advise_range(&dst, written, mine->count, MADV_DONTNEED);
+        written += mine->count;
+        mine->count = 0;
+
+        ParticleList swap = carry;
+        carry = nextCarry;
+        nextCarry = swap;
+    }
+    dst.header->offsets[S] = written;
+    if (ok && written != h->count) {
+        fprintf(stderr, "Stream step lost particles: %lld of %lld\n",
+                (long long)written, (long long)h->count);
+        ok = 0;
+    }
+
+    for (int s = 0; s < 3; s++) free(owned[s].items);
+    free(incoming.items);
+    free(work.items);
+    free(carry.items);
+    free(nextCarry.items);
+    contact_cache_free(&contacts);
+    unmap_file(&src);
+    unmap_file(&dst);
+    return ok;
+}
+
+int stream_summary(const char* path, int64_t* count, double* meanY) {
+    StreamMap map;
+    if (!map_file(&map, path, 0, 0, 0)) return 0;
+    const StreamHeader* h = map.header;
+    advise_range(&map, 0, h->count, MADV_SEQUENTIAL);
+    double sum = 0.0;
+    for (int64_t i = 0; i < h->count; i++) {
+        Particles p;
+        load_records(&map, i, 1, &p);
+        sum += p.current[1];
+    }
+    *count = h->count;
+    *meanY = h->count > 0 ? sum / h->count : 0.0;
+    unmap_file(&map);
+    return 1;
+}
@@ -0,0 +1,354 @@
+#include "physics/sweep.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWEEP_AXIS_HYSTERESIS 1.5f  // otro eje tiene que estar así de más disperso para cambiar
+#define SWEEP_MAX_SHIFTS 4          // corrimientos por partícula antes de rehacer el orden
+
+static int reserve_sweep(SweepPrune* sp, int count) {
+    if (count <= sp->capacity) return 1;
+    int capacity = sp->capacity > 0 ? sp->capacity : 1024;
+    while (capacity < count) capacity *= 2;
+
+    int* order = realloc(sp->order, capacity * sizeof(int));
+    if (order) sp->order = order;
+    float* lo = realloc(sp->lo, capacity * sizeof(float));
+    if (lo) sp->lo = lo;
+    float (*sorted)[4] = realloc(sp->sorted, capacity * sizeof(*sp->sorted));
+    if (sorted) sp->sorted = sorted;
+    SweepKey* wrapped = realloc(sp->wrapped, capacity * sizeof(SweepKey));
+    if (wrapped) sp->wrapped = wrapped;
+    if (!order || !lo || !sorted || !wrapped) {
+        fprintf(stderr, "Failed to alloc sweep and prune buffers\n");
+        return 0;
+    }
+    sp->capacity = capacity;
+    return 1;
+}
+
+static int grow_pairs(SweepPrune* sp) {
+    int capacity = sp->pairCapacity > 0 ? 2 * sp->pairCapacity : 4096;
+    SweepPair* pairs = realloc(sp->pairs, capacity * sizeof(SweepPair));
+    if (!pairs) {
+        fprintf(stderr, "Failed to alloc sweep and prune pairs\n");
+        return 0;
+    }
+    sp->pairs = pairs;
+    sp->pairCapacity = capacity;
+    return 1;
+}
+
+void sweep_free(SweepPrune* sp) {
+    free(sp->order);
+    free(sp->lo);
+    free(sp->sorted);
+    free(sp->wrapped);
+    free(sp->pairs);
+    free(sp->radixKeys);
+    free(sp->radixValues);
+    memset(sp, 0, sizeof(*sp));
+}
+
+// Coordenada sobre el eje llevada al dominio periódico
+static inline float wrap_coord(float x, float origin, float period) {
+    if (period <= 0.0f) return x;
+    return x - period * floorf((x - origin) / period);
+}
+
+static inline float lower_edge(const Particles* p, int i, int axis, float origin, float period) {
+    return wrap_coord(p[i].current[axis], origin, period) - p[i].radius;
+}
+
+// Eje de mayor varianza de los centros. Se conserva el anterior salvo que
+// otro sea claramente mejor: cambiar de eje obliga a ordenar desde cero.
+static int choose_axis(const SweepPrune* sp, const Particles* p, int count) {
+    double sum[3] = {0.0, 0.0, 0.0}, sum2[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < count; i++)
+        for (int a = 0; a < 3; a++) {
+            sum[a] += p[i].current[a];
+            sum2[a] += (double)p[i].current[a] * p[i].current[a];
+        }
+    double var[3];
+    int best = 0;
+    for (int a = 0; a < 3; a++) {
+        double mean = sum[a] / count;
+        var[a] = sum2[a] / count - mean * mean;
+        if (var[a] > var[best]) best = a;
+    }
+    if (sp->count > 0 && var[best] <= SWEEP_AXIS_HYSTERESIS * var[sp->axis]) return sp->axis;
+    return best;
+}
+
+// Insertion sort del orden del paso anterior. Devuelve 0 si pasó el tope
+// de corrimientos (el orden queda a medias pero sigue siendo una
+// permutación válida).
+static int insertion_sort(SweepPrune* sp, int count, long limit) {
+    long shifts = 0;
+    for (int k = 1; k < count; k++) {
+        float key = sp->lo[k];
+        int index = sp->order[k];
+        int m = k - 1;
+        while (m >= 0 && sp->lo[m] > key) {
+            sp->lo[m + 1] = sp->lo[m];
+            sp->order[m + 1] = sp->order[m];
+            m--;
+            if (++shifts > limit) {
+                sp->lo[m + 1] = key;
+                sp->order[m + 1] = index;
+                return 0;
+            }
+        }
+        sp->lo[m + 1] = key;
+        sp->order[m + 1] = index;
+    }
+    return 1;
+}
+
+static int compare_sweep_keys(const void* a, const void* b) {
+    float x = ((const SweepKey*)a)->lo, y = ((const SweepKey*)b)->lo;
+    return (x > y) - (x < y);
+}
+
+// Arregla el orden del paso anterior con los bordes nuevos. Las que dieron
+// la vuelta al dominio periódico saltaron de una punta del orden a la otra:
+// se ordenan aparte y se mezclan al final, así el insertion sort no las
+// corre a lo largo de todo el arreglo. Devuelve 0 si hay que ordenar desde
+// cero.
+static int refresh_order(SweepPrune* sp, const Particles* p, int count, int axis,
+                         float origin, float period) {
+    int kept = 0, wrapped = 0;
+    for (int k = 0; k < count; k++) {
+        int i = sp->order[k];
+        float lo = lower_edge(p, i, axis, origin, period);
+        if (period > 0.0f && fabsf(lo - sp->lo[k]) > 0.5f * period) {
+            sp->wrapped[wrapped].lo = lo;
+            sp->wrapped[wrapped].index = i;
+            wrapped++;
+        } else {
+            sp->lo[kept] = lo;
+            sp->order[kept] = i;
+            kept++;
+        }
+    }
+    if (!insertion_sort(sp, kept, (long)SWEEP_MAX_SHIFTS * count)) return 0;
+    if (wrapped == 0) return 1;
+
+    // mezcla desde atrás, en el lugar
+    qsort(sp->wrapped, wrapped, sizeof(SweepKey), compare_sweep_keys);
+    int a = kept - 1, b = wrapped - 1;
+    for (int k = count - 1; b >= 0; k--) {
+        if (a >= 0 && sp->lo[a] > sp->wrapped[b].lo) {
+            sp->lo[k] = sp->lo[a];
+            sp->order[k] = sp->order[a];
+            a--;
+        } else {
+            sp->lo[k] = sp->wrapped[b].lo;
+            sp->order[k] = sp->wrapped[b].index;
+            b--;
+        }
+    }
+    return 1;
+}
+
+// ------------------------------------------------------------ radix sort
+
+// Float a entero sin signo con el mismo orden
+static inline uint32_t sortable_key(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+}
+
+// Un tramo del arreglo para una tarea. En la fase de conteo histogram cuenta
+// los dígitos del tramo; en la de reparto es la próxima posición de salida
+// de cada dígito.
+typedef struct {
+    int begin, end;
+    int shift;
+    int scatter;
+    const uint32_t* keys;
+    const int* values;
+    uint32_t* outKeys;
+    int* outValues;
+    int histogram[256];
+} RadixChunk;
+
+static void radix_chunk(void* arg, int t) {
+    RadixChunk* c = (RadixChunk*)arg + t;
+    if (!c->scatter) {
+        memset(c->histogram, 0, sizeof(c->histogram));
+        for (int k = c->begin; k < c->end; k++)
+            c->histogram[(c->keys[k] >> c->shift) & 255]++;
+        return;
+    }
+    for (int k = c->begin; k < c->end; k++) {
+        int slot = c->histogram[(c->keys[k] >> c->shift) & 255]++;
+        c->outKeys[slot] = c->keys[k];
+        c->outValues[slot] = c->values[k];
+    }
+}
+
+// Corre los tramos como tareas del pool o, si no hay memoria para el
+// grafo, en serie en el hilo que llama
+static void run_chunks(RadixChunk* chunks, int n, TaskPool* pool) {
+    int ok = pool && n > 1;
+    for (int t = 0; t < n && ok; t++) ok = task_add(pool, radix_chunk, chunks, t) >= 0;
+    if (ok) {
+        task_pool_run(pool);
+        return;
+    }
+    if (pool) task_pool_clear(pool);
+    for (int t = 0; t < n; t++) radix_chunk(chunks, t);
+}
+
+// Orden desde cero: radix sort LSD de 4 pasadas de 8 bits. Cada tarea
+// cuenta los dígitos de su tramo, las posiciones de salida salen de los
+// conteos de todos (dígitos menores, y el mismo dígito en tramos
+// anteriores) y cada tarea reparte su tramo. Es estable, así que el
+// resultado no depende de la cantidad de tramos.
+static int radix_order(SweepPrune* sp, const Particles* p, int count, int axis,
+                       float origin, float period, TaskPool* pool) {
+    if (count > sp->radixCapacity) {
+        uint32_t* keys = realloc(sp->radixKeys, 2 * (size_t)count * sizeof(uint32_t));
+        if (keys) sp->radixKeys = keys;
+        int* values = realloc(sp->radixValues, 2 * (size_t)count * sizeof(int));
+        if (values) sp->radixValues = values;
+        if (!keys || !values) {
+            fprintf(stderr, "Failed to alloc sweep and prune sort buffers\n");
+            return 0;
+        }
+        sp->radixCapacity = count;
+    }
+    uint32_t* keys[2] = { sp->radixKeys, sp->radixKeys + count };
+    int* values[2] = { sp->radixValues, sp->radixValues + count };
+    for (int i = 0; i < count; i++) {
+        keys[0][i] = sortable_key(lower_edge(p, i, axis, origin, period));
+        values[0][i] = i;
+    }
+
+    // un tramo por hilo del pool, contando el que llama
+    int threads = 1;
+    if (pool && count >= SWEEP_PARALLEL_MIN) {
+        threads = task_pool_threads(pool) + 1;
+        if (threads > SWEEP_MAX_CHUNKS) threads = SWEEP_MAX_CHUNKS;
+    }
+    RadixChunk chunks[SWEEP_MAX_CHUNKS];
+    for (int t = 0; t < threads; t++) {
+        chunks[t].begin = (int)((long long)count * t / threads);
+        chunks[t].end = (int)((long long)count * (t + 1) / threads);
+    }
+
+    for (int pass = 0; pass < 4; pass++) {
+        int from = pass & 1, to = from ^ 1;
+        for (int t = 0; t < threads; t++) {
+            chunks[t].shift = 8 * pass;
+            chunks[t].scatter = 0;
+            chunks[t].keys = keys[from];
+            chunks[t].values = values[from];
+            chunks[t].outKeys = keys[to];
+            chunks[t].outValues = values[to];
+        }
+        run_chunks(chunks, threads, pool);
+
+        int total = 0;
+        for (int d = 0; d < 256; d++)
+            for (int t = 0; t < threads; t++) {
+                int n = chunks[t].histogram[d];
+                chunks[t].histogram[d] = total;
+                total += n;
+            }
+        for (int t = 0; t < threads; t++) chunks[t].scatter = 1;
+        run_chunks(chunks, threads, pool);
+    }
+
+    // con 4 pasadas el resultado quedó en el primer buffer
+    for (int k = 0; k < count; k++) {
+        sp->order[k] = values[0][k];
+        sp->lo[k] = lower_edge(p, values[0][k], axis, origin, period);
+    }
+    return 1;
+}
+
+// ------------------------------------------------------------- barrido
+
+static inline int try_pair(SweepPrune* sp, int a, int b, float margin, float period,
+                           const unsigned char* frozen) {
+    int i = sp->order[a], j = sp->order[b];
+    if (frozen && frozen[i] && frozen[j]) return 1;
+    const float* u = sp->sorted[a];
+    const float* v = sp->sorted[b];
+    float reach = u[3] + v[3] + margin;
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; k++) {
+        float d = v[k] - u[k];
+        // imagen mínima: los centros no se alejan más de un período
+        if (period > 0.0f) {
+            if (d > 0.5f * period) d -= period;
+            else if (d < -0.5f * period) d += period;
+        }
+        if (fabsf(d) >= reach) return 1;  // ni las cajas se tocan
+        d2 += d * d;
+    }
+    if (d2 >= reach * reach) return 1;
+    if (sp->pairCount == sp->pairCapacity && !grow_pairs(sp)) return 0;
+    sp->pairs[sp->pairCount].i = i < j ? i : j;
+    sp->pairs[sp->pairCount].j = i < j ? j : i;
+    sp->pairCount++;
+    return 1;
+}
+
+int sweep_find_pairs(SweepPrune* sp, const Particles* p, int count, float margin,
+                     float origin, float period, const unsigned char* frozen,
+                     TaskPool* pool) {
+    sp->pairCount = 0;
+    if (count <= 0) {
+        sp->count = 0;
+        return 0;
+    }
+    if (!reserve_sweep(sp, count)) return -1;
+
+    // 1) Orden por borde inferior: el del paso anterior arreglado, o uno
+    //    nuevo si no sirve
+    int axis = choose_axis(sp, p, count);
+    int sorted = 0;
+    if (sp->count == count && sp->axis == axis)
+        sorted = refresh_order(sp, p, count, axis, origin, period);
+    if (!sorted) {
+        if (!radix_order(sp, p, count, axis, origin, period, pool)) {
+            sp->count = 0;
+            return -1;
+        }
+        sp->resets++;
+    }
+    sp->axis = axis;
+    sp->count = count;
+
+    // Copia en orden: el barrido lee memoria contigua
+    for (int k = 0; k < count; k++) {
+        const Particles* q = &p[sp->order[k]];
+        sp->sorted[k][0] = q->current[0];
+        sp->sorted[k][1] = q->current[1];
+        sp->sorted[k][2] = q->current[2];
+        sp->sorted[k][3] = q->radius;
+    }
+
+    // 2) Barrido: cada intervalo contra los que empiezan antes de que
+    //    termine. En el dominio periódico los que se pasan del borde
+    //    superior siguen desde el principio del orden, un período más allá.
+    for (int a = 0; a < count; a++) {
+        float hi = sp->lo[a] + 2.0f * sp->sorted[a][3] + margin;
+        for (int b = a + 1; b < count && sp->lo[b] <= hi; b++)
+            if (!try_pair(sp, a, b, margin, period, frozen)) return -1;
+        if (period <= 0.0f) continue;
+        float wrapped = hi - period;
+        for (int b = 0; b < a && sp->lo[b] <= wrapped; b++) {
+            // si también se tocan sin dar la vuelta el par ya salió
+            if (sp->lo[a] <= sp->lo[b] + 2.0f * sp->sorted[b][3] + margin) continue;
+            if (!try_pair(sp, a, b, margin, period, frozen)) return -1;
+        }
+    }
+    return sp->pairCount;
+}
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200809L  // sched_yield
+#include "physics/tasks.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    TaskFn fn;
+    void*  arg;
+    int    index;
+    int    pending;    // dependencias sin terminar (atómico mientras corre)
+    int    firstEdge;  // lista de las que esperan a esta
+} Task;
+
+typedef struct {
+    int to;
+    int next;
+} TaskEdge;
+
+// Cola de un hilo: el dueño empuja y saca del fondo, los demás roban del
+// frente. Cada tarea entra una sola vez por corrida, así que con lugar
+// para todas los índices nunca dan la vuelta.
+typedef struct {
+    pthread_mutex_t lock;
+    int* items;
+    int  top;
+    int  bottom;
+} TaskDeque;
+
+struct TaskPool {
+    pthread_t threads[TASK_MAX_THREADS];
+    int threadCount;
+    TaskDeque deques[TASK_MAX_THREADS + 1];  // la última es del que llama
+    int dequeCapacity;
+
+    Task* tasks;
+    int taskCount;
+    int taskCapacity;
+    TaskEdge* edges;
+    int edgeCount;
+    int edgeCapacity;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;       // arrancó una corrida o hay que salir
+    pthread_cond_t idle;       // el último hilo dejó la corrida
+    unsigned int generation;   // corridas arrancadas
+    int busy;                  // hilos adentro de una corrida
+    int quit;
+    int remaining;             // tareas sin terminar (atómico)
+};
+
+static void deque_push(TaskDeque* d, int task) {
+    pthread_mutex_lock(&d->lock);
+    d->items[d->bottom++] = task;
+    pthread_mutex_unlock(&d->lock);
+}
+
+static int deque_pop(TaskDeque* d) {
+    int task = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) task = d->items[--d->bottom];
+    pthread_mutex_unlock(&d->lock);
+    return task;
+}
+
+static int deque_steal(TaskDeque* d) {
+    int task = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) task = d->items[d->top++];
+    pthread_mutex_unlock(&d->lock);
+    return task;
+}
+
+// Corre tareas hasta que no queda ninguna. La que termina libera a las que
+// la esperaban y las pone en la cola propia.
+static void run_tasks(TaskPool* pool, int self) {
+    const int queues = pool->threadCount + 1;
+    while (__atomic_load_n(&pool->remaining, __ATOMIC_ACQUIRE) > 0) {
+        int t = deque_pop(&pool->deques[self]);
+        for (int k = 1; t < 0 && k < queues; k++)
+            t = deque_steal(&pool->deques[(self + k) % queues]);
+        if (t < 0) {
+            sched_yield();
+            continue;
+        }
+        Task* task = &pool->tasks[t];
+        task->fn(task->arg, task->index);
+        for (int e = task->firstEdge; e >= 0; e = pool->edges[e].next) {
+            int to = pool->edges[e].to;
+            if (__atomic_sub_fetch(&pool->tasks[to].pending, 1, __ATOMIC_ACQ_REL) == 0)
+                deque_push(&pool->deques[self], to);
+        }
+        __atomic_sub_fetch(&pool->remaining, 1, __ATOMIC_ACQ_REL);
+    }
+}
+
+typedef struct {
+    TaskPool* pool;
+    int rank;
+} TaskWorker;
+
+static void* worker_main(void* data) {
+    TaskPool* pool = ((TaskWorker*)data)->pool;
+    int rank = ((TaskWorker*)data)->rank;
+    free(data);
+
+    unsigned int seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->quit)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->quit) break;
+        seen = pool->generation;
+        pool->busy++;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_tasks(pool, rank);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void stop_threads(TaskPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->threadCount; t++)
+        pthread_join(pool->threads[t], NULL);
+    pool->threadCount = 0;
+}
+
+TaskPool* task_pool_create(int threads) {
+    if (threads < 0 || threads > TASK_MAX_THREADS) {
+        fprintf(stderr, "Task threads must be in [0, %d]\n", TASK_MAX_THREADS);
+        return NULL;
+    }
+    TaskPool* pool = calloc(1, sizeof(TaskPool));
+    if (!pool) {
+        fprintf(stderr, "Failed to alloc task pool\n");
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    for (int q = 0; q <= TASK_MAX_THREADS; q++)
+        pthread_mutex_init(&pool->deques[q].lock, NULL);
+
+    for (int t = 0; t < threads; t++) {
+        TaskWorker* worker = malloc(sizeof(TaskWorker));
+        if (worker) {
+            worker->pool = pool;
+            worker->rank = t;
+        }
+        if (!worker || pthread_create(&pool->threads[t], NULL, worker_main, worker) != 0) {
+            fprintf(stderr, "Failed to start task thread %d\n", t);
+            free(worker);
+            pool->threadCount = t;
+            task_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->threadCount = threads;
+    return pool;
+}
+
+void task_pool_destroy(TaskPool* pool) {
+    if (!pool) return;
+    stop_threads(pool);
+    for (int q = 0; q <= TASK_MAX_THREADS; q++) {
+        pthread_mutex_destroy(&pool->deques[q].lock);
+        free(pool->deques[q].items);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->tasks);
+    free(pool->edges);
+    free(pool);
+}
+
+int task_pool_threads(const TaskPool* pool) {
+    return pool->threadCount;
+}
+
+int task_add(TaskPool* pool, TaskFn fn, void* arg, int index) {
+    if (pool->taskCount == pool->taskCapacity) {
+        int capacity = pool->taskCapacity > 0 ? pool->taskCapacity * 2 : 256;
+        Task* grown = realloc(pool->tasks, capacity * sizeof(Task));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc tasks\n");
+            return -1;
+        }
+        pool->tasks = grown;
+        pool->taskCapacity = capacity;
+    }
+    Task* task = &pool->tasks[pool->taskCount];
+    task->fn = fn;
+    task->arg = arg;
+    task->index = index;
+    task->pending = 0;
+    task->firstEdge = -1;
+    return pool->taskCount++;
+}
+
+int task_depend(TaskPool* pool, int task, int before) {
+    if (before < 0 || task <= before || task >= pool->taskCount) {
+        fprintf(stderr, "Task %d cannot depend on task %d\n", task, before);
+        return 0;
+    }
+    if (pool->edgeCount == pool->edgeCapacity) {
+        int capacity = pool->edgeCapacity > 0 ? pool->edgeCapacity * 2 : 512;
+        TaskEdge* grown = realloc(pool->edges, capacity * sizeof(TaskEdge));
+        if (!grown) {
+            fprintf(stderr, "Failed to alloc task edges\n");
+            return 0;
+        }
+        pool->edges = grown;
+        pool->edgeCapacity = capacity;
+    }
+    TaskEdge* edge = &pool->edges[pool->edgeCount];
+    edge->to = task;
+    edge->next = pool->tasks[before].firstEdge;
+    pool->tasks[before].firstEdge = pool->edgeCount++;
+    pool->tasks[task].pending++;
+    return 1;
+}
+
+void task_pool_clear(TaskPool* pool) {
+    pool->taskCount = 0;
+    pool->edgeCount = 0;
+}
+
+void task_pool_run(TaskPool* pool) {
+    const int queues = pool->threadCount + 1;
+    const int n = pool->taskCount;
+    if (n == 0) return;
+
+    pthread_mutex_lock(&pool->lock);
+    // un hilo que despertó tarde todavía puede estar saliendo de la
+    // corrida anterior
+    while (pool->busy > 0)
+        pthread_cond_wait(&pool->idle, &pool->lock);
+
+    int ok = 1;
+    if (n > pool->dequeCapacity) {
+        for (int q = 0; q < queues; q++) {
+            int* grown = realloc(pool->deques[q].items, n * sizeof(int));
+            if (grown) pool->deques[q].items = grown;
+            ok = ok && grown;
+        }
+        if (ok) pool->dequeCapacity = n;
+    }
+    for (int q = 0; q < queues; q++)
+        pool->deques[q].top = pool->deques[q].bottom = 0;
+
+    if (!ok || pool->threadCount == 0) {
+        // sin hilos (o sin memoria para las colas) se corre en orden: con
+        // dependencias de ids menores a mayores es un orden válido
+        pthread_mutex_unlock(&pool->lock);
+        if (!ok) fprintf(stderr, "Failed to alloc task queues; running tasks in order\n");
+        for (int t = 0; t < n; t++) pool->tasks[t].fn(pool->tasks[t].arg, pool->tasks[t].index);
+        task_pool_clear(pool);
+        return;
+    }
+
+    // Las que no esperan a nadie se reparten en orden inverso: cada hilo
+    // saca primero la de id menor
+    int roots = 0;
+    for (int t = n - 1; t >= 0; t--)
+        if (pool->tasks[t].pending == 0) {
+            TaskDeque* d = &pool->deques[roots++ % queues];
+            d->items[d->bottom++] = t;
+        }
+    pool->remaining = n;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool, pool->threadCount);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0)
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+    task_pool_clear(pool);
+}
@@ -0,0 +1,1368 @@
+#include "physics/verify.h"
+#include "physics/physics.h"
+#include "physics/env.h"
+#include "physics/grid.h"
+#include "physics/kernels.h"
+#include "physics/compact.h"
+#include "physics/sweep.h"
+#include "physics/constraints.h"
+#include "physics/shape.h"
+#include "physics/gravity.h"
+#include "physics/ensemble.h"
+#include "physics/sim.h"
+#include "physics/planar.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VERIFY_PADDING 1e-3f  // igual que CONTACT_PADDING del solver
+
+static int failures = 0;
+static int checks = 0;
+
+static void report(int ok, const char* check, const char* variant, int scene, const char* detail) {
+    checks++;
+    if (ok) return;
+    failures++;
+    printf("FAIL %-18s %-8s scene %d: %s\n", check, variant, scene, detail);
+}
+
+static inline float random_range(float lo, float hi) {
+    return lo + (hi - lo) * ((float)rand() / RAND_MAX);
+}
+
+// --------------------------------------------------------- referencia
+
+// Versiones escalares de lo que hoy corre en kernels.c
+static void reference_collide(const Config* cfg, Particles* p, int count) {
+    if (cfg->ENV_TYPE == ENV_BOX) {
+        const float L = cfg->ENV_SIZE;
+        for (int k = 0; k < count; k++) {
+            float min = -L + p[k].radius;
+            float max =  L - p[k].radius;
+            for (int i = 0; i < 3; ++i) {
+                float disp = p[k].current[i] - p[k].previus[i];
+                float clamped = fminf(fmaxf(p[k].current[i], min), max);
+                if (clamped != p[k].current[i]) {
+                    p[k].current[i] = clamped;
+                    p[k].previus[i] = clamped + disp;
+                }
+            }
+        }
+    } else if (cfg->ENV_TYPE == ENV_SPHERE) {
+        const float env_radius = 2.0f * cfg->ENV_SIZE;
+        for (int k = 0; k < count; k++) {
+            float max_dist = env_radius - p[k].radius;
+            float dist2 = glm_vec3_norm2(p[k].current);
+            if (dist2 <= max_dist * max_dist) continue;
+            vec3 normal, velocity;
+            glm_vec3_scale(p[k].current, 1.0f / sqrtf(dist2), normal);
+            glm_vec3_sub(p[k].current, p[k].previus, velocity);
+            glm_vec3_scale(normal, max_dist, p[k].current);
+            float v_dot_n = glm_vec3_dot(velocity, normal);
+            glm_vec3_muladds(normal, -2.0f * v_dot_n, velocity);
+            glm_vec3_scale(velocity, 0.9f, velocity);
+            glm_vec3_sub(p[k].current, velocity, p[k].previus);
+        }
+    } else {
+        collide_periodic(cfg, p, count);
+    }
+}
+
+static inline void reference_image(vec3 diff, float period) {
+    if (period <= 0.0f) return;
+    for (int a = 0; a < 3; a++)
+        diff[a] -= period * floorf(diff[a] / period + 0.5f);
+}
+
+static float reference_contact(Particles* p, int i, int j, float restitution, float period) {
+    vec3 diff;
+    glm_vec3_sub(p[j].current, p[i].current, diff);
+    reference_image(diff, period);
+    float dist = glm_vec3_norm(diff);
+    float minDist = p[i].radius + p[j].radius;
+    if (dist <= 0.0f || dist >= minDist + VERIFY_PADDING) return 0.0f;
+
+    // masa proporcional a r³
+    float mi = p[i].radius * p[i].radius * p[i].radius;
+    float mj = p[j].radius * p[j].radius * p[j].radius;
+    float share = mj / (mi + mj);
+    float overlap = minDist + VERIFY_PADDING - dist;
+    vec3 normal, correction;
+    glm_vec3_divs(diff, dist, normal);
+    glm_vec3_scale(normal, overlap * share, correction);
+    glm_vec3_sub(p[i].current, correction, p[i].current);
+    glm_vec3_scale(normal, overlap * (1.0f - share), correction);
+    glm_vec3_add(p[j].current, correction, p[j].current);
+
+    vec3 relVel;
+    glm_vec3_sub(p[j].previus, p[i].previus, relVel);
+    reference_image(relVel, period);
+    float vRel = glm_vec3_dot(relVel, normal);
+    if (vRel <= 0.0f) {
+        float jImpulse = -(1.0f + restitution) * vRel;
+        vec3 impulse;
+        glm_vec3_scale(normal, jImpulse * share, impulse);
+        glm_vec3_sub(p[i].previus, impulse, p[i].previus);
+        glm_vec3_scale(normal, jImpulse * (1.0f - share), impulse);
+        glm_vec3_add(p[j].previus, impulse, p[j].previus);
+    }
+    return minDist - dist > 0.0f ? minDist - dist : 0.0f;
+}
+
+// Todos contra todos, en orden de índice, con el mismo corte por tolerancia
+static void reference_resolve(const Config* cfg, Particles* p, int count, float period) {
+    int maxIterations = cfg->SOLVER_ITERATIONS > 0 ? (int)cfg->SOLVER_ITERATIONS : 1;
+    for (int it = 0; it < maxIterations; it++) {
+        float maxPenetration = 0.0f;
+        for (int i = 0; i < count; i++)
+            for (int j = i + 1; j < count; j++) {
+                float pen = reference_contact(p, i, j, cfg->RESTITUTION, period);
+                if (pen > maxPenetration) maxPenetration = pen;
+            }
+        if (maxPenetration <= cfg->SOLVER_TOLERANCE) break;
+    }
+}
+
+static float max_penetration(const Particles* p, int count, float period) {
+    float worst = 0.0f;
+    for (int i = 0; i < count; i++)
+        for (int j = i + 1; j < count; j++) {
+            vec3 diff;
+            glm_vec3_sub((float*)p[j].current, (float*)p[i].current, diff);
+            reference_image(diff, period);
+            float pen = p[i].radius + p[j].radius - glm_vec3_norm(diff);
+            if (pen > worst) worst = pen;
+        }
+    return worst;
+}
+
+// ------------------------------------------------------------- escenas
+
+// Escena aleatoria con solapamientos leves (hasta 10% de los radios) para
+// que el solver converja y el orden de los pares no domine el resultado
+static int make_scene(Config* cfg, Particles** p, int scene) {
+    static const int envs[] = { ENV_BOX, ENV_SPHERE, ENV_PERIODIC };
+    cfg->ENV_TYPE = envs[scene % 3];
+    cfg->PARTICLE_RADIUS = random_range(0.05f, 0.15f);
+    cfg->WARM_START = 0.0f;
+    int target = 500 + rand() % 2500;
+    float period = 0.0f;
+
+    *p = malloc(target * sizeof(Particles));
+    if (!*p) return 0;
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (env->periodic) {
+        vec3 min, max;
+        env->bounds(cfg, min, max);
+        period = max[0] - min[0];
+    }
+    int count = 0;
+    for (int tries = 0; count < target && tries < 50 * target; tries++) {
+        Particles* q = &(*p)[count];
+        env->spawn(cfg, q->current);
+        q->radius = cfg->PARTICLE_RADIUS * random_range(0.8f, 1.0f);
+        int free = 1;
+        for (int j = 0; j < count && free; j++) {
+            vec3 diff;
+            glm_vec3_sub((*p)[j].current, q->current, diff);
+            reference_image(diff, period);
+            float minDist = 0.9f * (q->radius + (*p)[j].radius);
+            free = glm_vec3_norm2(diff) >= minDist * minDist;
+        }
+        if (!free) continue;
+        // velocidad aleatoria para que haya rebotes y cruces de borde
+        for (int a = 0; a < 3; a++)
+            q->previus[a] = q->current[a] - random_range(-0.02f, 0.02f);
+        count++;
+    }
+    return count;
+}
+
+static float scene_period(const Config* cfg) {
+    const EnvInterface* env = env_get(cfg->ENV_TYPE);
+    if (!env->periodic) return 0.0f;
+    vec3 min, max;
+    env->bounds(cfg, min, max);
+    return max[0] - min[0];
+}
+
+static float max_difference(const Particles* a, const Particles* b, int count) {
+    float worst = 0.0f;
+    for (int i = 0; i < count; i++)
+        for (int k = 0; k < 3; k++) {
+            worst = fmaxf(worst, fabsf(a[i].current[k] - b[i].current[k]));
+            worst = fmaxf(worst, fabsf(a[i].previus[k] - b[i].previus[k]));
+        }
+    return worst;
+}
+
+// ----------------------------------------------------- chequeos por kernel
+
+static void verify_kernels(const Config* cfg, const Particles* scene, int count,
+                           const PhysicsKernels* k, int id, Particles* a, Particles* b) {
+    char detail[128];
+    const float dt = 1.0f / 60.0f;
+    size_t bytes = count * sizeof(Particles);
+
+    // Integración: misma cuenta que update_physics, bit a bit
+    memcpy(a, scene, bytes);
+    memcpy(b, scene, bytes);
+    k->integrate_uniform(cfg->ACCELERATION, a, count, dt);
+    for (int i = 0; i < count; i++) update_physics(cfg->ACCELERATION, &b[i], dt);
+    report(memcmp(a, b, bytes) == 0, "integrate_uniform", k->name, id, "differs from update_physics");
+
+    // Entorno: bit a bit contra la versión escalar
+    if (cfg->ENV_TYPE == ENV_BOX) k->collide_box(cfg->ENV_SIZE, a, count);
+    else if (cfg->ENV_TYPE == ENV_SPHERE) k->collide_sphere(2.0f * cfg->ENV_SIZE, a, count);
+    else collide_periodic(cfg, a, count);
+    reference_collide(cfg, b, count);
+    report(memcmp(a, b, bytes) == 0, "collide", k->name, id, "differs from scalar collision");
+
+    // Celdas: iguales a get_cell_coords
+    grid_setup(cfg, a, count);
+    int (*cells)[3] = malloc(count * sizeof(*cells));
+    if (cells) {
+        k->cell_coords(&grid, a, count, cells);
+        int bad = 0;
+        for (int i = 0; i < count; i++) {
+            int c[3];
+            get_cell_coords(a[i].current, &c[0], &c[1], &c[2]);
+            bad += c[0] != cells[i][0] || c[1] != cells[i][1] || c[2] != cells[i][2];
+        }
+        snprintf(detail, sizeof(detail), "%d particles in a different cell", bad);
+        report(bad == 0, "cell_coords", k->name, id, detail);
+        free(cells);
+    }
+
+    // Filtro de contactos: debe dejar pasar todo par que se toca
+    float period = scene_period(cfg);
+    int candidates[MAX_BUCKET_SIZE], hits[MAX_BUCKET_SIZE];
+    int missed = 0, bogus = 0;
+    for (int i = 0; i < count; i += 7) {
+        for (int first = 0; first < count; first += MAX_BUCKET_SIZE) {
+            int n = count - first < MAX_BUCKET_SIZE ? count - first : MAX_BUCKET_SIZE;
+            for (int c = 0; c < n; c++) candidates[c] = first + c;
+            int m = k->contact_filter(a, i, candidates, n, VERIFY_PADDING, period, hits);
+            int h = 0;
+            for (int c = 0; c < n; c++) {
+                int j = candidates[c];
+                vec3 diff;
+                glm_vec3_sub(a[j].current, a[i].current, diff);
+                reference_image(diff, period);
+                float dist = glm_vec3_norm(diff);
+                int touches = dist > 0.0f && dist < a[i].radius + a[j].radius + VERIFY_PADDING;
+                int passed = h < m && hits[h] == j;
+                if (passed) h++;
+                missed += touches && !passed;
+            }
+            bogus += m - h;  // salidas que no eran candidatos en orden
+        }
+    }
+    snprintf(detail, sizeof(detail), "%d touching pairs dropped, %d bad outputs", missed, bogus);
+    report(missed == 0 && bogus == 0, "contact_filter", k->name, id, detail);
+
+    // Lo mismo en arreglos separados, con rangos que no son múltiplo del
+    // bloque y el relleno que piden contact_batch y gravity_batch
+    const int stride = count + CONTACT_BATCH + GRAVITY_BATCH;
+    size_t floats = stride * sizeof(float);
+    float* soa = malloc(4 * floats);
+    int* out = malloc((count + CONTACT_BATCH) * sizeof(int));
+    if (soa && out) {
+        float* x = soa;
+        float* y = x + stride;
+        float* z = y + stride;
+        float* r = z + stride;
+        memset(soa, 0, 4 * floats);
+        for (int j = 0; j < count; j++) {
+            x[j] = a[j].current[0];
+            y[j] = a[j].current[1];
+            z[j] = a[j].current[2];
+            r[j] = a[j].radius;
+        }
+        missed = bogus = 0;
+        for (int i = 0; i < count; i += 7) {
+            int lo = (i * 13) % count, hi = lo + (i * 29) % (count - lo + 1);
+            int m = k->contact_batch(x, y, z, r, lo, hi, a[i].current,
+                                     a[i].radius + VERIFY_PADDING, period, out);
+            int h = 0;
+            for (int j = lo; j < hi; j++) {
+                vec3 diff;
+                glm_vec3_sub(a[j].current, a[i].current, diff);
+                reference_image(diff, period);
+                float dist = glm_vec3_norm(diff);
+                int touches = dist > 0.0f && dist < a[i].radius + a[j].radius + VERIFY_PADDING;
+                int passed = h < m && out[h] == j;
+                if (passed) h++;
+                missed += touches && !passed;
+            }
+            bogus += m - h;
+        }
+        snprintf(detail, sizeof(detail), "%d touching pairs dropped, %d bad outputs", missed, bogus);
+        report(missed == 0 && bogus == 0, "contact_batch", k->name, id, detail);
+
+        // Gravedad con el radio como masa, contra la suma en double; el
+        // relleno en cero completa el último bloque. Sin suavizado la
+        // propia partícula no aporta.
+        double worst = 0.0;
+        for (int i = 0; i < count; i += 7) {
+            const float soft2 = i % 2 ? 0.0f : 4.0f * cfg->PARTICLE_RADIUS * cfg->PARTICLE_RADIUS;
+            float acc[3] = { 0.0f, 0.0f, 0.0f };
+            double ref[3] = { 0.0, 0.0, 0.0 }, norm = 0.0, err = 0.0;
+            k->gravity_batch(x, y, z, r, count, a[i].current, soft2, acc);
+            for (int j = 0; j < count; j++) {
+                double d[3] = { x[j] - a[i].current[0], y[j] - a[i].current[1], z[j] - a[i].current[2] };
+                double d2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2] + soft2;
+                for (int c = 0; c < 3 && d2 > 0.0; c++) ref[c] += r[j] * d[c] / (d2 * sqrt(d2));
+            }
+            for (int c = 0; c < 3; c++) {
+                norm += ref[c] * ref[c];
+                err += (acc[c] - ref[c]) * (acc[c] - ref[c]);
+            }
+            if (!isfinite(err)) worst = INFINITY;
+            else if (norm > 0.0 && sqrt(err / norm) > worst) worst = sqrt(err / norm);
+        }
+        snprintf(detail, sizeof(detail), "relative error %g", worst);
+        report(worst < 1e-3, "gravity_batch", k->name, id, detail);
+    }
+    free(soa);
+    free(out);
+}
+
+// Un paso completo del pipeline optimizado contra la referencia escalar.
+// El orden de los pares cambia, así que se pide cercanía y que el
+// resultado quede igual de bien resuelto.
+static void verify_step(Config* cfg, const Particles* scene, int count, int id,
+                        const char* variant, Particles* a, Particles* b) {
+    char detail[160];
+    const float dt = 1.0f / 60.0f;
+    float period = scene_period(cfg);
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_from_config(&forces, cfg);
+    ContactCache contacts;
+    memset(&contacts, 0, sizeof(contacts));
+
+    memcpy(a, scene, count * sizeof(Particles));
+    memcpy(b, scene, count * sizeof(Particles));
+    integrate_particles(cfg, &forces, a, count, dt);
+    resolve_collisions_cached(cfg, a, count, &contacts);
+    for (int i = 0; i < count; i++) update_physics(cfg->ACCELERATION, &b[i], dt);
+    reference_collide(cfg, b, count);
+    reference_resolve(cfg, b, count, period);
+    contact_cache_free(&contacts);
+
+    float diff = max_difference(a, b, count);
+    float penA = max_penetration(a, count, period);
+    float penB = max_penetration(b, count, period);
+    float tolerance = 0.25f * cfg->PARTICLE_RADIUS;
+    snprintf(detail, sizeof(detail), "max diff %g (tol %g), penetration %g vs reference %g",
+             diff, tolerance, penA, penB);
+    int ok = diff <= tolerance &&
+             penA <= fmaxf(2.0f * penB, cfg->SOLVER_TOLERANCE + 0.01f * cfg->PARTICLE_RADIUS);
+    report(ok, "step", variant, id, detail);
+    if (ok) printf("  step %-8s %s\n", variant, detail);
+}
+
+// Modo determinista: cada variante de ISA contra la genérica, bit a bit
+static void verify_deterministic(Config* cfg, const Particles* scene, int count, int id,
+                                 int steps, Particles* a, Particles* b) {
+    const PhysicsKernels* generic = physics_kernels_get(physics_kernels_count() - 1);
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_from_config(&forces, cfg);
+
+    for (int v = 0; v < physics_kernels_count() - 1; v++) {
+        const PhysicsKernels* k = physics_kernels_get(v);
+        ContactCache ca, cb;
+        memset(&ca, 0, sizeof(ca));
+        memset(&cb, 0, sizeof(cb));
+        memcpy(a, scene, count * sizeof(Particles));
+        memcpy(b, scene, count * sizeof(Particles));
+        int diverged = -1;
+        for (int s = 0; s < steps && diverged < 0; s++) {
+            physicsKernels = k;
+            integrate_particles(cfg, &forces, a, count, 1.0f / 60.0f);
+            resolve_collisions_cached(cfg, a, count, &ca);
+            physicsKernels = generic;
+            integrate_particles(cfg, &forces, b, count, 1.0f / 60.0f);
+            resolve_collisions_cached(cfg, b, count, &cb);
+            if (memcmp(a, b, count * sizeof(Particles)) != 0) diverged = s;
+        }
+        char detail[96];
+        snprintf(detail, sizeof(detail), "diverged from generic at step %d (max diff %g)",
+                 diverged, max_difference(a, b, count));
+        report(diverged < 0, "deterministic", k->name, id, detail);
+        contact_cache_free(&ca);
+        contact_cache_free(&cb);
+    }
+}
+
+// Grafo de tareas: con bloques chicos y varios hilos, bit a bit igual al
+// paso de un solo hilo, con y sin warm start
+static void verify_tasks(Config* cfg, const Particles* scene, int count, int id,
+                         int steps, TaskPool* pool, Particles* a, Particles* b) {
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_from_config(&forces, cfg);
+    static const float warm[] = { 0.0f, 0.8f };
+
+    for (int w = 0; w < 2; w++) {
+        Config c = *cfg;
+        c.WARM_START = warm[w];
+        ContactCache ca, cb;
+        memset(&ca, 0, sizeof(ca));
+        memset(&cb, 0, sizeof(cb));
+        memcpy(a, scene, count * sizeof(Particles));
+        memcpy(b, scene, count * sizeof(Particles));
+        int diverged = -1;
+        for (int s = 0; s < steps && diverged < 0; s++) {
+            integrate_and_resolve(&c, &forces, a, count, 1.0f / 60.0f, &ca, pool, 97);
+            integrate_particles(&c, &forces, b, count, 1.0f / 60.0f);
+            resolve_collisions_cached(&c, b, count, &cb);
+            if (memcmp(a, b, count * sizeof(Particles)) != 0) diverged = s;
+        }
+        char detail[96];
+        snprintf(detail, sizeof(detail), "diverged from one thread at step %d (max diff %g)",
+                 diverged, max_difference(a, b, count));
+        report(diverged < 0, "tasks", w ? "warm" : "cold", id, detail);
+        contact_cache_free(&ca);
+        contact_cache_free(&cb);
+    }
+}
+
+// Formato compacto: ida y vuelta de la escena dentro del error de
+// cuantización, y steps pasos recuantizando el estado después de cada uno
+// contra el camino en float. Las trayectorias se separan (la dinámica es
+// caótica), así que se comparan la altura media, la energía y la
+// penetración.
+static float mean_height(const Particles* p, int count) {
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += p[i].current[1];
+    return count > 0 ? (float)(sum / count) : 0.0f;
+}
+
+static double kinetic_energy(const Particles* p, int count) {
+    double e = 0.0;
+    for (int i = 0; i < count; i++) {
+        vec3 step;
+        glm_vec3_sub((float*)p[i].current, (float*)p[i].previus, step);
+        double r = p[i].radius;
+        e += r * r * r * glm_vec3_norm2(step);
+    }
+    return e;
+}
+
+// Ruido del tamaño del redondeo del formato compacto: hasta medio quantum
+// en la posición y media unidad del half float (10 bits de mantisa, 2^-24
+// en los subnormales) en el desplazamiento
+static float noise_unit(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state >> 8) * (1.0f / 16777216.0f) - 0.5f;
+}
+
+static void perturb_rounding(Particles* p, int count, float quantum, uint32_t* state) {
+    for (int i = 0; i < count; i++)
+        for (int k = 0; k < 3; k++) {
+            float step = p[i].current[k] - p[i].previus[k];
+            int e;
+            frexpf(step, &e);
+            float ulp = fmaxf(ldexpf(1.0f, e - 11), ldexpf(1.0f, -24));
+            p[i].current[k] += noise_unit(state) * quantum;
+            p[i].previus[k] = p[i].current[k] - (step + noise_unit(state) * ulp);
+        }
+}
+
+static void verify_compact(Config* cfg, const Particles* scene, int count, int id,
+                           int steps, Particles* a, Particles* b) {
+    char detail[160];
+    CompactFormat fmt;
+    CompactParticle* packed = malloc(count * sizeof(CompactParticle));
+    Particles* typed = malloc(count * sizeof(Particles));
+    if (!packed || !typed || !compact_format_init(&fmt, cfg)) {
+        report(0, "compact", "-", id, "could not build the compact format");
+        free(packed);
+        free(typed);
+        return;
+    }
+    // El formato guarda hasta COMPACT_MAX_TYPES radios: los de la escena
+    // (entre 0.8 y 1 del radio) se llevan a esa cantidad de valores
+    const int levels = COMPACT_MAX_TYPES;
+    memcpy(typed, scene, count * sizeof(Particles));
+    for (int i = 0; i < count; i++) {
+        float t = (typed[i].radius / cfg->PARTICLE_RADIUS - 0.8f) / 0.2f;
+        int level = (int)floorf(t * (levels - 1) + 0.5f);
+        if (level < 0) level = 0;
+        if (level > levels - 1) level = levels - 1;
+        typed[i].radius = cfg->PARTICLE_RADIUS * (0.8f + 0.2f * level / (levels - 1));
+    }
+    scene = typed;
+
+    int ok = compact_encode(&fmt, scene, count, packed);
+    compact_decode(&fmt, packed, count, b);
+    float posError = 0.0f, stepError = 0.0f;
+    for (int i = 0; i < count && ok; i++) {
+        for (int k = 0; k < 3; k++) {
+            float e = fabsf(b[i].current[k] - scene[i].current[k]);
+            if (e > posError) posError = e;
+            float step = scene[i].current[k] - scene[i].previus[k];
+            e = fabsf((b[i].current[k] - b[i].previus[k]) - step);
+            // half float: 11 bits de mantisa, más el error de la posición
+            if (e > fabsf(step) * (1.0f / 2048.0f) + 2.0f * posError + 1e-7f) ok = 0;
+            if (e / fmaxf(fabsf(step), 1e-7f) > stepError) stepError = e / fmaxf(fabsf(step), 1e-7f);
+        }
+        if (b[i].radius != scene[i].radius) ok = 0;
+    }
+    ok = ok && posError <= 2.0f * fmt.quantum + 1e-6f * cfg->PARTICLE_RADIUS;
+    snprintf(detail, sizeof(detail), "position error %g (quantum %g), step error %g relative",
+             posError, fmt.quantum, stepError);
+    report(ok, "compact_roundtrip", "-", id, detail);
+
+    // Controles: el mismo paso en float con ruido del tamaño del redondeo
+    // del formato. Las escenas caóticas se separan de la referencia lo
+    // mismo con el formato que con el ruido, así que la deriva del formato
+    // se mide contra la de los controles y no sólo contra el radio.
+    Particles* control[2];
+    control[0] = malloc(count * sizeof(Particles));
+    control[1] = malloc(count * sizeof(Particles));
+    ok = ok && control[0] && control[1];
+    ForceFieldSet forces;
+    memset(&forces, 0, sizeof(forces));
+    force_fields_from_config(&forces, cfg);
+    ContactCache ca, cb, cc[2];
+    memset(&ca, 0, sizeof(ca));
+    memset(&cb, 0, sizeof(cb));
+    memset(cc, 0, sizeof(cc));
+    memcpy(a, scene, count * sizeof(Particles));
+    memcpy(b, scene, count * sizeof(Particles));
+    for (int c = 0; c < 2 && ok; c++) memcpy(control[c], scene, count * sizeof(Particles));
+    uint32_t noise = 12345u + (uint32_t)id;
+    for (int s = 0; s < steps && ok; s++) {
+        integrate_particles(cfg, &forces, a, count, 1.0f / 60.0f);
+        resolve_collisions_cached(cfg, a, count, &ca);
+        integrate_particles(cfg, &forces, b, count, 1.0f / 60.0f);
+        resolve_collisions_cached(cfg, b, count, &cb);
+        ok = compact_encode(&fmt, b, count, packed);
+        compact_decode(&fmt, packed, count, b);
+        for (int c = 0; c < 2; c++) {
+            integrate_particles(cfg, &forces, control[c], count, 1.0f / 60.0f);
+            resolve_collisions_cached(cfg, control[c], count, &cc[c]);
+            perturb_rounding(control[c], count, fmt.quantum, &noise);
+        }
+    }
+    contact_cache_free(&ca);
+    contact_cache_free(&cb);
+    contact_cache_free(&cc[0]);
+    contact_cache_free(&cc[1]);
+
+    if (ok) {
+        float period = scene_period(cfg);
+        float drift = fabsf(mean_height(a, count) - mean_height(b, count));
+        float controlDrift = 0.0f, penControl = 0.0f;
+        double energyA = kinetic_energy(a, count), energyB = kinetic_energy(b, count);
+        double energyControl = 0.0;
+        for (int c = 0; c < 2; c++) {
+            controlDrift = fmaxf(controlDrift, fabsf(mean_height(a, count) - mean_height(control[c], count)));
+            penControl = fmaxf(penControl, max_penetration(control[c], count, period));
+            energyControl = fmax(energyControl, kinetic_energy(control[c], count));
+        }
+        double energyFloor = (double)count * powf(cfg->PARTICLE_RADIUS, 5.0f) * 1e-4;
+        float penA = fmaxf(max_penetration(a, count, period), penControl);
+        float penB = max_penetration(b, count, period);
+        snprintf(detail, sizeof(detail),
+                 "mean_y drift %g (noise %g), energy %g vs %g, penetration %g vs %g",
+                 drift, controlDrift, energyB, fmax(energyA, energyControl), penB, penA);
+        ok = drift <= fmaxf(0.25f * cfg->PARTICLE_RADIUS, 2.0f * controlDrift) &&
+             energyB <= 1.5 * fmax(energyA, energyControl) + energyFloor &&
+             penB <= fmaxf(2.0f * penA, cfg->SOLVER_TOLERANCE + 0.01f * cfg->PARTICLE_RADIUS);
+    } else {
+        snprintf(detail, sizeof(detail), "could not encode the run");
+    }
+    report(ok, "compact_stable", "-", id, detail);
+    if (ok) printf("  compact  %s\n", detail);
+    free(control[0]);
+    free(control[1]);
+    free(packed);
+    free(typed);
+}
+
+// Barrido y poda: cada par que se toca tiene que salir una sola vez, al
+// ordenar desde cero, al arreglar el orden del paso anterior y después de
+// mezclar todo. Después un paso completo con BROADPHASE = SWEEP contra la
+// referencia.
+static int compare_pair_keys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void check_sweep_pairs(const SweepPrune* sp, const Particles* p, int count, float period,
+                              int* missed, int* wrong) {
+    uint64_t* keys = malloc((sp->pairCount + 1) * sizeof(uint64_t));
+    if (!keys) {
+        (*wrong)++;
+        return;
+    }
+    for (int k = 0; k < sp->pairCount; k++)
+        keys[k] = ((uint64_t)(unsigned int)sp->pairs[k].i << 32) | (unsigned int)sp->pairs[k].j;
+    qsort(keys, sp->pairCount, sizeof(uint64_t), compare_pair_keys);
+    for (int k = 0; k < sp->pairCount; k++) {
+        int i = (int)(keys[k] >> 32), j = (int)(keys[k] & 0xffffffffu);
+        vec3 diff;
+        glm_vec3_sub((float*)p[j].current, (float*)p[i].current, diff);
+        reference_image(diff, period);
+        float reach = p[i].radius + p[j].radius + 2.0f * VERIFY_PADDING;
+        *wrong += (k > 0 && keys[k] == keys[k - 1]) || i >= j || glm_vec3_norm(diff) >= reach;
+    }
+    for (int i = 0; i < count; i++)
+        for (int j = i + 1; j < count; j++) {
+            vec3 diff;
+            glm_vec3_sub((float*)p[j].current, (float*)p[i].current, diff);
+            reference_image(diff, period);
+            if (glm_vec3_norm(diff) >= p[i].radius + p[j].radius) continue;
+            uint64_t key = ((uint64_t)(unsigned int)i << 32) | (unsigned int)j;
+            *missed += bsearch(&key, keys, sp->pairCount, sizeof(uint64_t), compare_pair_keys) == NULL;
+        }
+    free(keys);
+}
+
+// Consultas por lotes con hilos: lo mismo que de a una
+static void verify_queries(Config* cfg, const Particles* scene, int count, int id,
+                           TaskPool* pool, Particles* a) {
+    char detail[128];
+    const int queries = 1000, k = 8;
+    vec3* centers = malloc(queries * sizeof(vec3));
+    float* radii = malloc(queries * sizeof(float));
+    int* out = malloc((size_t)queries * k * sizeof(int));
+    float* dist2 = malloc((size_t)queries * k * sizeof(float));
+    int* counts = malloc(queries * sizeof(int));
+    if (!centers || !radii || !out || !dist2 || !counts) {
+        fprintf(stderr, "Failed to alloc query check\n");
+        free(centers);
+        free(radii);
+        free(out);
+        free(dist2);
+        free(counts);
+        return;
+    }
+    memcpy(a, scene, count * sizeof(Particles));
+    grid_setup(cfg, a, count);
+    grid_insert(a, count);
+    for (int q = 0; q < queries; q++) {
+        glm_vec3_copy(a[q % count].current, centers[q]);
+        radii[q] = 3.0f * cfg->PARTICLE_RADIUS;
+    }
+    int wrong = 0;
+    int single[8];
+    float singleDist[8];
+    physics_query_radius_batch(centers, radii, queries, out, k, counts, pool);
+    for (int q = 0; q < queries; q++) {
+        int n = physics_query_radius(centers[q], radii[q], single, k);
+        wrong += n != counts[q] ||
+                 memcmp(single, out + q * k, (n < k ? n : k) * sizeof(int)) != 0;
+    }
+    physics_query_knn_batch(centers, queries, k, out, dist2, counts, pool);
+    for (int q = 0; q < queries; q++) {
+        int n = physics_query_knn(centers[q], k, single, singleDist);
+        wrong += n != counts[q] || memcmp(single, out + q * k, n * sizeof(int)) != 0;
+    }
+    // rayos desde cada centro, hacia abajo y en abanico
+    vec3* dirs = (vec3*)dist2;
+    for (int q = 0; q < queries; q++) {
+        dirs[q][0] = sinf((float)q);
+        dirs[q][1] = -1.0f;
+        dirs[q][2] = cosf((float)q);
+    }
+    physics_raycast_batch(centers, dirs, queries, 10.0f * cfg->ENV_SIZE, counts, radii, pool);
+    for (int q = 0; q < queries; q++) {
+        float t = 0.0f;
+        int hit = physics_raycast(centers[q], dirs[q], 10.0f * cfg->ENV_SIZE, &t);
+        wrong += hit != counts[q] || (hit >= 0 && t != radii[q]);
+    }
+    snprintf(detail, sizeof(detail), "%d batch queries differ from single ones", wrong);
+    report(wrong == 0, "query_batch", "tasks", id, detail);
+
+    // Restaurar otras posiciones con la misma cantidad (como el historial)
+    // tiene que rearmar la grilla de la simulación: las partículas se
+    // corren un lugar y la que quedó en el centro de la 0 es la última
+    ParticleSim* sim = particle_sim_create(cfg, count);
+    if (sim) {
+        Particles* q = particle_sim_particles(sim);
+        memcpy(q, scene, count * sizeof(Particles));
+        particle_sim_set_count(sim, count);
+        particle_sim_query_radius(sim, scene[0].current, 0.5f * cfg->PARTICLE_RADIUS, single, 8);
+        for (int i = 0; i < count; i++) q[i] = scene[(i + 1) % count];
+        particle_sim_set_count(sim, count);
+        int n = particle_sim_query_radius(sim, scene[0].current, 0.5f * cfg->PARTICLE_RADIUS,
+                                          single, 8);
+        int found = 0;
+        for (int m = 0; m < n && m < 8; m++) found |= single[m] == count - 1;
+        snprintf(detail, sizeof(detail), "%d hits after a restore, moved particle %s",
+                 n, found ? "found" : "missed");
+        report(found, "query_restore", "-", id, detail);
+        particle_sim_destroy(sim);
+    }
+    free(centers);
+    free(radii);
+    free(out);
+    free(dist2);
+    free(counts);
+}
+
+static void verify_sweep(Config* cfg, const Particles* scene, int count, int id,
+                         Particles* a, Particles* b) {
+    char detail[128];
+    float period = scene_period(cfg);
+    vec3 min, max;
+    env_get(cfg->ENV_TYPE)->bounds(cfg, min, max);
+    SweepPrune sp;
+    memset(&sp, 0, sizeof(sp));
+    int missed = 0, wrong = 0;
+
+    memcpy(a, scene, count * sizeof(Particles));
+    for (int round = 0; round < 3; round++) {
+        if (round == 1) {
+            // movimiento chico: el orden se arregla con insertion sort
+            for (int i = 0; i < count; i++)
+                for (int k = 0; k < 3; k++)
+                    a[i].current[k] += random_range(-0.1f, 0.1f) * a[i].radius;
+        } else if (round == 2) {
+            // todo mezclado: hay que volver a ordenar desde cero
+            for (int i = 0; i < count; i++)
+                for (int k = 0; k < 3; k++)
+                    a[i].current[k] = random_range(min[k], max[k]);
+        }
+        if (sweep_find_pairs(&sp, a, count, VERIFY_PADDING, min[0], period, NULL, NULL) < 0) wrong++;
+        else check_sweep_pairs(&sp, a, count, period, &missed, &wrong);
+    }
+    snprintf(detail, sizeof(detail), "%d touching pairs missed, %d bad pairs, %d sorts from scratch",
+             missed, wrong, sp.resets);
+    report(missed == 0 && wrong == 0 && sp.resets == 2, "sweep_pairs", "-", id, detail);
+    sweep_free(&sp);
+
+    Config sweepConfig = *cfg;
+    sweepConfig.BROADPHASE = BROADPHASE_SWEEP;
+    verify_step(&sweepConfig, scene, count, id, "sweep", a, b);
+}
+
+// Desde SWEEP_PARALLEL_MIN el orden desde cero se reparte en el pool: el
+// radix sort es estable, así que tiene que dar el mismo orden y los mismos
+// pares que en serie
+static void verify_sweep_sort(TaskPool* pool) {
+    char detail[128];
+    const int count = SWEEP_PARALLEL_MIN + 4099;
+    Particles* p = malloc(count * sizeof(Particles));
+    SweepPrune sp[2];
+    memset(sp, 0, sizeof(sp));
+    if (!p) return;
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < 3; k++) p[i].current[k] = random_range(-4.0f, 4.0f);
+        glm_vec3_copy(p[i].current, p[i].previus);
+        p[i].radius = 0.01f;
+    }
+    int pairs[2];
+    for (int run = 0; run < 2; run++)
+        pairs[run] = sweep_find_pairs(&sp[run], p, count, VERIFY_PADDING, 0.0f, 0.0f, NULL,
+                                      run ? pool : NULL);
+    int differ = pairs[0] < 0 || pairs[0] != pairs[1];
+    for (int k = 0; k < count && !differ; k++) differ = sp[0].order[k] != sp[1].order[k];
+    for (int k = 0; k < pairs[0] && !differ; k++)
+        differ = sp[0].pairs[k].i != sp[1].pairs[k].i || sp[0].pairs[k].j != sp[1].pairs[k].j;
+    snprintf(detail, sizeof(detail), "%d particles, %d vs %d pairs, %s order",
+             count, pairs[0], pairs[1], differ ? "different" : "same");
+    report(!differ, "sweep_sort", "pool", -1, detail);
+    sweep_free(&sp[0]);
+    sweep_free(&sp[1]);
+    free(p);
+}
+
+// Una esfera grande (como un proxy) sólo está en el bucket de su centro:
+// un rayo que la cruza lejos de esa celda la tiene que encontrar igual
+static void verify_raycast_large(const Config* base) {
+    char detail[128];
+    Config cfg = *base;
+    cfg.ENV_TYPE = ENV_BOX;
+    const int n = 201;
+    const float r = 0.01f;
+    Particles* p = calloc(n, sizeof(Particles));
+    if (!p) return;
+    for (int i = 0; i < n - 1; i++) {
+        p[i].current[0] = random_range(-1.0f, 1.0f);
+        p[i].current[1] = random_range(-1.0f, 1.0f);
+        p[i].current[2] = random_range(0.5f, 1.0f);  // lejos del rayo
+        p[i].radius = r;
+    }
+    p[n - 1].radius = 20.0f * r;
+    for (int i = 0; i < n; i++) glm_vec3_copy(p[i].current, p[i].previus);
+    grid_setup(&cfg, p, n);
+    grid_insert(p, n);
+    // a 15 radios chicos del centro: siete celdas
+    float t = 0.0f;
+    int hit = physics_raycast((vec3){ -2.0f, 15.0f * r, 0.0f }, (vec3){ 1.0f, 0.0f, 0.0f },
+                              10.0f, &t);
+    snprintf(detail, sizeof(detail), "hit %d at %g, expected %d", hit, t, n - 1);
+    report(hit == n - 1, "raycast_large", "-", -1, detail);
+    grid_insert(NULL, 0);
+    free(p);
+}
+
+// Motor plano en el cuadrado, el círculo y el toro: la pasada de media
+// vecindad tiene que ver los mismos pares que la comparación de todos
+// contra todos, y después de steps pasos nadie sale del entorno
+static void verify_planar(const Config* base, int steps) {
+    char detail[128];
+    const int count = 1000, maxPairs = 1 << 16;
+    const EnvType envs[3] = { ENV_BOX, ENV_SPHERE, ENV_PERIODIC };
+    int (*pairs)[2] = malloc(maxPairs * sizeof(*pairs));
+    vec2* pos = malloc(count * sizeof(vec2));
+    unsigned char* seen = malloc((size_t)count * count / 8 + 1);
+    PlanarSim* sim = planar_create(count);
+    if (!pairs || !pos || !seen || !sim) {
+        fprintf(stderr, "Failed to alloc planar check\n");
+        free(pairs);
+        free(pos);
+        free(seen);
+        planar_destroy(sim);
+        return;
+    }
+    for (int e = 0; e < 3; e++) {
+        Config cfg = *base;
+        cfg.ENV_TYPE = envs[e];
+        cfg.ENV_SIZE = 1.0f;
+        cfg.PARTICLE_RADIUS = 0.02f;
+        const char* name = env_get(cfg.ENV_TYPE)->name;
+        vec3 min, max;
+        env_get(cfg.ENV_TYPE)->bounds(&cfg, min, max);
+        float period = envs[e] == ENV_PERIODIC ? max[0] - min[0] : 0.0f;
+
+        planar_set_count(sim, 0);
+        planar_spawn(sim, &cfg, count);
+        int found = planar_pairs(sim, &cfg, 0.0f, pairs, maxPairs);
+        planar_positions(sim, pos);
+        memset(seen, 0, (size_t)count * count / 8 + 1);
+        int repeated = 0, missed = 0, expected = 0;
+        for (int k = 0; k < found && k < maxPairs; k++) {
+            size_t bit = (size_t)pairs[k][0] * count + pairs[k][1];
+            if (pairs[k][0] > pairs[k][1]) bit = (size_t)pairs[k][1] * count + pairs[k][0];
+            repeated += (seen[bit / 8] >> (bit % 8)) & 1;
+            seen[bit / 8] |= 1 << (bit % 8);
+        }
+        float reach = 2.0f * cfg.PARTICLE_RADIUS;
+        for (int i = 0; i < count; i++)
+            for (int j = i + 1; j < count; j++) {
+                float d[2] = { pos[j][0] - pos[i][0], pos[j][1] - pos[i][1] };
+                for (int a = 0; a < 2 && period > 0.0f; a++)
+                    d[a] -= period * floorf(d[a] / period + 0.5f);
+                if (d[0] * d[0] + d[1] * d[1] >= reach * reach) continue;
+                expected++;
+                size_t bit = (size_t)i * count + j;
+                missed += !((seen[bit / 8] >> (bit % 8)) & 1);
+            }
+        snprintf(detail, sizeof(detail), "%d of %d overlapping pairs, %d missed, %d repeated",
+                 found, expected, missed, repeated);
+        report(found == expected && missed == 0 && repeated == 0 && found <= maxPairs,
+               "planar_pairs", name, -1, detail);
+
+        // cuánto asoma el borde de una partícula fuera del entorno (en el
+        // toro, el centro fuera del período)
+        ForceFieldSet forces;
+        memset(&forces, 0, sizeof(forces));
+        force_fields_from_config(&forces, &cfg);
+        for (int s = 0; s < steps; s++) planar_step(sim, &cfg, &forces, 1.0f / 60.0f);
+        planar_positions(sim, pos);
+        float r = cfg.PARTICLE_RADIUS, escape = -INFINITY;
+        for (int i = 0; i < count; i++) {
+            float out;
+            if (envs[e] == ENV_SPHERE)
+                out = sqrtf(pos[i][0] * pos[i][0] + pos[i][1] * pos[i][1]) + r - max[0];
+            else if (envs[e] == ENV_BOX)
+                out = fmaxf(fabsf(pos[i][0]), fabsf(pos[i][1])) + r - max[0];
+            else
+                out = fmaxf(fmaxf(min[0] - pos[i][0], pos[i][0] - max[0]),
+                            fmaxf(min[1] - pos[i][1], pos[i][1] - max[1]));
+            escape = fmaxf(escape, out);
+        }
+        snprintf(detail, sizeof(detail), "worst escape %g after %d steps", escape, steps);
+        report(escape <= 1e-5f, "planar_bounds", name, -1, detail);
+    }
+    free(pairs);
+    free(pos);
+    free(seen);
+    planar_destroy(sim);
+}
+
+// Restricciones de distancia: ningún color comparte partícula, una cadena
+// estirada vuelve a su largo y una tela colgada da lo mismo con hilos que
+// sin ellos
+static void verify_constraints(const Config* base, int steps) {
+    char detail[128];
+    const int links = 64;
+    Particles* chain = calloc(links, sizeof(Particles));
+    ConstraintSet set;
+    memset(&set, 0, sizeof(set));
+    if (!chain) return;
+    for (int i = 0; i < links; i++) {
+        chain[i].current[0] = 0.011f * i;  // 10% más larga que el reposo
+        chain[i].current[1] = 0.001f * (i % 3);
+        glm_vec3_copy(chain[i].current, chain[i].previus);
+        chain[i].radius = 0.005f;
+    }
+    int ok = 1;
+    for (int i = 0; i + 1 < links && ok; i++)
+        ok = constraint_add(&set, chain, links, i, i + 1, 0.01f, 1.0f);
+    for (int i = 0; i + 2 < links && ok; i++)
+        ok = constraint_add(&set, chain, links, i, i + 2, 0.02f, 1.0f);
+    ok = ok && constraint_solve(&set, chain, links, 2000, NULL);
+
+    int shared = 0;
+    unsigned char* seen = calloc(links, 1);
+    for (int c = 0; seen && c < set.colors; c++) {
+        memset(seen, 0, links);
+        for (int e = set.colorStart[c]; e < set.colorStart[c + 1]; e++) {
+            shared += seen[set.edges[e].a] || seen[set.edges[e].b];
+            seen[set.edges[e].a] = seen[set.edges[e].b] = 1;
+        }
+    }
+    free(seen);
+    float strain = constraint_max_strain(&set, chain);
+    snprintf(detail, sizeof(detail), "%d colors, %d edges share a particle, strain %g",
+             set.colors, shared, strain);
+    report(ok && shared == 0 && strain < 1e-3f, "constraints", "chain", -1, detail);
+    constraint_free(&set);
+    free(chain);
+
+    Config cfg = *base;
+    cfg.ENV_TYPE = ENV_BOX;
+    cfg.ENV_SIZE = 2.0f;
+    cfg.PARTICLE_RADIUS = 0.02f;
+    cfg.PROXY_FRAMES = 0;
+    cfg.MULTIRATE_LEVELS = 1;
+    cfg.EVENT_DRIVEN = 0;
+    Particles* result[2] = { NULL, NULL };
+    const int side = 90;
+    for (int run = 0; run < 2; run++) {
+        cfg.TASK_THREADS = run ? 3 : 0;
+        ParticleSim* sim = particle_sim_create(&cfg, side * side);
+        if (!sim) break;
+        int first = particle_sim_add_cloth(sim, (vec3){ -0.9f, 1.5f, -0.9f }, (vec3){ 1, 0, 0 },
+                                           (vec3){ 0, 0, 1 }, side, side, 0.045f, 1.0f, 1);
+        for (int s = 0; s < steps && first >= 0; s++) particle_sim_step(sim, 1.0f / 60.0f);
+        result[run] = malloc(side * side * sizeof(Particles));
+        if (result[run]) memcpy(result[run], particle_sim_particles(sim), side * side * sizeof(Particles));
+        particle_sim_destroy(sim);
+    }
+    if (result[0] && result[1]) {
+        float diff = max_difference(result[0], result[1], side * side);
+        snprintf(detail, sizeof(detail), "threads changed the cloth by %g", diff);
+        report(diff == 0.0f, "constraints", "cloth", -1, detail);
+    }
+    free(result[0]);
+    free(result[1]);
+
+    // Rebobinar a antes de la tela y volver (como el historial) no la
+    // desarma: la esquina fijada sigue en su lugar
+    cfg.TASK_THREADS = 0;
+    ParticleSim* sim = particle_sim_create(&cfg, side * side);
+    if (sim) {
+        int first = particle_sim_add_cloth(sim, (vec3){ -0.9f, 1.5f, -0.9f }, (vec3){ 1, 0, 0 },
+                                           (vec3){ 0, 0, 1 }, side, side, 0.045f, 1.0f, 1);
+        vec3 pin = { -0.9f, 1.5f, -0.9f };
+        particle_sim_set_count(sim, 0);
+        particle_sim_set_count(sim, side * side);
+        for (int s = 0; s < steps && first >= 0; s++) particle_sim_step(sim, 1.0f / 60.0f);
+        float moved = first >= 0 ? glm_vec3_distance(pin, particle_sim_particles(sim)[first].current) : -1.0f;
+        snprintf(detail, sizeof(detail), "pinned corner moved %g after a rewind", moved);
+        report(moved == 0.0f, "constraints", "rewind", -1, detail);
+        particle_sim_destroy(sim);
+    }
+
+    // Una arista que cruza el borde del dominio periódico une las imágenes
+    // más cercanas: no tira de las puntas a través de todo el dominio
+    cfg.ENV_TYPE = ENV_PERIODIC;
+    cfg.ACCELERATION[0] = cfg.ACCELERATION[1] = cfg.ACCELERATION[2] = 0.0f;
+    sim = particle_sim_create(&cfg, 2);
+    if (sim) {
+        vec3 min, max;
+        env_get(cfg.ENV_TYPE)->bounds(&cfg, min, max);
+        float period = max[0] - min[0];
+        Particles* q = particle_sim_particles(sim);
+        for (int i = 0; i < 2; i++) {
+            glm_vec3_zero(q[i].current);
+            q[i].current[0] = i ? max[0] - 0.03f : min[0] + 0.03f;
+            glm_vec3_copy(q[i].current, q[i].previus);
+            q[i].radius = cfg.PARTICLE_RADIUS;
+        }
+        particle_sim_set_count(sim, 2);
+        int ok = particle_sim_add_distance(sim, 0, 1, 0.05f, 1.0f);
+        for (int s = 0; s < steps && ok; s++) particle_sim_step(sim, 1.0f / 60.0f);
+        float gap = fabsf(q[1].current[0] - q[0].current[0]);
+        gap = fminf(gap, period - gap);
+        // cada punta se corre medio centímetro hacia la otra por el borde
+        float moved = fabsf(q[0].current[0] - (min[0] + 0.03f));
+        moved = fminf(moved, period - moved);
+        snprintf(detail, sizeof(detail), "edge across the boundary %g long (rest 0.05), end moved %g",
+                 gap, moved);
+        report(ok && fabsf(gap - 0.05f) < 1e-3f && moved < 0.01f, "constraints", "periodic", -1,
+               detail);
+        particle_sim_destroy(sim);
+    }
+}
+
+// Un cluster girado y movido tiene que dar la rotación exacta; uno
+// deformado al azar, volver a su forma en una pasada; y los granos en una
+// caja, lo mismo con hilos que sin ellos.
+static void verify_shapes(const Config* base, int steps) {
+    char detail[128];
+    const int side = 3, n = side * side * side;
+    Particles body[27];
+    int indices[27];
+    for (int k = 0; k < n; k++) {
+        body[k].current[0] = 0.01f * (k % side);
+        body[k].current[1] = 0.012f * (k / side % side);
+        body[k].current[2] = 0.014f * (k / (side * side));
+        glm_vec3_copy(body[k].current, body[k].previus);
+        body[k].radius = 0.004f + 0.001f * (k % 4);
+        indices[k] = k;
+    }
+    ShapeSet set;
+    memset(&set, 0, sizeof(set));
+    int ok = shape_add(&set, body, n, indices, n, 1.0f, 0.0f) == 0;
+
+    // 150 grados alrededor de (1, 2, 3) y un desplazamiento
+    float angle = glm_rad(150.0f);
+    vec3 axis = { 1.0f, 2.0f, 3.0f };
+    glm_vec3_normalize(axis);
+    float cs = cosf(angle), sn = sinf(angle);
+    for (int k = 0; k < n; k++) {
+        // Rodrigues: v cos + (eje × v) sen + eje (eje · v)(1 - cos)
+        float* v = body[k].current;
+        float along = glm_vec3_dot(axis, v) * (1.0f - cs);
+        vec3 turned = {
+            v[0] * cs + (axis[1] * v[2] - axis[2] * v[1]) * sn + axis[0] * along + 0.3f,
+            v[1] * cs + (axis[2] * v[0] - axis[0] * v[2]) * sn + axis[1] * along - 0.2f,
+            v[2] * cs + (axis[0] * v[1] - axis[1] * v[0]) * sn + axis[2] * along + 0.1f,
+        };
+        glm_vec3_copy(turned, v);
+    }
+    shape_solve(&set, body, NULL);
+    float s = sinf(0.5f * angle);
+    const float* q = set.rotation[0];
+    float align = fabsf(q[0] * axis[0] * s + q[1] * axis[1] * s + q[2] * axis[2] * s +
+                        q[3] * cosf(0.5f * angle));
+    float error = shape_max_error(&set, body);
+    snprintf(detail, sizeof(detail), "rotation off by %g, error %g", 1.0f - align, error);
+    report(ok && align > 0.9999f && error < 1e-5f, "shapes", "rotated", -1, detail);
+
+    for (int k = 0; k < n; k++)
+        for (int a = 0; a < 3; a++) body[k].current[a] += random_range(-0.003f, 0.003f);
+    shape_solve(&set, body, NULL);
+    error = shape_max_error(&set, body);
+    snprintf(detail, sizeof(detail), "error %g after one pass", error);
+    report(error < 1e-5f, "shapes", "perturbed", -1, detail);
+    shape_free(&set);
+
+    Config cfg = *base;
+    cfg.ENV_TYPE = ENV_BOX;
+    cfg.ENV_SIZE = 1.0f;
+    cfg.PARTICLE_RADIUS = 0.01f;
+    cfg.PROXY_FRAMES = 0;
+    cfg.MULTIRATE_LEVELS = 1;
+    cfg.EVENT_DRIVEN = 0;
+    const int grains = 600;
+    float r = cfg.PARTICLE_RADIUS;
+    vec3 grain[4] = { { r, r, r }, { r, -r, -r }, { -r, r, -r }, { -r, -r, r } };
+    Particles* result[2] = { NULL, NULL };
+    float worst = 0.0f;
+    for (int run = 0; run < 2; run++) {
+        cfg.TASK_THREADS = run ? 3 : 0;
+        ParticleSim* sim = particle_sim_create(&cfg, 4 * grains);
+        if (!sim) break;
+        ok = 1;
+        for (int g = 0; g < grains && ok; g++) {
+            vec3 at = { -0.8f + 0.08f * (g % 20), 0.5f + 0.08f * (g / 400),
+                        -0.8f + 0.08f * (g / 20 % 20) };
+            ok = particle_sim_add_body(sim, grain, NULL, 4, at, 1.0f, 0.0f) >= 0;
+        }
+        // la corrida con hilos además rebobina a cero y vuelve, como el
+        // historial: los granos tienen que seguir siendo rígidos
+        if (run) {
+            particle_sim_set_count(sim, 0);
+            particle_sim_set_count(sim, 4 * grains);
+        }
+        for (int k = 0; k < steps && ok; k++) particle_sim_step(sim, 1.0f / 60.0f);
+        result[run] = ok ? malloc(4 * grains * sizeof(Particles)) : NULL;
+        if (result[run]) memcpy(result[run], particle_sim_particles(sim), 4 * grains * sizeof(Particles));
+        particle_sim_destroy(sim);
+    }
+    if (result[0] && result[1]) {
+        // la forma se mide entre pares del mismo grano: la distancia de
+        // reposo es 2√2 r
+        for (int g = 0; g < grains; g++)
+            for (int a = 0; a < 4; a++)
+                for (int b = a + 1; b < 4; b++) {
+                    float d = glm_vec3_distance(result[0][4 * g + a].current,
+                                                result[0][4 * g + b].current);
+                    worst = fmaxf(worst, fabsf(d - 2.0f * sqrtf(2.0f) * r) / r);
+                }
+        float diff = max_difference(result[0], result[1], 4 * grains);
+        snprintf(detail, sizeof(detail), "threads and a rewind changed the grains by %g, strain %g",
+                 diff, worst);
+        report(diff == 0.0f && worst < 1e-3f, "shapes", "grains", -1, detail);
+    }
+    free(result[0]);
+    free(result[1]);
+}
+
+// Con proxies, el estado para el historial tiene que traer de vuelta todas
+// las partículas con su masa; cargarlo deja la simulación sin proxies
+static void verify_proxies(const Config* base) {
+    char detail[128];
+    Config cfg = *base;
+    cfg.ENV_TYPE = ENV_BOX;
+    cfg.ENV_SIZE = 1.0f;
+    cfg.PARTICLE_RADIUS = 0.05f;
+    cfg.PROXY_FRAMES = 10;
+    cfg.MULTIRATE_LEVELS = 1;
+    cfg.EVENT_DRIVEN = 0;
+    const int spawned = 1500;
+    ParticleSim* sim = particle_sim_create(&cfg, 2 * spawned);
+    if (!sim) return;
+    particle_sim_spawn(sim, spawned);
+    double mass = 0.0, restored = 0.0;
+    const Particles* p = particle_sim_particles(sim);
+    for (int i = 0; i < spawned; i++) mass += pow(p[i].radius, 3.0);
+    for (int k = 0; k < 200; k++) particle_sim_step(sim, 1.0f / 60.0f);
+    int proxies = particle_sim_proxy_count(sim);
+    int n;
+    const Particles* state = particle_sim_snapshot(sim, &n);
+    for (int i = 0; i < n; i++) restored += pow(state[i].radius, 3.0);
+    memmove(particle_sim_particles(sim), state, n * sizeof(Particles));
+    particle_sim_set_count(sim, n);
+    snprintf(detail, sizeof(detail), "%d proxies, snapshot of %d particles, mass %g vs %g",
+             proxies, n, restored, mass);
+    report(proxies > 0 && n == spawned && fabs(restored - mass) < 1e-6 * mass &&
+           particle_sim_count(sim) == spawned, "proxies", "snapshot", -1, detail);
+    particle_sim_destroy(sim);
+}
+
+// Ensamble repartido en procesos: igual que avanzar todo en este
+static void verify_ensemble(const Config* base, int steps) {
+    char detail[128];
+    Ensemble ens[2];
+    int ok = 1;
+    for (int run = 0; run < 2; run++) {
+        ensemble_init(&ens[run]);
+        srand(99);
+        for (int k = 0; k < 5; k++) {
+            Config cfg = *base;
+            cfg.PARTICLE_RADIUS = 0.08f + 0.02f * k;
+            cfg.RESTITUTION = 0.2f * (k + 1);
+            cfg.ENV_TYPE = k % 2 ? ENV_SPHERE : ENV_BOX;
+            cfg.MULTIRATE_LEVELS = 1;
+            ok &= ensemble_add(&ens[run], &cfg, 300 + 100 * k) >= 0;
+        }
+        ok &= ensemble_run(&ens[run], 1.0f / 60.0f, steps, run ? 3 : 1);
+    }
+    ok &= ens[0].used == ens[1].used;
+    float diff = ok ? max_difference(ens[0].particles, ens[1].particles, ens[0].used) : -1.0f;
+    snprintf(detail, sizeof(detail), "3 processes changed the instances by %g", diff);
+    report(ok && diff == 0.0f, "ensemble", "processes", -1, detail);
+    ensemble_free(&ens[0]);
+    ensemble_free(&ens[1]);
+}
+
+// Barnes-Hut contra la suma directa: con theta 0 tiene que ser la misma
+// suma, con 0.5 un error chico; con hilos, lo mismo bit a bit. Después una
+// nube fría en la simulación tiene que contraerse sin que se mueva su
+// centro.
+static double gravity_error(const Particles* p, int count, const vec3* acc, int stride,
+                            float G, float soft2, float unit) {
+    double err = 0.0, norm = 0.0;
+    for (int i = 0; i < count; i += stride) {
+        double ref[3] = { 0.0, 0.0, 0.0 };
+        for (int j = 0; j < count; j++) {
+            double d[3], d2 = soft2;
+            for (int c = 0; c < 3; c++) {
+                d[c] = p[j].current[c] - p[i].current[c];
+                d2 += d[c] * d[c];
+            }
+            double m = pow(p[j].radius / unit, 3.0);
+            for (int c = 0; c < 3 && d2 > 0.0; c++) ref[c] += G * m * d[c] / (d2 * sqrt(d2));
+        }
+        for (int c = 0; c < 3; c++) {
+            err += (acc[i][c] - ref[c]) * (acc[i][c] - ref[c]);
+            norm += ref[c] * ref[c];
+        }
+    }
+    if (!isfinite(err)) return INFINITY;
+    return norm > 0.0 ? sqrt(err / norm) : 0.0;
+}
+
+static void verify_gravity(const Config* base, int steps) {
+    char detail[128];
+    Config cfg = *base;
+    cfg.PARTICLE_RADIUS = 0.01f;
+    cfg.GRAVITY_G = 1.0f;
+    cfg.GRAVITY_SOFTENING = 2.0f;
+    const float soft2 = 4.0f * cfg.PARTICLE_RADIUS * cfg.PARTICLE_RADIUS;
+    // una bola con un grumo denso y radios distintos
+    const int count = 40000, small = 3000;
+    Particles* p = malloc(count * sizeof(Particles));
+    vec3* acc = malloc(count * sizeof(vec3));
+    vec3* threaded = malloc(count * sizeof(vec3));
+    TaskPool* pool = task_pool_create(3);
+    GravityTree tree;
+    memset(&tree, 0, sizeof(tree));
+    if (!p || !acc || !threaded || !pool) {
+        fprintf(stderr, "Failed to alloc gravity check\n");
+        free(p);
+        free(acc);
+        free(threaded);
+        task_pool_destroy(pool);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        float d2;
+        do {
+            for (int c = 0; c < 3; c++) p[i].current[c] = random_range(-1.0f, 1.0f);
+            d2 = glm_vec3_dot(p[i].current, p[i].current);
+        } while (d2 > 1.0f);
+        if (i % 3 == 0) glm_vec3_scale(p[i].current, 0.1f, p[i].current);
+        glm_vec3_copy(p[i].current, p[i].previus);
+        p[i].radius = cfg.PARTICLE_RADIUS * (1.0f + 0.25f * (i % 4));
+    }
+
+    cfg.GRAVITY_THETA = 0.0f;
+    int ok = gravity_compute(&tree, &cfg, p, small, acc, NULL);
+    double direct = gravity_error(p, small, acc, 1, cfg.GRAVITY_G, soft2, cfg.PARTICLE_RADIUS);
+    snprintf(detail, sizeof(detail), "relative error %g with theta 0", direct);
+    report(ok && direct < 1e-4, "gravity", "direct", -1, detail);
+
+    // Sin suavizado, con una partícula repetida: la propia y la que
+    // coincide no aportan, en vez de llenar todo de NaN
+    cfg.GRAVITY_SOFTENING = 0.0f;
+    glm_vec3_copy(p[1].current, p[0].current);
+    ok = gravity_compute(&tree, &cfg, p, small, acc, NULL);
+    direct = gravity_error(p, small, acc, 1, cfg.GRAVITY_G, 0.0f, cfg.PARTICLE_RADIUS);
+    snprintf(detail, sizeof(detail), "relative error %g with softening 0", direct);
+    report(ok && direct < 1e-3, "gravity", "unsoftened", -1, detail);
+    glm_vec3_copy(p[0].previus, p[0].current);
+    cfg.GRAVITY_SOFTENING = 2.0f;
+
+    cfg.GRAVITY_THETA = 0.5f;
+    ok = gravity_compute(&tree, &cfg, p, count, acc, NULL) &&
+         gravity_compute(&tree, &cfg, p, count, threaded, pool);
+    double tree_error = gravity_error(p, count, acc, 97, cfg.GRAVITY_G, soft2, cfg.PARTICLE_RADIUS);
+    snprintf(detail, sizeof(detail), "relative error %g with theta 0.5, threads %s", tree_error,
+             memcmp(acc, threaded, count * sizeof(vec3)) ? "differ" : "match");
+    report(ok && tree_error < 1e-2 && memcmp(acc, threaded, count * sizeof(vec3)) == 0,
+           "gravity", "tree", -1, detail);
+    gravity_free(&tree);
+    task_pool_destroy(pool);
+    free(acc);
+    free(threaded);
+
+    // Nube fría de radio 1: con G = 3π / (32 ρ) colapsaría en un segundo
+    // (√2 con el ½ a dt² de update_physics); en medio segundo se achica
+    cfg.ENV_TYPE = ENV_SPHERE;
+    cfg.ENV_SIZE = 4.0f;
+    cfg.ACCELERATION[0] = cfg.ACCELERATION[1] = cfg.ACCELERATION[2] = 0.0f;
+    cfg.PROXY_FRAMES = 0;
+    cfg.MULTIRATE_LEVELS = 1;
+    cfg.EVENT_DRIVEN = 0;
+    cfg.TASK_THREADS = 0;
+    const int cloud = 4000;
+    double mass = 0.0;
+    for (int i = 0; i < cloud; i++) mass += pow(p[i].radius / cfg.PARTICLE_RADIUS, 3.0);
+    cfg.GRAVITY_G = (float)(3.0 * GLM_PI / (32.0 * mass / (4.0 / 3.0 * GLM_PI)));
+    ParticleSim* sim = particle_sim_create(&cfg, cloud);
+    if (sim) {
+        Particles* q = particle_sim_particles(sim);
+        for (int i = 0; i < cloud; i++) {
+            q[i] = p[i];
+            if (i % 3 == 0) glm_vec3_scale(q[i].current, 10.0f, q[i].current);
+            glm_vec3_copy(q[i].current, q[i].previus);
+        }
+        particle_sim_set_count(sim, cloud);
+        // La gravedad conserva el centro de masa (pesos r³), no el promedio
+        // de posiciones
+        double before = 0.0, after = 0.0;
+        vec3 center = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < cloud; i++) {
+            float w = (float)(pow(q[i].radius / cfg.PARTICLE_RADIUS, 3.0) / mass);
+            before += glm_vec3_norm2(q[i].current);
+            glm_vec3_muladds(q[i].current, -w, center);
+        }
+        for (int s = 0; s < steps / 2; s++) particle_sim_step(sim, 1.0f / 60.0f);
+        for (int i = 0; i < cloud; i++) {
+            float w = (float)(pow(q[i].radius / cfg.PARTICLE_RADIUS, 3.0) / mass);
+            after += glm_vec3_norm2(q[i].current);
+            glm_vec3_muladds(q[i].current, w, center);
+        }
+        snprintf(detail, sizeof(detail), "rms radius %g -> %g, center drifted %g",
+                 sqrt(before / cloud), sqrt(after / cloud), glm_vec3_norm(center));
+        report(after < 0.9 * before && glm_vec3_norm(center) < 1e-3f, "gravity", "collapse", -1, detail);
+        particle_sim_destroy(sim);
+    }
+    free(p);
+}
+
+int physics_verify(const Config* base, int scenes, int steps, unsigned int seed) {
+    const PhysicsKernels* selected = physicsKernels;
+    TaskPool* pool = task_pool_create(3);
+    failures = 0;
+    checks = 0;
+    srand(seed);
+    printf("Verifying %d kernel variants on %d scenes (%d deterministic steps)\n",
+           physics_kernels_count(), scenes, steps);
+
+    for (int s = 0; s < scenes; s++) {
+        Config cfg = *base;
+        Particles* scene = NULL;
+        int count = make_scene(&cfg, &scene, s);
+        Particles* a = malloc(count * sizeof(Particles));
+        Particles* b = malloc(count * sizeof(Particles));
+        if (count <= 0 || !a || !b) {
+            fprintf(stderr, "Failed to alloc verify scene\n");
+            free(scene);
+            free(a);
+            free(b);
+            task_pool_destroy(pool);
+            return failures + 1;
+        }
+        printf("scene %d: %s, %d particles, radius %.3f\n",
+               s, env_get(cfg.ENV_TYPE)->name, count, cfg.PARTICLE_RADIUS);
+
+        for (int v = 0; v < physics_kernels_count(); v++) {
+            physicsKernels = physics_kernels_get(v);
+            verify_kernels(&cfg, scene, count, physicsKernels, s, a, b);
+            verify_step(&cfg, scene, count, s, physicsKernels->name, a, b);
+        }
+        verify_deterministic(&cfg, scene, count, s, steps, a, b);
+        verify_compact(&cfg, scene, count, s, steps, a, b);
+        if (pool) verify_tasks(&cfg, scene, count, s, steps, pool, a, b);
+        if (pool) verify_queries(&cfg, scene, count, s, pool, a);
+        verify_sweep(&cfg, scene, count, s, a, b);
+        Config tiled = cfg;
+        tiled.SOLVER_TILE = 4;
+        verify_step(&tiled, scene, count, s, "tiled", a, b);
+        free(scene);
+        free(a);
+        free(b);
+    }
+
+    physicsKernels = selected;
+    if (pool) verify_sweep_sort(pool);
+    task_pool_destroy(pool);
+    verify_raycast_large(base);
+    verify_planar(base, steps);
+    verify_constraints(base, steps);
+    verify_shapes(base, steps);
+    verify_gravity(base, steps);
+    verify_ensemble(base, steps);
+    verify_proxies(base);
+    printf("%d/%d checks passed\n", checks - failures, checks);
+    return failures;
+}
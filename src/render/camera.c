@@ -85,3 +85,12 @@ void camera_process_scroll(Camera* camera, float yoffset) {
     if (camera->Zoom > 45.0f) camera->Zoom = 45.0f;
 }
 
+
+void camera_screen_ray(Camera* camera, float ndcX, float ndcY, float aspect, vec3 origin, vec3 dir) {
+    float tanHalf = tanf(glm_rad(camera->Zoom) * 0.5f);
+    glm_vec3_copy(camera->Position, origin);
+    glm_vec3_copy(camera->Front, dir);
+    glm_vec3_muladds(camera->Right, ndcX * tanHalf * aspect, dir);
+    glm_vec3_muladds(camera->Up,    ndcY * tanHalf, dir);
+    glm_vec3_normalize(dir);
+}
@@ -30,19 +30,29 @@ void render_env(GLFWwindow* window, GLuint *shaderProgram, Camera* camera, Confi
     glUniform3f(glGetUniformLocation(*shaderProgram, "overrideColor"), 1.0f, 1.0f, 1.0f); // Blanco, por ejemplo
     glUniform1f(glGetUniformLocation(*shaderProgram, "pointSize"), 10.0f);
 
-    switch (config->ENV_TYPE) {
-        case ENV_BOX:
-            glBindVertexArray(envBoxVAO);
-            glDrawArrays(GL_POINTS, 0, pointCount);
-            break;
-        case ENV_SPHERE:
-            glBindVertexArray(envSphereVAO);
-            glDrawArrays(GL_POINTS, 0, spherePointCount);
-            break;
-    }
+    const EnvInterface* env = env_get(config->ENV_TYPE);
+    if (env && env->render) env->render(config);
     glBindVertexArray(0);
 }
 
+static void draw_box(const Config* config) {
+    (void)config;
+    glBindVertexArray(envBoxVAO);
+    glDrawArrays(GL_POINTS, 0, pointCount);
+}
+
+static void draw_sphere(const Config* config) {
+    (void)config;
+    glBindVertexArray(envSphereVAO);
+    glDrawArrays(GL_POINTS, 0, spherePointCount);
+}
+
+void init_env_renderers(void) {
+    env_set_render(ENV_BOX,      init_box_environment,   draw_box);
+    env_set_render(ENV_SPHERE,   init_sphere_enviroment, draw_sphere);
+    env_set_render(ENV_PERIODIC, init_box_environment,   draw_box);
+}
+
 
 void init_box_environment(const Config* config) {
     // número total de puntos: 12 aristas * divisiones
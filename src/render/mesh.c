@@ -134,4 +134,35 @@ Mesh mesh_generate_sphere(int latDiv, int lonDiv) {
     return m;
 }
 
+Mesh mesh_generate_disc(int segments) {
+    Mesh m = {0};
 
+    const float PI = 3.1415926f;
+    m.vertexCount = segments + 1;
+    m.indexCount = segments * 3;
+    m.vertices = malloc(sizeof(float) * 5 * m.vertexCount);
+    m.indices  = malloc(sizeof(unsigned int) * m.indexCount);
+
+    // centro
+    float* v = m.vertices;
+    v[0] = 0.0f; v[1] = 0.0f; v[2] = 1.0f; v[3] = 0.5f; v[4] = 0.5f;
+    for (int s = 0; s < segments; ++s) {
+        float theta = 2.0f * PI * s / segments;
+        v = m.vertices + 5 * (s + 1);
+        v[0] = cosf(theta);
+        v[1] = sinf(theta);
+        v[2] = 0.0f;
+        v[3] = 0.5f + 0.5f * v[0];
+        v[4] = 0.5f + 0.5f * v[1];
+    }
+    // abanico en sentido antihorario visto desde +z
+    for (int s = 0; s < segments; ++s) {
+        m.indices[3 * s]     = 0;
+        m.indices[3 * s + 1] = s + 1;
+        m.indices[3 * s + 2] = (s + 1) % segments + 1;
+    }
+
+    m.vertexSize = m.vertexCount * 5 * sizeof(float);
+    m.indexSize  = m.indexCount * sizeof(unsigned int);
+    return m;
+}